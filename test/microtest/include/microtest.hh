@@ -167,14 +167,25 @@
 #define SW_MICROTEST_HH
 
 #include <sstream>
+#ifndef WITHOUT_MICROTEST_IOSTREAM
 #include <iostream>
+#endif
 #include <string>
-#include <sstream>
 #include <cmath>
 #include <limits>
 #include <vector>
+#include <iterator>
+#include <algorithm>
 #include <fstream>
 #include <stdexcept>
+#include <exception>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <cerrno>
+#include <csignal>
+#include <chrono>
 #include <type_traits>
 #include <memory>
 #include <atomic>
@@ -182,9 +193,8 @@
 #include <random>
 #if defined(__WINDOWS__) || defined(_WIN32) || defined(__WIN32__) || defined(_WIN64) || defined(__MINGW32__) || defined(__MINGW64__)
   #include <windows.h>
-  #ifdef _MSC_VER
-    #include <io.h>
-  #else
+  #include <io.h>
+  #ifndef _MSC_VER
     #include <sys\stat.h>
   #endif
   #ifndef __WINDOWS__
@@ -199,8 +209,14 @@
 #else
   #include <unistd.h>
   #include <sys/stat.h>
+  #include <sys/uio.h>
   #include <time.h>
 #endif
+#include <unordered_map>
+#ifdef WITH_MICROTEST_ASYNC_LOG
+  #include <thread>
+  #include <condition_variable>
+#endif
 
 //------------------------------------------------------------------------------------------
 // Compiler switches
@@ -220,6 +236,39 @@
   #define MICROTEST_UTEST_OMIT_PASS_LOGS (false)
 #endif
 
+// Maximum number of logged fails per check site, further fails of the site are only
+// counted and summarized (default 0: unlimited, see `test::fail_log_limit()`).
+#if defined(MICROTEST_FAIL_LOG_LIMIT)
+  #define MICROTEST_UTEST_FAIL_LOG_LIMIT (unsigned(MICROTEST_FAIL_LOG_LIMIT))
+#else
+  #define MICROTEST_UTEST_FAIL_LOG_LIMIT (0u)
+#endif
+
+// Strip the pass log formatting code completely, passes are only counted (implies omitted pass logs).
+#if defined(WITHOUT_MICROTEST_PASS_LOG_CODE)
+  #define MICROTEST_UTEST_STRIP_PASS_LOGS (true)
+  #undef MICROTEST_UTEST_OMIT_PASS_LOGS
+  #define MICROTEST_UTEST_OMIT_PASS_LOGS (true)
+#else
+  #define MICROTEST_UTEST_STRIP_PASS_LOGS (false)
+#endif
+
+// Keep rarely executed logging code out of the inlined check paths.
+#if defined(__GNUC__) || defined(__clang__)
+  #define MICROTEST_UTEST_COLD __attribute__((noinline, cold))
+#elif defined(_MSC_VER)
+  #define MICROTEST_UTEST_COLD __declspec(noinline)
+#else
+  #define MICROTEST_UTEST_COLD
+#endif
+
+// Asynchronous logging via per-thread ring buffers and a background writer thread.
+#if defined(WITH_MICROTEST_ASYNC_LOG)
+  #define MICROTEST_UTEST_ASYNC_LOG (true)
+#else
+  #define MICROTEST_UTEST_ASYNC_LOG (false)
+#endif
+
 // Enable generating temp files/directories (auto deleted).
 // @experimental
 #ifndef WITH_MICROTEST_TMPFILE
@@ -235,6 +284,10 @@
 // Further compile time settings (meanings see below in the file):
 // - #define WITH_MICROTEST_MAIN
 // - #define WITH_MICROTEST_GENERATORS
+// - #define WITH_MICROTEST_CASES
+// - #define WITH_MICROTEST_BENCHMARK
+// - #define WITH_MICROTEST_ALLOC_TRACKING
+// - #define WITH_MICROTEST_PERF_COUNTERS
 // - #define WITHOUT_MICROTEST_RANDOM
 
 //------------------------------------------------------------------------------------------
@@ -242,33 +295,53 @@
 // Macros are lower case with the hope that some day these can be actual function templates (->static reflection).
 //------------------------------------------------------------------------------------------
 
+/**
+ * Main source file of the compilation (suite name of the structured reports).
+ */
+#ifdef __BASE_FILE__
+  #define MICROTEST_UTEST_BASE_FILE __BASE_FILE__
+#else
+  #define MICROTEST_UTEST_BASE_FILE __FILE__
+#endif
+
+/**
+ * Static descriptor of the current call site (file, line, check kind, expression
+ * text), constant initialized once per macro invocation. Passed as reference
+ * through the logging path, and its address identifies the check location.
+ * @see ::sw::utest::detail::check_site
+ */
+#define MICROTEST_UTEST_SITE(KIND, EXPR, EXPR_RHS) ([]() noexcept -> const ::sw::utest::detail::check_site& { \
+  static const ::sw::utest::detail::check_site microtest_site_{__FILE__, __LINE__, ::sw::utest::detail::check_kind::KIND, EXPR, EXPR_RHS}; \
+  return microtest_site_; \
+}())
+
 /**
  * Register a failed check with message (arguments implicitly printed space separated).
  * @tparam typename ...Args
  * @return void
  */
-#define test_fail(...) (::sw::utest::test::fail(__FILE__, __LINE__, __VA_ARGS__))
+#define test_fail(...) (::sw::utest::test::fail(MICROTEST_UTEST_SITE(fail, nullptr, nullptr), __VA_ARGS__))
 
 /**
  * Register a passed check with message (arguments implicitly printed space separated).
  * @tparam typename ...Args
  * @return void
  */
-#define test_pass(...) (::sw::utest::test::pass(__FILE__, __LINE__, __VA_ARGS__))
+#define test_pass(...) (::sw::utest::test::pass(MICROTEST_UTEST_SITE(pass, nullptr, nullptr), __VA_ARGS__))
 
 /**
  * Register a check warning (arguments implicitly printed space separated).
  * @tparam typename ...Args
  * @return void
  */
-#define test_warn(...) ::sw::utest::test::warning(__FILE__, __LINE__, __VA_ARGS__)
+#define test_warn(...) ::sw::utest::test::warning(MICROTEST_UTEST_SITE(warn, nullptr, nullptr), __VA_ARGS__)
 
 /**
  * Print information without registering a check (arguments implicitly printed space separated).
  * @tparam typename ...Args
  * @return void
  */
-#define test_info(...) ::sw::utest::test::comment(__FILE__, __LINE__, __VA_ARGS__)
+#define test_info(...) ::sw::utest::test::comment(MICROTEST_UTEST_SITE(note, nullptr, nullptr), __VA_ARGS__)
 
 /**
  * Print information without registering a check (arguments implicitly printed space separated).
@@ -276,7 +349,7 @@
  * @tparam typename ...Args
  * @return void
  */
-#define test_comment(...) ::sw::utest::test::comment(__FILE__, __LINE__, __VA_ARGS__)
+#define test_comment(...) ::sw::utest::test::comment(MICROTEST_UTEST_SITE(note, nullptr, nullptr), __VA_ARGS__)
 
 /**
  * Print information without registering a check (argument stream like).
@@ -284,15 +357,16 @@
  * @tparam typename ...Args
  * @return void
  */
-#define test_note(...) { std::stringstream ss_ss; ss_ss << __VA_ARGS__; ::sw::utest::test::comment(__FILE__, __LINE__, ss_ss.str()); }
+#define test_note(...) { ::sw::utest::detail::record_formatter<> ss_ss; ss_ss.os() << __VA_ARGS__; ::sw::utest::test::comment(MICROTEST_UTEST_SITE(note, nullptr, nullptr), ss_ss.str()); }
 
 /**
  * Initialize the test run, print build context information, and
  * conditionally enable ANSI coloring if allowed (WITH_MICROTEST_ANSI_COLORS
- * defined and the output stream STDOUT is a TTY/console).
+ * defined and the output stream STDOUT is a TTY/console). Applies the
+ * `MICROTEST_REPORTER` environment variable unless a reporter was set.
  * @see `WITH_MICROTEST_MAIN`
  */
-#define test_initialize() { ::sw::utest::test::stream(std::cout); ::sw::utest::test::ansi_colors((MICROTEST_UTEST_ANSI_COLORS) && ::sw::utest::test::istty()); ::sw::utest::test::buildinfo(__FILE__, __LINE__); }
+#define test_initialize() { ::sw::utest::test::default_stream(); ::sw::utest::test::ansi_colors((MICROTEST_UTEST_ANSI_COLORS) && ::sw::utest::test::istty()); ::sw::utest::test::async_log(MICROTEST_UTEST_ASYNC_LOG); ::sw::utest::test::environment_reporter(MICROTEST_UTEST_BASE_FILE); ::sw::utest::test::buildinfo(__FILE__, __LINE__); }
 
 /**
  * Print build context information.
@@ -323,7 +397,7 @@
  * @param BoolExpr...
  * @return bool
  */
-#define test_expect_cond(...) ::sw::utest::test::commit(bool(__VA_ARGS__), __FILE__, __LINE__, #__VA_ARGS__)
+#define test_expect_cond(...) ::sw::utest::test::commit(bool(__VA_ARGS__), MICROTEST_UTEST_SITE(expect, #__VA_ARGS__, nullptr))
 
 /**
  * Checks (register pass/fail) without printing the line
@@ -341,7 +415,7 @@
  * @param BoolExpr...
  * @return bool
  */
-#define test_expect_nocatch(...) ::sw::utest::test::commit(bool(__VA_ARGS__), __FILE__, __LINE__, #__VA_ARGS__)
+#define test_expect_nocatch(...) ::sw::utest::test::commit(bool(__VA_ARGS__), MICROTEST_UTEST_SITE(expect, #__VA_ARGS__, nullptr))
 
 /**
  * Checks (register pass/fail) and print the file+line, as well as the
@@ -350,14 +424,13 @@
  * @return bool
  */
 #define test_expect(...) { \
+  const ::sw::utest::detail::check_site& microtest_site_ = MICROTEST_UTEST_SITE(expect, #__VA_ARGS__, nullptr); \
   try { \
-    (void)test_expect_cond(__VA_ARGS__); \
+    (void)::sw::utest::test::commit(bool(__VA_ARGS__), microtest_site_); \
   } catch(const std::exception& e) { \
-    (::sw::utest::test::fail(__FILE__, __LINE__, std::string( \
-      #__VA_ARGS__ " | Unexpected exception: ") + e.what() )); \
+    (::sw::utest::test::fail(microtest_site_, #__VA_ARGS__ " | Unexpected exception: ", e.what())); \
   } catch(...) { \
-    (::sw::utest::test::fail(__FILE__, __LINE__, std::string( \
-      #__VA_ARGS__ " | Unexpected exception: ") )); \
+    (::sw::utest::test::fail(microtest_site_, #__VA_ARGS__ " | Unexpected exception: ")); \
   } \
 }
 
@@ -368,15 +441,14 @@
  * @return bool
  */
 #define test_expect_silent(...) { \
+  const ::sw::utest::detail::check_site& microtest_site_ = MICROTEST_UTEST_SITE(expect, #__VA_ARGS__, nullptr); \
   try { \
     if(__VA_ARGS__) ::sw::utest::test::pass(); \
-    else ::sw::utest::test::fail(__FILE__, __LINE__, #__VA_ARGS__); \
+    else ::sw::utest::test::fail(microtest_site_, #__VA_ARGS__); \
   } catch(const std::exception& e) { \
-    (::sw::utest::test::fail(__FILE__, __LINE__, std::string( \
-      #__VA_ARGS__ " | Unexpected exception: ") + e.what() )); \
+    (::sw::utest::test::fail(microtest_site_, #__VA_ARGS__ " | Unexpected exception: ", e.what())); \
   } catch(...) { \
-    (::sw::utest::test::fail(__FILE__, __LINE__, std::string( \
-      #__VA_ARGS__ " | Unexpected exception: ") )); \
+    (::sw::utest::test::fail(microtest_site_, #__VA_ARGS__ " | Unexpected exception: ")); \
   } \
 }
 
@@ -390,7 +462,7 @@
  * @param T1&& B
  * @return bool
  */
-#define test_expect_eq(A, B) ::sw::utest::test::check_eq(A, B, __FILE__, __LINE__, #A, #B)
+#define test_expect_eq(A, B) ::sw::utest::test::check_eq(A, B, MICROTEST_UTEST_SITE(eq, #A, #B))
 
 /**
  * Registers a passed check if `A!=B`, a failed check on `!(A!=B)` (operator!=()
@@ -402,7 +474,7 @@
  * @param T1&& B
  * @return bool
  */
-#define test_expect_ne(A, B) ::sw::utest::test::check_ne(A, B, __FILE__, __LINE__, #A, #B)
+#define test_expect_ne(A, B) ::sw::utest::test::check_ne(A, B, MICROTEST_UTEST_SITE(ne, #A, #B))
 
 /**
  * Registers a passed check if `A>B`, a failed check on `!(A>B)` (operator>()
@@ -414,7 +486,7 @@
  * @param T1&& B
  * @return bool
  */
-#define test_expect_gt(A, B) ::sw::utest::test::check_gt(A, B, __FILE__, __LINE__, #A, #B)
+#define test_expect_gt(A, B) ::sw::utest::test::check_gt(A, B, MICROTEST_UTEST_SITE(gt, #A, #B))
 
 /**
  * Registers a passed check if `A<B`, a failed check on `!(A<B)` (operator<()
@@ -426,7 +498,7 @@
  * @param T1&& B
  * @return bool
  */
-#define test_expect_lt(A, B) ::sw::utest::test::check_lt(A, B, __FILE__, __LINE__, #A, #B)
+#define test_expect_lt(A, B) ::sw::utest::test::check_lt(A, B, MICROTEST_UTEST_SITE(lt, #A, #B))
 
 /**
  * Registers a passed check if `A>=B`, a failed check on `!(A>=B)` (operator>=()
@@ -438,7 +510,7 @@
  * @param T1&& B
  * @return bool
  */
-#define test_expect_ge(A, B) ::sw::utest::test::check_ge(A, B, __FILE__, __LINE__, #A, #B)
+#define test_expect_ge(A, B) ::sw::utest::test::check_ge(A, B, MICROTEST_UTEST_SITE(ge, #A, #B))
 
 /**
  * Registers a passed check if `A<=B`, a failed check on `!(A<=B)` (operator<=()
@@ -450,7 +522,7 @@
  * @param T1&& B
  * @return bool
  */
-#define test_expect_le(A, B) ::sw::utest::test::check_le(A, B, __FILE__, __LINE__, #A, #B)
+#define test_expect_le(A, B) ::sw::utest::test::check_le(A, B, MICROTEST_UTEST_SITE(le, #A, #B))
 
 /**
  * Registers a passed check if the given expression throws,
@@ -460,15 +532,14 @@
  * @return void
  */
 #define test_expect_except(...) { \
+  const ::sw::utest::detail::check_site& microtest_site_ = MICROTEST_UTEST_SITE(except, #__VA_ARGS__, nullptr); \
   try { \
     (void)(__VA_ARGS__); \
-    (::sw::utest::test::fail(__FILE__, __LINE__, #__VA_ARGS__, " | Exception was expected" )); \
+    (::sw::utest::test::fail(microtest_site_, #__VA_ARGS__, " | Exception was expected" )); \
   } catch(const std::exception& e) { \
-    (::sw::utest::test::pass(__FILE__, __LINE__, std::string( \
-      #__VA_ARGS__ " | Expected exception: ") + e.what() )); \
+    (::sw::utest::test::pass(microtest_site_, #__VA_ARGS__ " | Expected exception: ", e.what())); \
   } catch(...) { \
-    (::sw::utest::test::pass(__FILE__, __LINE__, std::string( \
-      #__VA_ARGS__ " | Expected exception") )); \
+    (::sw::utest::test::pass(microtest_site_, #__VA_ARGS__ " | Expected exception")); \
   } \
 }
 
@@ -480,15 +551,14 @@
  * @return void
  */
 #define test_expect_noexcept(...) { \
+  const ::sw::utest::detail::check_site& microtest_site_ = MICROTEST_UTEST_SITE(nothrow, #__VA_ARGS__, nullptr); \
   try { \
     (void)(__VA_ARGS__); \
-    (::sw::utest::test::pass(__FILE__, __LINE__, #__VA_ARGS__)); \
+    (::sw::utest::test::pass(microtest_site_, #__VA_ARGS__)); \
   } catch(const std::exception& e) { \
-    (::sw::utest::test::fail(__FILE__, __LINE__, std::string( \
-      #__VA_ARGS__ " | Unexpected exception: ") + e.what() )); \
+    (::sw::utest::test::fail(microtest_site_, #__VA_ARGS__ " | Unexpected exception: ", e.what())); \
   } catch(...) { \
-    (::sw::utest::test::fail(__FILE__, __LINE__, std::string( \
-      #__VA_ARGS__ " | Unexpected exception") )); \
+    (::sw::utest::test::fail(microtest_site_, #__VA_ARGS__ " | Unexpected exception")); \
   } \
 }
 
@@ -503,17 +573,18 @@
  * @return void
  */
 #define test_expect_diff_in_tolerance(ARG, TOL) { \
+  const ::sw::utest::detail::check_site& microtest_site_ = MICROTEST_UTEST_SITE(expect, #ARG, #TOL); \
   try { \
     const auto r = std::abs(ARG); \
     if((r < (TOL))  && (r > (-(TOL)))) { \
-      ::sw::utest::test::pass(__FILE__, __LINE__, std::string("In tolerance abs(" #ARG "), ") + std::to_string(r) + " < " + std::to_string(TOL) ); \
+      ::sw::utest::test::pass(microtest_site_, "In tolerance abs(" #ARG "), ", std::fixed, r, " < ", (TOL)); \
     } else { \
-      ::sw::utest::test::fail(__FILE__, __LINE__, std::string("In tolerance abs(" #ARG "), ") + std::to_string(r) + " >=" + std::to_string(TOL) ); \
+      ::sw::utest::test::fail(microtest_site_, "In tolerance abs(" #ARG "), ", std::fixed, r, " >=", (TOL)); \
     } \
   } catch(const std::exception& e) { \
-    (::sw::utest::test::fail(__FILE__, __LINE__, std::string( #ARG "-> Unexpected exception: ") + e.what()) ); \
+    (::sw::utest::test::fail(microtest_site_, #ARG "-> Unexpected exception: ", e.what())); \
   } catch(...) { \
-    (::sw::utest::test::fail(__FILE__, __LINE__, std::string( #ARG " | Unexpected exception") )); \
+    (::sw::utest::test::fail(microtest_site_, #ARG " | Unexpected exception")); \
   } \
 } \
 
@@ -532,6 +603,53 @@
   #define test_random ::sw::utest::random
 #endif
 
+/**
+ * Fills existing storage with random values (uniform distribution), generated
+ * in blocks. Value range defaults as for `test_random`.
+ * - random_fill(v.begin(), v.end(), -1.0, 1.0) : iterator range, doubles between -1 and 1.
+ * - random_fill(v.data(), v.data()+n)          : pointer range, full value range of the type.
+ * - random_fill(v, 0, 100)                     : complete container/array/span.
+ */
+#ifndef WITHOUT_MICROTEST_RANDOM
+  #define test_random_fill ::sw::utest::random_fill
+#endif
+
+/**
+ * Defines and registers a named test case (opt-in `WITH_MICROTEST_CASES`), e.g.
+ * `test_case("parse empty") { test_expect(parse("").empty()); }`.
+ * With `WITH_MICROTEST_MAIN`, the cases are run after `test()`. Only the
+ * checks of the thread running the case are attributed to the case, checks
+ * in threads started by the case count only in the totals.
+ * @param const char* NAME
+ */
+#define MICROTEST_UTEST_CAT2(A, B) A##B
+#define MICROTEST_UTEST_CAT(A, B) MICROTEST_UTEST_CAT2(A, B)
+#ifdef WITH_MICROTEST_CASES
+  #define test_case(NAME) MICROTEST_UTEST_CASE(NAME, MICROTEST_UTEST_CAT(microtest_case_, __COUNTER__))
+  #define MICROTEST_UTEST_CASE(NAME, FN) \
+    static void FN(); \
+    static const ::sw::utest::detail::test_cases<>::registration MICROTEST_UTEST_CAT(FN, _registration_)(NAME, __FILE__, __LINE__, &FN); \
+    static void FN()
+#else
+  #define test_case(NAME) static_assert(false, "test_case() requires WITH_MICROTEST_CASES"); static void MICROTEST_UTEST_CAT(microtest_case_, __COUNTER__)()
+#endif
+
+/**
+ * Timed scope, e.g. `test_section("parse") { test_expect(parse(data)); }`.
+ * Wall time, CPU time, checks, and fails of the current thread are
+ * accumulated per section (and enclosing sections), the slowest sections
+ * are listed by `summary()`. With `WITH_MICROTEST_PERF_COUNTERS`, also the
+ * performance counters of the thread (opened per section run). The body
+ * runs once, `break` or `continue` in it leave the section.
+ * @param const char* NAME
+ */
+#ifndef WITH_MICROTEST_PERF_COUNTERS
+  #define test_section(NAME) for(::sw::utest::detail::section_scope<>&& MICROTEST_UTEST_CAT(microtest_section_, __LINE__) = ::sw::utest::detail::section_scope<>(MICROTEST_UTEST_SITE(info, nullptr, nullptr), NAME); MICROTEST_UTEST_CAT(microtest_section_, __LINE__).once(); )
+#else
+  #define test_section(NAME) for(::sw::utest::detail::section_scope<>&& MICROTEST_UTEST_CAT(microtest_section_, __LINE__) = ::sw::utest::detail::section_scope<>(MICROTEST_UTEST_SITE(info, nullptr, nullptr), NAME); MICROTEST_UTEST_CAT(microtest_section_, __LINE__).once(); ) \
+    for(::sw::utest::detail::section_perf<>&& MICROTEST_UTEST_CAT(microtest_section_perf_, __LINE__) = ::sw::utest::detail::section_perf<>(MICROTEST_UTEST_CAT(microtest_section_, __LINE__)); MICROTEST_UTEST_CAT(microtest_section_perf_, __LINE__).once(); )
+#endif
+
 //------------------------------------------------------------------------------------------
 // Detail
 //------------------------------------------------------------------------------------------
@@ -551,7 +669,7 @@ namespace sw { namespace utest {
    * @return FloatingPoint
    */
   template <typename FloatingPoint, typename AccuracyType>
-  static inline FloatingPoint round(const FloatingPoint floating_point_value, AccuracyType accuracy)
+  inline FloatingPoint round(const FloatingPoint floating_point_value, AccuracyType accuracy)
   {
     static_assert(std::is_floating_point<FloatingPoint>::value, "Rounding only for floating point values");
     static_assert(std::is_floating_point<AccuracyType>::value, "Accuracy type must be floating point, to prevent interpreting it as 'number of digits'.");
@@ -567,7 +685,7 @@ namespace sw { namespace utest {
    * @return std::string
    */
   template <typename FloatingPoint>
-  static inline std::string to_string(const FloatingPoint val, size_t precision_digits)
+  inline std::string to_string(const FloatingPoint val, size_t precision_digits)
   {
     auto ss = std::stringstream(); // --> std::format(). For compat still iostream.
     ss.precision(std::streamsize(precision_digits));
@@ -584,6 +702,96 @@ namespace sw { namespace utest {
 
   namespace detail {
 
+    /**
+     * Run seed of the random generators. Initialized once from the
+     * environment variable `MICROTEST_SEED` (if set), otherwise from
+     * `std::random_device`. Explicitly setting the seed increments
+     * the generation, so that the thread local engines re-seed.
+     */
+    template <typename=void>
+    class random_seed
+    {
+    public:
+
+      /**
+       * Returns the seed of this run.
+       * @return std::uint64_t
+       */
+      static std::uint64_t get() noexcept
+      {
+        if(!initialized_.load(std::memory_order_acquire)) {
+          std::lock_guard<std::mutex> lck(lock_);
+          if(!initialized_.load(std::memory_order_relaxed)) {
+            seed_.store(initial(), std::memory_order_relaxed);
+            initialized_.store(true, std::memory_order_release);
+          }
+        }
+        return seed_.load(std::memory_order_relaxed);
+      }
+
+      /**
+       * Sets the seed, all engines re-seed on their next use.
+       * @param std::uint64_t seed
+       */
+      static void set(std::uint64_t seed) noexcept
+      {
+        std::lock_guard<std::mutex> lck(lock_);
+        seed_.store(seed, std::memory_order_relaxed);
+        initialized_.store(true, std::memory_order_release);
+        generation_.fetch_add(1, std::memory_order_acq_rel);
+      }
+
+      /**
+       * Returns the number of explicit seed changes.
+       * @return std::uint64_t
+       */
+      static std::uint64_t generation() noexcept
+      { return generation_.load(std::memory_order_acquire); }
+
+      /**
+       * Parses a decimal or hex (0x...) seed text, returns false
+       * if the text is empty or invalid.
+       * @param const char* text
+       * @param std::uint64_t& seed
+       * @return bool
+       */
+      static bool parse(const char* text, std::uint64_t& seed) noexcept
+      {
+        if(!text || !*text || (*text == '-')) return false;
+        char* end = nullptr;
+        errno = 0;
+        const unsigned long long value = std::strtoull(text, &end, 0);
+        if(errno || (!end) || (*end)) return false;
+        seed = std::uint64_t(value);
+        return true;
+      }
+
+    private:
+
+      static std::uint64_t initial() noexcept
+      {
+        auto seed = std::uint64_t();
+        if(parse(std::getenv("MICROTEST_SEED"), seed)) return seed;
+        try {
+          std::random_device rd;
+          seed = (std::uint64_t(rd()) << 32) ^ std::uint64_t(rd());
+        } catch(...) {
+          seed = std::uint64_t(std::chrono::high_resolution_clock::now().time_since_epoch().count());
+        }
+        return seed;
+      }
+
+      static std::mutex lock_;
+      static std::atomic<bool> initialized_;
+      static std::atomic<std::uint64_t> seed_;
+      static std::atomic<std::uint64_t> generation_;
+    };
+
+    template <typename T> std::mutex random_seed<T>::lock_;
+    template <typename T> std::atomic<bool> random_seed<T>::initialized_(false);
+    template <typename T> std::atomic<std::uint64_t> random_seed<T>::seed_(0);
+    template <typename T> std::atomic<std::uint64_t> random_seed<T>::generation_(0);
+
     template <typename=void>
     struct buildinfo
     {
@@ -600,6 +808,9 @@ namespace sw { namespace utest {
           // SCM_COMMIT:=$(shell git log --pretty=format:%h -1 2>/dev/null || echo 0000000)
           ss << ", scm=" << (SCM_COMMIT);
         #endif
+        #ifndef WITHOUT_MICROTEST_RANDOM
+          ss << ", seed=" << random_seed<>::get();
+        #endif
         return ss.str();
       }
 
@@ -710,495 +921,4249 @@ namespace sw { namespace utest {
 
   namespace detail {
 
+    /**
+     * Kind of a check or log call site.
+     */
+    enum class check_kind : unsigned char { expect=0, eq, ne, gt, lt, ge, le, except, nothrow, pass, fail, warn, note, info, benchmark, noalloc };
+
+    /**
+     * Static call site descriptor, see `MICROTEST_UTEST_SITE()`.
+     * `expr` is the stringified expression (or left operand of
+     * comparisons), `expr_rhs` the right operand of comparisons.
+     * Both can be `nullptr`.
+     */
+    struct check_site
+    {
+      const char* file;
+      int line;
+      check_kind kind;
+      const char* expr;
+      const char* expr_rhs;
+    };
+
+    /**
+     * Check statistics, sharded per thread. Each thread increments
+     * only its own (cache line padded) shard, which is registered on
+     * first use. Readers fold all shards, as well as the counts of
+     * already terminated threads.
+     */
     template <typename=void>
-    class microtest
+    class check_counters
     {
     public:
 
-      /**
-       * Returns the number of failed checks.
-       * @return unsigned long
-       */
-      static unsigned long num_fails() noexcept
-      { return num_fails_; }
+      struct alignas(64) shard
+      {
+        std::atomic<std::uint64_t> checks;
+        std::atomic<std::uint64_t> fails;
+        std::atomic<std::uint64_t> warns;
+        shard* next;
+        shard* prev;
+      };
 
       /**
-       * Returns the number of warnings.
-       * @return unsigned long
+       * Returns the shard of the current thread.
+       * @return shard&
        */
-      static unsigned long num_warnings() noexcept
-      { return num_warns_; }
+      static shard& local() noexcept
+      { static thread_local registration reg; return reg.s; }
 
       /**
-       * Returns the number of warnings.
-       * @return unsigned long
+       * Increments a counter of the own shard. No atomic
+       * read-modify-write needed, the thread is the only writer.
+       * @param std::atomic<std::uint64_t>& counter
        */
-      static unsigned long num_passed() noexcept
-      { return num_checks_-num_fails_; }
+      static void increment(std::atomic<std::uint64_t>& counter) noexcept
+      { counter.store(counter.load(std::memory_order_relaxed)+1, std::memory_order_relaxed); }
+
+      static void inc_checks() noexcept
+      { increment(local().checks); }
+
+      static void inc_fails() noexcept
+      { shard& s = local(); increment(s.checks); increment(s.fails); }
+
+      static void inc_warns() noexcept
+      { increment(local().warns); }
 
       /**
-       * Returns the number of checks
-       * @return unsigned long
+       * Adds counts determined elsewhere (e.g. in a child process)
+       * to the own shard.
        */
-      static unsigned long num_checks() noexcept
-      { return num_checks_; }
+      static void add(std::uint64_t checks, std::uint64_t fails, std::uint64_t warns) noexcept
+      {
+        shard& s = local();
+        s.checks.store(s.checks.load(std::memory_order_relaxed)+checks, std::memory_order_relaxed);
+        s.fails.store(s.fails.load(std::memory_order_relaxed)+fails, std::memory_order_relaxed);
+        s.warns.store(s.warns.load(std::memory_order_relaxed)+warns, std::memory_order_relaxed);
+      }
 
       /**
-       * Set the output stream for the testing
-       * @param std::ostream& os
+       * Folded statistics of all threads.
        */
-      static void stream(std::ostream& os) noexcept
-      { os_ = &os; }
+      static std::uint64_t checks() noexcept
+      { return fold(&shard::checks, retired_checks_); }
+
+      static std::uint64_t fails() noexcept
+      { return fold(&shard::fails, retired_fails_); }
+
+      static std::uint64_t warns() noexcept
+      { return fold(&shard::warns, retired_warns_); }
 
       /**
-       * Returns true if ANSI color printing is allowed
-       * for TTY STDOUT.
-       * @return bool
+       * Folded statistics without locking, for crash hooks in signal
+       * handlers (best-effort, the shard list may be modified meanwhile).
        */
-      static bool ansi_colors() noexcept
-      { return ansi_colors_; }
+      static void unlocked_totals(std::uint64_t& checks, std::uint64_t& fails, std::uint64_t& warns) noexcept
+      {
+        checks = retired_checks_; fails = retired_fails_; warns = retired_warns_;
+        for(const shard* s=shards_; s; s=s->next) {
+          checks += s->checks.load(std::memory_order_relaxed);
+          fails += s->fails.load(std::memory_order_relaxed);
+          warns += s->warns.load(std::memory_order_relaxed);
+        }
+      }
 
       /**
-       * Sets if ANSI color printing is allowed
-       * for TTY STDOUT.
-       * @param bool enable
+       * Resets all shards. Not intended to be invoked concurrently
+       * with checks in other threads (these counts may be lost or kept).
        */
-      static void ansi_colors(bool enable) noexcept
+      static void reset() noexcept
       {
-        #ifdef WITH_MICROTEST_ANSI_COLORS_FORCED
-          ansi_colors_ = true;
-        #else
-          ansi_colors_ = enable;
-        #endif
-        #ifdef __WINDOWS__
+        std::lock_guard<std::mutex> lck(lock_);
+        retired_checks_ = 0; retired_fails_ = 0; retired_warns_ = 0;
+        for(shard* s=shards_; s; s=s->next) {
+          s->checks.store(0, std::memory_order_relaxed);
+          s->fails.store(0, std::memory_order_relaxed);
+          s->warns.store(0, std::memory_order_relaxed);
+        }
+      }
+
+    private:
+
+      struct registration
+      {
+        shard s;
+
+        registration() noexcept
         {
-          #ifndef ENABLE_VIRTUAL_TERMINAL_PROCESSING
-            #define ENABLE_VIRTUAL_TERMINAL_PROCESSING 0x0004
-          #endif
-          const HANDLE hout = ::GetStdHandle(STD_OUTPUT_HANDLE);
-          DWORD conmode = 0;
-          if(hout && ::GetConsoleMode(hout, &conmode)) {::SetConsoleMode(hout, conmode|ENABLE_VIRTUAL_TERMINAL_PROCESSING);}
+          s.checks = 0; s.fails = 0; s.warns = 0; s.prev = nullptr;
+          std::lock_guard<std::mutex> lck(lock_);
+          s.next = shards_;
+          if(shards_) shards_->prev = &s;
+          shards_ = &s;
         }
-        #endif
+
+        ~registration() noexcept
+        {
+          std::lock_guard<std::mutex> lck(lock_);
+          retired_checks_ += s.checks.load(std::memory_order_relaxed);
+          retired_fails_ += s.fails.load(std::memory_order_relaxed);
+          retired_warns_ += s.warns.load(std::memory_order_relaxed);
+          if(s.prev) s.prev->next = s.next; else shards_ = s.next;
+          if(s.next) s.next->prev = s.prev;
+        }
+      };
+
+      static std::uint64_t fold(std::atomic<std::uint64_t> shard::*counter, const std::uint64_t& retired) noexcept
+      {
+        std::lock_guard<std::mutex> lck(lock_);
+        std::uint64_t n = retired;
+        for(const shard* s=shards_; s; s=s->next) n += (s->*counter).load(std::memory_order_relaxed);
+        return n;
       }
 
-      /**
-       * Register a succeeded expectation, increases test counter, prints message.
-       * @param const std::string& file
-       * @param int line
-       * @param typename ...Args args
-       */
-      template <typename ...Args>
-      static bool pass(const std::string& file, int line, Args&& ...args)
-      { num_checks_++; if(!omit_passes_) osout(osout_pass, file, line, std::forward<Args>(args)...); return true; }
+      static std::mutex lock_;
+      static shard* shards_;
+      static std::uint64_t retired_checks_;
+      static std::uint64_t retired_fails_;
+      static std::uint64_t retired_warns_;
+    };
 
-      /**
-       * Register pass without logging
-       * @return bool
-       */
-      static bool pass() noexcept
-      { num_checks_++; return true; }
+    template <typename T> std::mutex check_counters<T>::lock_;
+    template <typename T> typename check_counters<T>::shard* check_counters<T>::shards_ = nullptr;
+    template <typename T> std::uint64_t check_counters<T>::retired_checks_ = 0;
+    template <typename T> std::uint64_t check_counters<T>::retired_fails_ = 0;
+    template <typename T> std::uint64_t check_counters<T>::retired_warns_ = 0;
 
-      /**
-       * Register a failed expectation, increase test counter and fail counter, prints message
-       * @param const std::string& file
-       * @param int line
-       * @param typename ...Args args
-       */
-      template <typename ...Args>
-      static bool fail(const std::string& file, int line, Args&& ...args)
-      { num_checks_++; num_fails_++; osout(osout_fail, file, line, std::forward<Args>(args)...); return false; }
+    /**
+     * Failure counts per check site, for limiting the number of logged
+     * fails of each site (e.g. checks in loops over large data). Sites
+     * are identified by their contents (file, line, kind, expressions),
+     * so that non-static sites of the same location are aggregated as well.
+     * Fails of sites beyond the limit are counted in thread-local slots
+     * and merged into the site table for the summary. The first and last
+     * messages are stored as items (see `binary_log::encoder`).
+     */
+    template <typename=void>
+    class fail_sites
+    {
+    public:
 
-      /**
-       * Register fail without logging
-       * @return bool
-       */
-      static bool fail() noexcept
-      { num_checks_++; num_fails_++; return false; }
+      struct entry
+      {
+        const char* file;
+        int line;
+        const char* expr;
+        const char* expr_rhs;
+        std::uint64_t fails;
+        std::string first;
+        std::string last;
+        std::uint64_t last_sequence;
+      };
 
       /**
-       * Register a check result, optionally tests are
-       * not logged using the `silent` flag.
-       * Note that `file` is not `nullptr` checked and
-       * expected to be always `__FILE__`.
-       * @tparam typename ...Args
-       * @param bool passed
-       * @param const char* file
-       * @param int line
-       * @param bool silent
-       * @param Args ...args
+       * Counts a fail of `site` with the message items `msg`, returns
+       * true if the fail shall be logged (not more than `limit` per site).
+       * @param const check_site& site
+       * @param const char* msg
+       * @param std::size_t size
+       * @param unsigned limit
        * @return bool
        */
-      template <typename ...Args>
-      static bool commit(bool passed, const char* file, int line, Args&& ...args)
+      static bool add(const check_site& site, const char* msg, std::size_t size, unsigned limit)
       {
-        if(omit_passes_) {
-          return (passed) ? pass() : fail(file, line, std::forward<Args>(args)...);
-        } else {
-          return (passed) ? pass(file, line, std::forward<Args>(args)...) : fail(file, line, std::forward<Args>(args)...);
+        const key k{site.file, site.line, site.kind, site.expr, site.expr_rhs};
+        local_sites& ls = local();
+        slot& s = ls.slots[slot_of(k)];
+        const std::uint64_t generation = generation_.load(std::memory_order_acquire);
+        if((s.generation == generation) && (s.k == k)) {
+          std::lock_guard<std::mutex> llck(ls.lock);
+          ++s.fails;
+          s.last_sequence = sequence();
+          assign(s.last, msg, size);
+          return false;
+        }
+        std::lock_guard<std::mutex> lck(lock_);
+        auto it = index_.find(k);
+        if(it == index_.end()) {
+          it = index_.emplace(k, entries_.size()).first;
+          entries_.push_back(entry{site.file, site.line, site.expr, site.expr_rhs, 0, std::string(), std::string(), 0});
+          assign(entries_.back().first, msg, size);
         }
+        entry& e = entries_[it->second];
+        if(++e.fails <= limit) {
+          assign(e.last, msg, size);
+          e.last_sequence = sequence();
+          return true;
+        }
+        ++suppressed_;
+        std::lock_guard<std::mutex> llck(ls.lock);
+        merge(s);
+        s.k = k;
+        s.generation = generation_.load(std::memory_order_relaxed);
+        s.index = it->second;
+        s.fails = 0;
+        s.last_sequence = sequence();
+        assign(s.last, msg, size);
+        return false;
       }
 
       /**
-       * Register a check result without logging.
-       * @param bool passed
-       * @return bool
+       * Number of fails that were not logged.
+       * @return std::uint64_t
        */
-      static bool commit(bool passed) noexcept
-      { return (passed) ? pass() : fail(); }
+      static std::uint64_t suppressed() noexcept
+      { std::lock_guard<std::mutex> lck(lock_); fold(); return suppressed_; }
 
       /**
-       * Passes if operator==() yields true, fails otherwise.
-       * Note: Expects `a_code` and `b_code` to be guaranteed non-`nullptr`.
+       * Failing sites in the order of their first fail.
+       * @return std::vector<entry>
        */
-      template<typename T1, typename T2>
-      static bool check_eq(const T1& a, const T2& b, const char* file, int line, const char* a_code, const char* b_code)
+      static std::vector<entry> entries()
+      { std::lock_guard<std::mutex> lck(lock_); fold(); return entries_; }
+
+      static void reset() noexcept
       {
-        using namespace std;
-        if(a == b) {
-          return pass(file, line, std::string(a_code), " == ", std::string(b_code), "   (=", a, ")");
-        } else {
-          return fail(file, line, std::string(a_code), " == ", std::string(b_code), "   (", a, " != ",  b, ")");
-        }
+        std::lock_guard<std::mutex> lck(lock_);
+        generation_.fetch_add(1, std::memory_order_release);
+        index_.clear();
+        entries_.clear();
+        suppressed_ = 0;
       }
 
-      /**
-       * Passes if operator!=() yields true, fails otherwise.
-       * Note: Expects `a_code` and `b_code` to be guaranteed non-`nullptr`.
-       */
-      template<typename T1, typename T2>
-      static bool check_ne(const T1& a, const T2& b, const char* file, int line, const char* a_code, const char* b_code)
+    private:
+
+      struct key
       {
-        using namespace std;
-        if(a != b) {
-          return pass(file, line, std::string(a_code), " != ", std::string(b_code), "   (", a, " != ", b, ")");
-        } else {
-          return fail(file, line, std::string(a_code), " != ", std::string(b_code), "   (both =", a, ")");
+        const char* file;
+        int line;
+        check_kind kind;
+        const char* expr;
+        const char* expr_rhs;
+        bool operator==(const key& o) const noexcept
+        { return (file == o.file) && (line == o.line) && (kind == o.kind) && (expr == o.expr) && (expr_rhs == o.expr_rhs); }
+      };
+
+      struct key_hash
+      {
+        std::size_t operator()(const key& k) const noexcept
+        {
+          std::size_t h = std::hash<const void*>()(k.file);
+          h = (h * 31u) + std::size_t(k.line);
+          h = (h * 31u) + std::size_t(k.kind);
+          h = (h * 31u) + std::hash<const void*>()(k.expr);
+          return (h * 31u) + std::hash<const void*>()(k.expr_rhs);
         }
-      }
+      };
 
       /**
-       * Passes if operator>() yields true, fails otherwise.
-       * Note: Expects `a_code` and `b_code` to be guaranteed non-`nullptr`.
+       * Thread-local counts of a site beyond the limit, not yet merged
+       * into the site table (`index` in the table of `generation`).
        */
-      template<typename T1, typename T2>
-      static bool check_gt(const T1& a, const T2& b, const char* file, int line, const char* a_code, const char* b_code)
+      struct slot
       {
-        using namespace std;
-        if(a > b) {
-          return pass(file, line, std::string(a_code), " > ", std::string(b_code), "   (", a, " > ", b, ")");
-        } else {
-          return fail(file, line, std::string(a_code), " > ", std::string(b_code), "   (", a, " <= ", b, ")");
-        }
-      }
+        key k;
+        std::uint64_t generation;
+        std::size_t index;
+        std::uint64_t fails;
+        std::uint64_t last_sequence;
+        std::string last;
+      };
+
+      enum : unsigned { slot_bits=6 };
 
       /**
-       * Passes if operator<() yields true, fails otherwise.
-       * Note: Expects `a_code` and `b_code` to be guaranteed non-`nullptr`.
+       * Direct mapped slots of a thread, registered for merging. The lock
+       * is only contended while merging.
        */
-      template<typename T1, typename T2>
-      static bool check_lt(const T1& a, const T2& b, const char* file, int line, const char* a_code, const char* b_code)
+      struct local_sites
       {
-        using namespace std;
-        if(a < b) {
-          return pass(file, line, std::string(a_code), " < ", std::string(b_code), "   (", a, " < ", b, ")");
-        } else {
-          return fail(file, line, std::string(a_code), " < ", std::string(b_code), "   (", a, " >= ", b, ")");
+        std::mutex lock;
+        std::vector<slot> slots;
+        local_sites* next;
+        local_sites* prev;
+
+        local_sites() : lock(), slots(std::size_t(1) << slot_bits, slot{key{nullptr, 0, check_kind::expect, nullptr, nullptr}, ~std::uint64_t(0), 0, 0, 0, std::string()}), next(nullptr), prev(nullptr)
+        {
+          std::lock_guard<std::mutex> lck(lock_);
+          next = locals_;
+          if(locals_) locals_->prev = this;
+          locals_ = this;
         }
+
+        ~local_sites() noexcept
+        {
+          std::lock_guard<std::mutex> lck(lock_);
+          std::lock_guard<std::mutex> llck(lock);
+          for(slot& s: slots) merge(s);
+          if(prev) prev->next = next; else locals_ = next;
+          if(next) next->prev = prev;
+        }
+      };
+
+      static local_sites& local()
+      { static thread_local local_sites ls; return ls; }
+
+      static std::size_t slot_of(const key& k) noexcept
+      {
+        const std::uint64_t h = std::uint64_t(reinterpret_cast<std::uintptr_t>(k.file)) ^ std::uint64_t(reinterpret_cast<std::uintptr_t>(k.expr)) ^ (std::uint64_t(unsigned(k.line)) << 24) ^ std::uint64_t(k.kind);
+        return std::size_t((h * 0x9e3779b97f4a7c15ull) >> (64u - slot_bits));
       }
 
+      static std::uint64_t sequence() noexcept
+      { return sequence_.fetch_add(1, std::memory_order_relaxed) + 1; }
+
       /**
-       * Passes if operator>=() yields true, fails otherwise.
-       * Note: Expects `a_code` and `b_code` to be guaranteed non-`nullptr`.
+       * Moves the counts and the last message of a slot into the site
+       * table (locked by the caller).
        */
-      template<typename T1, typename T2>
-      static bool check_ge(const T1& a, const T2& b, const char* file, int line, const char* a_code, const char* b_code)
+      static void merge(slot& s) noexcept
       {
-        using namespace std;
-        if(a >= b) {
-          return pass(file, line, std::string(a_code), " >= ", std::string(b_code), "   (", a, " >= ", b, ")");
-        } else {
-          return fail(file, line, std::string(a_code), " >= ", std::string(b_code), "   (", a, " < ", b, ")");
-        }
+        if((s.generation != generation_.load(std::memory_order_relaxed)) || (!s.last_sequence)) return;
+        entry& e = entries_[s.index];
+        e.fails += s.fails;
+        suppressed_ += s.fails;
+        if(s.last_sequence >= e.last_sequence) { e.last.swap(s.last); e.last_sequence = s.last_sequence; }
+        s.fails = 0;
+        s.last_sequence = 0;
       }
 
-      /**
-       * Passes if operator<=() yields true, fails otherwise.
-       * Note: Expects `a_code` and `b_code` to be guaranteed non-`nullptr`.
-       */
-      template<typename T1, typename T2>
-      static bool check_le(const T1& a, const T2& b, const char* file, int line, const char* a_code, const char* b_code)
+      static void fold() noexcept
       {
-        using namespace std;
-        if(a <= b) {
-          return pass(file, line, std::string(a_code), " <= ", std::string(b_code), "   (", a, " <= ", b, ")");
-        } else {
-          return fail(file, line, std::string(a_code), " <= ", std::string(b_code), "   (", a, " > ", b, ")");
+        for(local_sites* ls=locals_; ls; ls=ls->next) {
+          std::lock_guard<std::mutex> llck(ls->lock);
+          for(slot& s: ls->slots) merge(s);
         }
       }
 
-      /**
-       * Print a comment
-       * @param const std::string& file
-       * @param int line
-       * @param typename ...Args args
-       */
-      template <typename ...Args>
-      static void comment(const std::string& file, int line, Args&& ...args) noexcept
-      { osout(osout_note, file, line, std::forward<Args>(args)...); }
+      // Stored messages are shortened, the table shall not grow with the data.
+      static void assign(std::string& s, const char* msg, std::size_t size)
+      {
+        constexpr std::size_t max_size = 512;
+        s.assign(msg, (size <= max_size) ? size : max_size);
+      }
 
-      /**
-       * Print a warning
-       * @param const std::string& file
-       * @param int line
-       * @param typename ...Args args
-       */
-      template <typename ...Args>
-      static void warning(const std::string& file, int line, Args&& ...args) noexcept
-      { num_warns_++; osout(osout_warn, file, line, std::forward<Args>(args)...); }
+      static std::mutex lock_;
+      static std::atomic<std::uint64_t> generation_;
+      static std::atomic<std::uint64_t> sequence_;
+      static local_sites* locals_;
+      static std::unordered_map<key, std::size_t, key_hash> index_;
+      static std::vector<entry> entries_;
+      static std::uint64_t suppressed_;
+    };
+
+    template <typename T> std::mutex fail_sites<T>::lock_;
+    template <typename T> std::atomic<std::uint64_t> fail_sites<T>::generation_(0);
+    template <typename T> std::atomic<std::uint64_t> fail_sites<T>::sequence_(0);
+    template <typename T> typename fail_sites<T>::local_sites* fail_sites<T>::locals_ = nullptr;
+    template <typename T> std::unordered_map<typename fail_sites<T>::key, std::size_t, typename fail_sites<T>::key_hash> fail_sites<T>::index_;
+    template <typename T> std::vector<typename fail_sites<T>::entry> fail_sites<T>::entries_;
+    template <typename T> std::uint64_t fail_sites<T>::suppressed_ = 0;
+
+    /**
+     * Accumulated timing and check counts of `test_section()` scopes, keyed
+     * by the section site and the path of the enclosing section names.
+     */
+    template <typename=void>
+    class test_sections
+    {
+    public:
+
+      struct entry
+      {
+        const char* file;
+        int line;
+        std::string path;
+        std::uint64_t runs;
+        double wall_ms;
+        double cpu_ms;
+        std::uint64_t checks;
+        std::uint64_t fails;
+        std::vector<std::pair<const char*, std::uint64_t>> counters; // Performance counters (`WITH_MICROTEST_PERF_COUNTERS`).
+      };
 
       /**
-       * Print summary, return 0 on pass, 1 .. 99 on fail.
-       * @return int
+       * Adds a completed run of a section.
        */
-      static int summary() noexcept
+      static void add(const check_site& site, const std::string& path, double wall_ms, double cpu_ms, std::uint64_t checks, std::uint64_t fails)
       {
-        std::lock_guard<std::mutex> lck(iolock_);
-        if(!num_fails_) {
-          if(!num_checks_) {
-            *os_ << (ansi_colors() ? "\033[0;33m[DONE]\033[0m" : "[DONE]") << " No checks" << std::endl;
-          } else if(num_warns_) {
-            *os_ << (ansi_colors() ? "\033[0;33m[PASS]\033[0m" : "[PASS]") << " All " << num_checks_ << " checks passed, " << num_warns_ << " warnings." << std::endl;
-          } else {
-            *os_ << (ansi_colors() ? "\033[0;32m[PASS]\033[0m" : "[PASS]") << " All " << num_checks_ << " checks passed, " << num_warns_ << " warnings." << std::endl;
-          }
-        } else {
-          *os_ << (ansi_colors() ? "\033[0;31m[FAIL]\033[0m" : "[FAIL]") << " " << num_fails_ << " of " << num_checks_ << " checks failed, " << num_warns_ << " warnings." << std::endl;
-        }
-        unsigned long n = num_fails_;
-        return int((n > 99ul) ? (99ul) : (n));
+        std::lock_guard<std::mutex> lck(lock_);
+        entry& e = get(site, path);
+        ++e.runs;
+        e.wall_ms += wall_ms;
+        e.cpu_ms += cpu_ms;
+        e.checks += checks;
+        e.fails += fails;
       }
 
       /**
-       * Print build information
+       * Adds the performance counter values of a section run (event
+       * names are static strings).
        */
-      static void buildinfo(const char* file, int line) noexcept
-      { osout(osout_info, file, line, detail::buildinfo<>::info()); }
+      static void add_counters(const check_site& site, const std::string& path, const std::pair<const char*, std::uint64_t>* values, std::size_t size)
+      {
+        std::lock_guard<std::mutex> lck(lock_);
+        entry& e = get(site, path);
+        for(std::size_t i=0; i<size; ++i) {
+          auto it = std::find_if(e.counters.begin(), e.counters.end(), [&](const std::pair<const char*, std::uint64_t>& c){ return c.first == values[i].first; });
+          if(it == e.counters.end()) e.counters.push_back(values[i]); else it->second += values[i].second;
+        }
+      }
 
       /**
-       * Switch logging of "[pass] ...." on/off. Useful for bulk tests
-       * where only the fails and comments shall be printed. Note that
-       * the passes are still counted, only not written to the output.
-       * @param bool switch_off
+       * Returns the `n` sections with the highest accumulated wall time.
+       * @param std::size_t n
+       * @return std::vector<entry>
        */
-      static void omit_pass_log(bool switch_off) noexcept
-      { omit_passes_ = switch_off; }
+      static std::vector<entry> slowest(std::size_t n)
+      {
+        std::vector<entry> sections;
+        {
+          std::lock_guard<std::mutex> lck(lock_);
+          sections = entries_;
+        }
+        std::stable_sort(sections.begin(), sections.end(), [](const entry& a, const entry& b){ return a.wall_ms > b.wall_ms; });
+        if(sections.size() > n) sections.resize(n);
+        return sections;
+      }
 
       /**
-       * Returns if logging of "[pass] ...." is off.
-       * @return bool
+       * Milliseconds since the program start or the last `reset()`.
+       * @return double
        */
-      static bool omit_pass_log() noexcept
-      { return omit_passes_; }
+      static double total_ms() noexcept
+      {
+        std::lock_guard<std::mutex> lck(lock_);
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_).count();
+      }
 
-      /**
-       * Resets the test statistics
-       */
       static void reset() noexcept
-      { num_checks_ = 0; num_fails_ = 0; num_warns_ = 0; }
-
-      /**
-       * Resets the test statistics
-       */
-      static void reset(const char* file, int line) noexcept
-      { reset(); osout(osout_note, file, line, "Test statistics reset."); }
+      {
+        std::lock_guard<std::mutex> lck(lock_);
+        index_.clear();
+        entries_.clear();
+        start_ = std::chrono::steady_clock::now();
+      }
 
       /**
-       * Returns true if the standard output is bound to a console.
-       * @return bool
+       * CPU time of the current thread in milliseconds (process CPU time
+       * where no thread clock is available).
+       * @return double
        */
-      static bool istty() noexcept
+      static double thread_cpu_ms() noexcept
       {
-        #ifndef _MSC_VER
-        return bool(::isatty(STDOUT_FILENO));
+        #if defined(__WINDOWS__)
+        FILETIME created, exited, kernel, user;
+        if(!::GetThreadTimes(::GetCurrentThread(), &created, &exited, &kernel, &user)) return 0;
+        const std::uint64_t t = ((std::uint64_t(kernel.dwHighDateTime) << 32) | kernel.dwLowDateTime) + ((std::uint64_t(user.dwHighDateTime) << 32) | user.dwLowDateTime);
+        return double(t) / 1e4;
+        #elif defined(CLOCK_THREAD_CPUTIME_ID)
+        struct ::timespec ts;
+        if(::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) return 0;
+        return (double(ts.tv_sec) * 1e3) + (double(ts.tv_nsec) / 1e6);
         #else
-        return bool(_isatty(1));
+        return double(::clock()) * 1e3 / double(CLOCKS_PER_SEC);
         #endif
       }
 
     private:
 
-      enum {osout_pass=0, osout_fail, osout_warn, osout_note, osout_info };
+      struct key
+      {
+        const check_site* site;
+        std::string path;
+        bool operator==(const key& o) const noexcept
+        { return (site == o.site) && (path == o.path); }
+      };
 
-      template <typename ...Args>
-      static void osout(unsigned what, std::string file, int line, Args ...args) noexcept
+      struct key_hash
       {
-        static const char* caption_colors[5] = { "\033[0;32m", "\033[0;31m", "\033[0;33m", "\033[0;37m", "\033[0;34m" };
-        static const char* color_reset = "\033[0m";
-        what = (what > static_cast<unsigned>(osout_info)) ? static_cast<unsigned>(osout_fail) : what;
-        const char *color_tag_s="", *color_tag_e="", *color_file_s="", *color_file_e="", *color_end="";
-        if(ansi_colors()) {
-          color_tag_s = caption_colors[what];
-          color_tag_e = color_reset;
-          color_file_s = "\033[0;36m";
-          color_file_e = color_reset;
-          color_end = color_reset;
+        std::size_t operator()(const key& k) const noexcept
+        { return (std::hash<const void*>()(k.site) * 31u) + std::hash<std::string>()(k.path); }
+      };
+
+      // Entry of a section (lock held).
+      static entry& get(const check_site& site, const std::string& path)
+      {
+        const key k{&site, path};
+        auto it = index_.find(k);
+        if(it == index_.end()) {
+          it = index_.emplace(k, entries_.size()).first;
+          entries_.push_back(entry{site.file, site.line, path, 0, 0, 0, 0, 0, {}});
         }
+        return entries_[it->second];
+      }
+
+      static std::mutex lock_;
+      static std::unordered_map<key, std::size_t, key_hash> index_;
+      static std::vector<entry> entries_;
+      static std::chrono::steady_clock::time_point start_;
+    };
+
+    template <typename T> std::mutex test_sections<T>::lock_;
+    template <typename T> std::unordered_map<typename test_sections<T>::key, std::size_t, typename test_sections<T>::key_hash> test_sections<T>::index_;
+    template <typename T> std::vector<typename test_sections<T>::entry> test_sections<T>::entries_;
+    template <typename T> std::chrono::steady_clock::time_point test_sections<T>::start_ = std::chrono::steady_clock::now();
+
+    /**
+     * Scope of a `test_section()`: Measures the wall time, the CPU time, and
+     * the checks and fails of the current thread from construction to
+     * destruction. Sections of a thread nest, inner sections are included
+     * in the counts of the outer ones.
+     */
+    template <typename=void>
+    class section_scope
+    {
+    public:
 
+      section_scope(const check_site& site, const char* name) noexcept
+        : site_(site), name_(name ? name : ""), parent_(current()),
+          wall_start_(std::chrono::steady_clock::now()), cpu_start_(test_sections<>::thread_cpu_ms()),
+          checks_start_(check_counters<>::local().checks.load(std::memory_order_relaxed)),
+          fails_start_(check_counters<>::local().fails.load(std::memory_order_relaxed)),
+          once_(true)
+      { current() = this; }
+
+      ~section_scope() noexcept
+      {
+        const double wall_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wall_start_).count();
+        const double cpu_ms = test_sections<>::thread_cpu_ms() - cpu_start_;
+        const check_counters<>::shard& counts = check_counters<>::local();
+        const std::uint64_t checks = counts.checks.load(std::memory_order_relaxed);
+        const std::uint64_t fails = counts.fails.load(std::memory_order_relaxed);
+        current() = parent_;
         try {
-          if(!os_) return;
-          std::string msg;
-          {
-            std::stringstream ss;
-            push_stream(ss, std::forward<Args>(args)...);
-            msg = ss.str();
-          }
-          static const char* captions[5] = { "pass", "fail", "warn", "note", "info" };
-          std::lock_guard<std::mutex> lck(iolock_);
-          *os_ << color_tag_s << "[" << captions[what] << "]" << color_tag_e << " ";
-          if(!file.empty()) *os_ << color_file_s << "[@" << file << ":" << line << "]" << color_file_e << " ";
-          for(auto it = msg.begin(); it != msg.end(); ++it) {
-            if(*it == '\n') { *os_ << std::endl << "          "; } else { *os_ << *it; }
-          }
-          *os_<< color_end << std::endl;
+          // Counters may have been reset in the section.
+          test_sections<>::add(site_, path(), wall_ms, (cpu_ms > 0) ? cpu_ms : 0,
+            (checks >= checks_start_) ? (checks - checks_start_) : checks,
+            (fails >= fails_start_) ? (fails - fails_start_) : fails
+          );
         } catch(...) {
-          std::cerr << "[fatal  ] Testing frame could not write to the defined output stream, "
-                      "aborting." << std::endl;
-          ::abort();
+          ;
         }
       }
 
-      template <typename T, typename ...Args>
-      static void push_stream(std::ostream& os, T&& v, Args ...args)
-      { os << v; push_stream(os, std::forward<Args>(args)...); }
+      section_scope(const section_scope&) = delete;
+      section_scope& operator=(const section_scope&) = delete;
 
-      template <typename T>
-      static void push_stream(std::ostream& os, T&& v)
-      { os << v; }
+      /**
+       * True on the first call only, runs the `for()` body of the section once.
+       * @return bool
+       */
+      bool once() noexcept
+      { const bool first = once_; once_ = false; return first; }
 
-      static std::atomic<unsigned long> num_checks_;
-      static std::atomic<unsigned long> num_fails_;
-      static std::atomic<unsigned long> num_warns_;
-      static std::ostream* os_;
-      static std::mutex iolock_;
-      static bool ansi_colors_;
-      static bool omit_passes_;
-    };
+      /**
+       * Section names from the outermost section, separated by '/'.
+       * @return std::string
+       */
+      std::string path() const
+      { return parent_ ? (parent_->path() + "/" + name_) : std::string(name_); }
 
-    template <typename T> std::atomic<unsigned long> microtest<T>::num_checks_(0);
-    template <typename T> std::atomic<unsigned long> microtest<T>::num_fails_(0);
-    template <typename T> std::atomic<unsigned long> microtest<T>::num_warns_(0);
-    template <typename T> std::ostream* microtest<T>::os_ = nullptr;
-    template <typename T> std::mutex microtest<T>::iolock_;
-    template <typename T> bool microtest<T>::ansi_colors_(!!(MICROTEST_UTEST_ANSI_COLORS));
-    template <typename T> bool microtest<T>::omit_passes_(!!(MICROTEST_UTEST_OMIT_PASS_LOGS));
-  }
+      /**
+       * Site of the section.
+       * @return const check_site&
+       */
+      const check_site& site() const noexcept
+      { return site_; }
 
-  typedef detail::microtest<> test;
+    private:
 
-}}
+      static section_scope*& current() noexcept
+      { static thread_local section_scope* scope = nullptr; return scope; }
+
+      const check_site& site_;
+      const char* name_;
+      section_scope* const parent_;
+      const std::chrono::steady_clock::time_point wall_start_;
+      const double cpu_start_;
+      const std::uint64_t checks_start_;
+      const std::uint64_t fails_start_;
+      bool once_;
+    };
 
-/***
- * Random value and container generation.
- * Can be omitted using `WITHOUT_MICROTEST_RANDOM`.
- */
-namespace sw { namespace utest {
-  #ifndef WITHOUT_MICROTEST_RANDOM
+    /**
+     * Best-effort hooks on abnormal termination (fatal signals, `std::terminate()`),
+     * used to write pending log output before the process dies. The handlers
+     * installed before are saved, and restored before the signal is re-raised,
+     * so that these run afterwards (resp. the default action is taken). In the
+     * signal handler, the hooks are called with `in_signal=true` and must only
+     * use async-signal-safe functions (`::write()`).
+     */
+    template <typename=void>
+    class crash_hooks
+    {
+    public:
 
-    namespace random_generators {
+      using hook_type = void(*)(bool in_signal);
 
       /**
-       * Statically initialised RND device.
+       * Registers a hook (once), installs the handlers on first use.
+       * Ignored signals (e.g. SIGTERM with `nohup`) are left ignored.
+       * @param hook_type hook
        */
-      template <typename=void> struct rnddev { static std::random_device uni; };
-      template <typename T> std::random_device rnddev<T>::uni;
+      static void add(hook_type hook) noexcept
+      {
+        std::lock_guard<std::mutex> lck(lock_);
+        for(auto& h: hooks_) {
+          if(h == hook) return;
+          if(!h) { h = hook; break; }
+        }
+        if(installed_) return;
+        installed_ = true;
+        previous_terminate_ = std::set_terminate(&on_terminate);
+        for(unsigned i=0; i<num_signals; ++i) {
+          #ifndef __WINDOWS__
+          if(::sigaction(signals()[i], nullptr, &previous_[i]) != 0) continue;
+          if(!(previous_[i].sa_flags & SA_SIGINFO) && (previous_[i].sa_handler == SIG_IGN)) continue;
+          struct ::sigaction sa;
+          std::memset(&sa, 0, sizeof(sa));
+          sa.sa_handler = &on_signal;
+          ::sigemptyset(&sa.sa_mask);
+          (void)::sigaction(signals()[i], &sa, &previous_[i]);
+          #else
+          previous_[i] = std::signal(signals()[i], &on_signal);
+          if(previous_[i] == SIG_IGN) (void)std::signal(signals()[i], SIG_IGN);
+          #endif
+        }
+      }
 
       /**
-       * Random for floating point types, uniform distribution, single value request.
-       * @param T& r
-       * @param T min
-       * @param T max
+       * Returns true while the hooks are executed.
+       * @return bool
        */
-      template <typename R, typename A1, typename A2>
-      typename std::enable_if<
-        std::is_floating_point<typename std::decay<R>::type>::value &&
-        std::is_convertible<typename std::decay<A1>::type,R>::value &&
-        std::is_convertible<typename std::decay<A2>::type,R>::value,
-        void
-      >
-      ::type rnd(R& r, A1 min, A2 max)
-      { r = std::uniform_real_distribution<typename std::decay<R>::type>(static_cast<R>(min), static_cast<R>(max))(rnddev<>::uni); }
+      static bool active() noexcept
+      { return active_.load(std::memory_order_relaxed); }
+
+    private:
+
+      #ifndef __WINDOWS__
+      static constexpr unsigned num_signals = 6;
+      using disposition = struct ::sigaction;
+      #else
+      static constexpr unsigned num_signals = 5;
+      using disposition = void(*)(int);
+      #endif
+
+      static const int* signals() noexcept
+      {
+        #ifndef __WINDOWS__
+        static const int sigs[num_signals] = { SIGSEGV, SIGABRT, SIGFPE, SIGILL, SIGTERM, SIGBUS };
+        #else
+        static const int sigs[num_signals] = { SIGSEGV, SIGABRT, SIGFPE, SIGILL, SIGTERM };
+        #endif
+        return sigs;
+      }
+
+      static void run(bool in_signal) noexcept
+      {
+        if(active_.exchange(true)) return;
+        for(auto h: hooks_) { if(h) h(in_signal); }
+      }
+
+      static void on_signal(int sig)
+      {
+        run(true);
+        for(unsigned i=0; i<num_signals; ++i) {
+          if(signals()[i] != sig) continue;
+          #ifndef __WINDOWS__
+          (void)::sigaction(sig, &previous_[i], nullptr);
+          #else
+          (void)std::signal(sig, (previous_[i] == SIG_ERR) ? SIG_DFL : previous_[i]);
+          #endif
+        }
+        (void)std::raise(sig); // Delivered to the restored handler when this one returns.
+        active_.store(false, std::memory_order_relaxed); // The restored handler did not terminate.
+      }
+
+      static void on_terminate()
+      {
+        run(false);
+        if(previous_terminate_) previous_terminate_();
+        std::abort();
+      }
+
+      static std::mutex lock_;
+      static hook_type hooks_[4];
+      static bool installed_;
+      static std::atomic<bool> active_;
+      static std::terminate_handler previous_terminate_;
+      static disposition previous_[num_signals];
+    };
+
+    template <typename T> constexpr unsigned crash_hooks<T>::num_signals;
+    template <typename T> std::mutex crash_hooks<T>::lock_;
+    template <typename T> typename crash_hooks<T>::hook_type crash_hooks<T>::hooks_[4] = {nullptr,nullptr,nullptr,nullptr};
+    template <typename T> bool crash_hooks<T>::installed_ = false;
+    template <typename T> std::atomic<bool> crash_hooks<T>::active_(false);
+    template <typename T> std::terminate_handler crash_hooks<T>::previous_terminate_ = nullptr;
+    template <typename T> typename crash_hooks<T>::disposition crash_hooks<T>::previous_[crash_hooks<T>::num_signals];
+
+    /**
+     * Buffered raw file descriptor output. Records are collected in a user
+     * space buffer, which is written together with the next record in one
+     * `writev()` when that record does not fit anymore, or when flushed
+     * according to the flush policy. Pending output is written on destruction.
+     */
+    template <typename=void>
+    class fd_sink
+    {
+    public:
+
+      static constexpr std::size_t buffer_size = std::size_t(1) << 18;
+
+      fd_sink() noexcept : fd_(-1), buffer_(), size_(0), last_flush_() {}
+      ~fd_sink() noexcept { flush(); }
+      fd_sink(const fd_sink&) = delete;
+      fd_sink& operator=(const fd_sink&) = delete;
 
       /**
-       * Random for floating point types, uniform distribution, single value request.
-       * @param T& r
-       * @param T max
+       * Returns the file descriptor, -1 if closed.
+       * @return int
        */
-      template <typename R, typename A1>
-      typename std::enable_if<
-        std::is_floating_point<typename std::decay<R>::type>::value &&
-        std::is_convertible<typename std::decay<A1>::type,R>::value,
-        void
-      >
-      ::type rnd(R& r, A1 max)
-      { rnd(r, 0, max); }
+      int fd() const noexcept
+      { return fd_; }
 
       /**
-       * Random for floating point types, uniform distribution, single
-       * value request. Values between 0 and 1
-       * @param T& r
+       * Sets the file descriptor (pending output to the previous one is
+       * written before), -1 to close.
+       * @param int fd
        */
-      template <typename R>
-      typename std::enable_if<
-        std::is_floating_point<typename std::decay<R>::type>::value,
-        void
-      >
-      ::type rnd(R& r)
-      { rnd(r, 0, 1); }
+      void fd(int fd) noexcept
+      {
+        flush();
+        fd_ = fd;
+        if(fd_ < 0) return;
+        try { if(!buffer_) buffer_.reset(new char[buffer_size]); } catch(...) { ; }
+        last_flush_ = std::chrono::steady_clock::now();
+      }
 
       /**
-       * Random for integral types, uniform distribution, min to max (max inclusive
-       * interval [min,max]), single value request.
-       * @param T& r
-       * @param T min
-       * @param T max
+       * Appends data to the buffer, or writes buffer and data.
+       * @param const char* data
+       * @param std::size_t size
        */
-      template <typename R, typename A1, typename A2>
-      typename std::enable_if<
-        std::is_integral<typename std::decay<R>::type>::value &&
-        std::is_convertible<typename std::decay<A1>::type,R>::value &&
-        std::is_convertible<typename std::decay<A2>::type,R>::value &&
-        !std::is_same<typename std::decay<R>::type, char>::value &&
-        !std::is_same<typename std::decay<R>::type, unsigned char>::value,
-        void
-      >
-      ::type rnd(R& r, A1 min, A2 max)
-      { r = std::uniform_int_distribution<typename std::decay<R>::type>(static_cast<R>(min), static_cast<R>(max))(rnddev<>::uni); }
+      void write(const char* data, std::size_t size) noexcept
+      {
+        if(fd_ < 0) return;
+        if(buffer_ && (size_+size <= buffer_size)) {
+          std::memcpy(buffer_.get()+size_, data, size);
+          size_ += size;
+          return;
+        }
+        #ifndef __WINDOWS__
+        {
+          struct ::iovec iov[2];
+          iov[0].iov_base = buffer_.get();
+          iov[0].iov_len = size_;
+          iov[1].iov_base = const_cast<char*>(data);
+          iov[1].iov_len = size;
+          std::size_t remaining = size_ + size;
+          while(remaining > 0) {
+            const auto n = ::writev(fd_, (iov[0].iov_len ? &iov[0] : &iov[1]), (iov[0].iov_len ? 2 : 1));
+            if(n < 0) { if(errno == EINTR) continue; break; }
+            remaining -= std::size_t(n);
+            std::size_t done = std::size_t(n);
+            for(auto& v: iov) {
+              const std::size_t k = (done < v.iov_len) ? done : v.iov_len;
+              v.iov_base = static_cast<char*>(v.iov_base) + k;
+              v.iov_len -= k;
+              done -= k;
+            }
+          }
+        }
+        #else
+        write_all(buffer_.get(), size_);
+        write_all(data, size);
+        #endif
+        size_ = 0;
+        last_flush_ = std::chrono::steady_clock::now();
+      }
 
       /**
-       * Random for integral types, uniform distribution, 0 to max, single value request.
-       * @param T& r
-       * @param T max
+       * Writes the buffer contents to the file descriptor.
        */
-      template <typename R, typename A1>
-      typename std::enable_if<
-        std::is_integral<typename std::decay<R>::type>::value &&
-        std::is_convertible<typename std::decay<A1>::type,R>::value &&
-        !std::is_same<typename std::decay<R>::type, char>::value &&
-        !std::is_same<typename std::decay<R>::type, unsigned char>::value,
-        void
-      >
-      ::type rnd(R& r, A1 max)
-      { rnd(r, 0, max); }
+      void flush() noexcept
+      {
+        if((fd_ < 0) || (!size_)) return;
+        write_all(buffer_.get(), size_);
+        size_ = 0;
+        last_flush_ = std::chrono::steady_clock::now();
+      }
 
       /**
-       * Random for integral types, uniform distribution, over the complete
-       * range of the type, single value request.
-       * @param T& r
+       * Flushes if the last flush is longer ago than the given interval.
+       * @param std::chrono::milliseconds interval
        */
-      template <typename R>
-      typename std::enable_if<
-        std::is_integral<typename std::decay<R>::type>::value &&
+      void flush_if_older(std::chrono::milliseconds interval) noexcept
+      {
+        if(size_ && ((std::chrono::steady_clock::now() - last_flush_) >= interval)) flush();
+      }
+
+    private:
+
+      void write_all(const char* data, std::size_t size) noexcept
+      {
+        while(size > 0) {
+          #ifndef __WINDOWS__
+          const auto n = ::write(fd_, data, size);
+          if(n < 0) { if(errno == EINTR) continue; return; }
+          #else
+          const auto n = ::_write(fd_, data, unsigned(size));
+          if(n < 0) return;
+          #endif
+          data += n;
+          size -= std::size_t(n);
+        }
+      }
+
+      int fd_;
+      std::unique_ptr<char[]> buffer_;
+      std::size_t size_;
+      std::chrono::steady_clock::time_point last_flush_;
+    };
+
+    template <typename T> constexpr std::size_t fd_sink<T>::buffer_size;
+
+    /**
+     * Stream buffer collecting formatted output in a fixed-size array,
+     * continued on the heap only for oversized contents (the heap capacity
+     * is kept for reuse). Optionally indents continuation lines.
+     */
+    class format_streambuf : public std::streambuf
+    {
+    public:
+
+      static constexpr std::size_t fixed_size = 2048;
+
+      format_streambuf() noexcept : std::streambuf(), size_(0), heap_(), indent_(nullptr) {}
+      format_streambuf(const format_streambuf&) = delete;
+      format_streambuf& operator=(const format_streambuf&) = delete;
+
+      void clear() noexcept
+      { size_ = 0; heap_.clear(); indent_ = nullptr; }
+
+      const char* data() const noexcept
+      { return heap_.empty() ? fixed_ : heap_.data(); }
+
+      std::size_t size() const noexcept
+      { return heap_.empty() ? size_ : heap_.size(); }
+
+      /**
+       * Sets the text inserted after each newline, `nullptr` to disable.
+       * @param const char* indentation
+       */
+      void indent(const char* indentation) noexcept
+      { indent_ = indentation; }
+
+      /**
+       * Appends raw text (no indentation).
+       * @param const char* s
+       * @param std::size_t n
+       */
+      void append(const char* s, std::size_t n)
+      {
+        if(heap_.empty() && (size_+n <= fixed_size)) {
+          std::memcpy(fixed_+size_, s, n);
+          size_ += n;
+          return;
+        }
+        if(heap_.empty()) {
+          if(heap_.capacity() < 2*fixed_size) heap_.reserve(4*fixed_size);
+          heap_.assign(fixed_, size_);
+        }
+        heap_.append(s, n);
+      }
+
+      void append(const char* s)
+      { append(s, std::strlen(s)); }
+
+      /**
+       * Replaces `n` already appended characters at `offset`.
+       * @param std::size_t offset
+       * @param const char* s
+       * @param std::size_t n
+       */
+      void overwrite(std::size_t offset, const char* s, std::size_t n) noexcept
+      { std::memcpy((heap_.empty() ? fixed_ : &heap_[0]) + offset, s, n); }
+
+    protected:
+
+      int_type overflow(int_type c) override
+      {
+        if(traits_type::eq_int_type(c, traits_type::eof())) return traits_type::not_eof(c);
+        const char ch = traits_type::to_char_type(c);
+        append(&ch, 1);
+        if(indent_ && (ch == '\n')) append(indent_);
+        return c;
+      }
+
+      std::streamsize xsputn(const char* s, std::streamsize n) override
+      {
+        if(!indent_) { append(s, std::size_t(n)); return n; }
+        const char* const end = s + n;
+        while(s < end) {
+          const char* nl = static_cast<const char*>(std::memchr(s, '\n', std::size_t(end-s)));
+          if(!nl) { append(s, std::size_t(end-s)); break; }
+          append(s, std::size_t(nl-s+1));
+          append(indent_);
+          s = nl+1;
+        }
+        return n;
+      }
+
+    private:
+
+      char fixed_[fixed_size];
+      std::size_t size_;
+      std::string heap_;
+      const char* indent_;
+    };
+
+    /**
+     * Log record formatter, writes into one of a few thread-local stream
+     * buffers, so that formatting checks and notes does not allocate.
+     * Deeper nesting (e.g. an `operator<<()` that logs itself) falls back
+     * to a heap allocated buffer.
+     */
+    template <typename=void>
+    class record_formatter
+    {
+    public:
+
+      /**
+       * Character sequence reference, streamable.
+       */
+      struct text
+      {
+        const char* data;
+        std::size_t size;
+        friend std::ostream& operator<<(std::ostream& os, const text& t)
+        { return os.write(t.data, std::streamsize(t.size)); }
+      };
+
+      record_formatter() : slot_(nullptr), own_()
+      {
+        for(auto& s: slots()) { if(!s.in_use) { slot_ = &s; break; } }
+        if(!slot_) { own_.reset(new slot()); slot_ = own_.get(); }
+        slot_->in_use = true;
+        slot_->buf.clear();
+        std::ostream& os = slot_->os;
+        os.clear();
+        os.flags(std::ios_base::dec|std::ios_base::skipws);
+        os.precision(6);
+        os.width(0);
+        os.fill(' ');
+      }
+
+      ~record_formatter() noexcept
+      { slot_->in_use = false; }
+
+      record_formatter(const record_formatter&) = delete;
+      record_formatter& operator=(const record_formatter&) = delete;
+
+      std::ostream& os() noexcept
+      { return slot_->os; }
+
+      format_streambuf& buf() noexcept
+      { return slot_->buf; }
+
+      text str() const noexcept
+      { return text{slot_->buf.data(), slot_->buf.size()}; }
+
+    private:
+
+      struct slot
+      {
+        format_streambuf buf;
+        std::ostream os;
+        bool in_use;
+        slot() : buf(), os(&buf), in_use(false) {}
+      };
+
+      using slot_array = slot[3];
+
+      static slot_array& slots() noexcept
+      { static thread_local slot_array s; return s; }
+
+      slot* slot_;
+      std::unique_ptr<slot> own_;
+    };
+
+    /**
+     * Type-erased reference to a check operand, streamed with the
+     * `operator<<()` of its type only when the record is formatted. The
+     * comparison checks pass operand references instead of the operands,
+     * so that the logging code is not instantiated per operand type.
+     * Integer, floating point, and bool operands are tagged with their
+     * `type` (low nibble category, high nibble size), so that the binary
+     * log can store their value instead of the text.
+     */
+    struct operand_ref
+    {
+      enum : unsigned { type_other=0, type_int=1, type_uint=2, type_float=3 };
+
+      const void* value;
+      void (*format)(std::ostream&, const void*);
+      unsigned type;
+
+      template <typename T>
+      static operand_ref of(const T& v) noexcept
+      { return operand_ref{const_cast<const void*>(static_cast<const volatile void*>(std::addressof(v))), &write<T>, type_of<typename std::remove_cv<T>::type>()}; }
+
+      template <typename T>
+      static void write(std::ostream& os, const void* v)
+      { os << *static_cast<const T*>(v); }
+
+      /**
+       * Type tag of an operand type, `type_other` for types streamed as text
+       * (characters, long double, user types).
+       */
+      template <typename T>
+      static constexpr unsigned type_of() noexcept
+      {
+        return (std::is_same<T,bool>::value) ? unsigned(type_uint | (sizeof(T) << 4)) :
+          (std::is_same<T,char>::value || std::is_same<T,signed char>::value || std::is_same<T,unsigned char>::value
+            || std::is_same<T,wchar_t>::value || std::is_same<T,char16_t>::value || std::is_same<T,char32_t>::value || (sizeof(T) > 8)) ? unsigned(type_other) :
+          (std::is_integral<T>::value) ? unsigned((std::is_signed<T>::value ? unsigned(type_int) : unsigned(type_uint)) | (sizeof(T) << 4)) :
+          (std::is_same<T,float>::value || std::is_same<T,double>::value) ? unsigned(type_float | (sizeof(T) << 4)) :
+          unsigned(type_other);
+      }
+
+      friend std::ostream& operator<<(std::ostream& os, const operand_ref& r)
+      { r.format(os, r.value); return os; }
+    };
+
+    #ifdef WITH_MICROTEST_ASYNC_LOG
+    /**
+     * Asynchronous log backend. Each logging thread appends its pre-formatted
+     * records to an own lock-free single-producer/single-consumer ring buffer,
+     * a background writer thread drains the rings to the sink. Records of one
+     * thread keep their order. `flush()` drains on the calling thread, so that
+     * all records pushed before are written when it returns.
+     */
+    template <typename=void>
+    class async_writer
+    {
+    public:
+
+      using sink_type = void(*)(const char* data, std::size_t size); // (nullptr, 0) -> flush
+
+      /**
+       * Returns true if records are currently passed to the writer thread.
+       * @return bool
+       */
+      static bool enabled() noexcept
+      { return enabled_.load(std::memory_order_acquire); }
+
+      /**
+       * Enables or disables the asynchronous mode. Disabling joins the
+       * writer thread (restarted by the next push), so that no thread
+       * holds the consumer lock across a `fork()`, and drains all pending
+       * records before returning.
+       * @param bool enable
+       * @param sink_type sink
+       */
+      static void enable(bool enable, sink_type sink) noexcept
+      {
+        if(!enable) { enabled_.store(false, std::memory_order_release); writer().halt(); flush(); return; }
+        sink_ = sink;
+        enabled_.store(true, std::memory_order_release);
+      }
+
+      /**
+       * Appends a record to the ring of the calling thread. Returns false if
+       * the record cannot be passed to the writer (too large, thread could not
+       * be started), in which case the caller writes synchronously after `flush()`.
+       * @param const char* data
+       * @param std::size_t size
+       * @return bool
+       */
+      static bool push(const char* data, std::size_t size) noexcept
+      {
+        const std::uint64_t need = record_size(size);
+        if(need > (ring_size/4)) return false;
+        if(!writer().start()) return false;
+        ring& r = local();
+        std::uint64_t head = r.head.load(std::memory_order_relaxed);
+        const std::uint64_t offs = head & (ring_size-1);
+        const std::uint64_t contiguous = ring_size - offs;
+        const std::uint64_t total = need + ((contiguous < need) ? contiguous : 0);
+        while((ring_size - (head - r.tail.load(std::memory_order_acquire))) < total) {
+          writer().wake(true);
+          std::this_thread::yield();
+        }
+        if(contiguous < need) {
+          const std::uint32_t marker = wrap_marker;
+          std::memcpy(&r.data[offs], &marker, sizeof(marker));
+          head += contiguous;
+        }
+        const std::uint32_t len = std::uint32_t(size);
+        char* p = &r.data[head & (ring_size-1)];
+        std::memcpy(p, &len, sizeof(len));
+        std::memcpy(p+sizeof(len), data, size);
+        r.head.store(head + need, std::memory_order_release);
+        writer().wake(false);
+        return true;
+      }
+
+      /**
+       * Drains all rings on the calling thread and flushes the sink.
+       */
+      static void flush() noexcept
+      {
+        std::lock_guard<std::mutex> lck(consumer_lock_);
+        drain_all();
+      }
+
+      /**
+       * Best-effort drain on abnormal termination (signal or `std::terminate()`).
+       * The consumer lock may be held by the interrupted writer, hence only
+       * a bounded number of attempts is made.
+       */
+      static void emergency_flush() noexcept
+      {
+        if(!enabled()) return;
+        for(int i=0; i<1000; ++i) {
+          if(consumer_lock_.try_lock()) { drain_all(); consumer_lock_.unlock(); return; }
+          std::this_thread::yield();
+        }
+      }
+
+      /**
+       * Drain on fatal signals: Writes the pending records of all rings
+       * directly to the file descriptor (`::write()` only, no locks). The
+       * rings are read best-effort, as the interrupted writer may drain
+       * them at the same time.
+       * @param int fd
+       */
+      static void signal_flush(int fd) noexcept
+      {
+        if(!enabled() || (fd < 0)) return;
+        for(ring* r=rings_; r; r=r->next) {
+          std::uint64_t tail = r->tail.load(std::memory_order_acquire);
+          const std::uint64_t head = r->head.load(std::memory_order_acquire);
+          while((tail != head) && ((head - tail) <= ring_size)) {
+            const std::uint64_t offs = tail & (ring_size-1);
+            std::uint32_t len = 0;
+            std::memcpy(&len, &r->data[offs], sizeof(len));
+            if(len == wrap_marker) { tail += ring_size - offs; continue; }
+            if(len > (ring_size - offs - sizeof(len))) break;
+            write_fd(fd, &r->data[offs+sizeof(len)], len);
+            tail += record_size(len);
+          }
+          r->tail.store(tail, std::memory_order_release);
+        }
+      }
+
+    private:
+
+      static void write_fd(int fd, const char* data, std::size_t size) noexcept
+      {
+        while(size > 0) {
+          #ifndef __WINDOWS__
+          const ssize_t n = ::write(fd, data, size);
+          if((n < 0) && (errno == EINTR)) continue;
+          #else
+          const int n = ::_write(fd, data, unsigned(size));
+          #endif
+          if(n <= 0) return;
+          data += n;
+          size -= std::size_t(n);
+        }
+      }
+
+      static constexpr std::uint64_t ring_size = std::uint64_t(1) << 16;
+      static constexpr std::uint32_t wrap_marker = 0xffffffffu;
+
+      struct ring
+      {
+        std::atomic<std::uint64_t> head;
+        char pad0[64-sizeof(std::atomic<std::uint64_t>)];
+        std::atomic<std::uint64_t> tail;
+        char pad1[64-sizeof(std::atomic<std::uint64_t>)];
+        ring* next;
+        ring* prev;
+        char data[ring_size];
+      };
+
+      struct registration
+      {
+        std::unique_ptr<ring> r;
+
+        registration() : r(new ring())
+        {
+          r->head = 0; r->tail = 0; r->prev = nullptr;
+          std::lock_guard<std::mutex> lck(consumer_lock_);
+          r->next = rings_;
+          if(rings_) rings_->prev = r.get();
+          rings_ = r.get();
+        }
+
+        ~registration() noexcept
+        {
+          std::lock_guard<std::mutex> lck(consumer_lock_);
+          drain(*r);
+          if(sink_) sink_(nullptr, 0);
+          if(r->prev) r->prev->next = r->next; else rings_ = r->next;
+          if(r->next) r->next->prev = r->prev;
+        }
+      };
+
+      class writer_thread
+      {
+      public:
+
+        writer_thread() noexcept : thread_(), mtx_(), cv_(), stop_(false), sleeping_(false) {}
+
+        /**
+         * Joins the thread and drains the rings. Further pushes are
+         * rejected (`start()` fails), the callers write synchronously.
+         */
+        void stop() noexcept
+        {
+          {
+            std::lock_guard<std::mutex> lck(mtx_);
+            if(stop_) return;
+            stop_ = true;
+          }
+          cv_.notify_one();
+          if(thread_.joinable()) thread_.join();
+          running_.store(false, std::memory_order_release);
+          enabled_.store(false, std::memory_order_release);
+          flush();
+        }
+
+        /**
+         * Joins the thread without rejecting further pushes,
+         * `start()` launches a new thread when needed.
+         */
+        void halt() noexcept
+        {
+          {
+            std::lock_guard<std::mutex> lck(mtx_);
+            if(stop_ || !thread_.joinable()) return;
+            stop_ = true;
+          }
+          cv_.notify_one();
+          thread_.join();
+          std::lock_guard<std::mutex> lck(mtx_);
+          running_.store(false, std::memory_order_release);
+          stop_ = false;
+        }
+
+        bool start() noexcept
+        {
+          if(running_.load(std::memory_order_acquire)) return true;
+          try {
+            std::lock_guard<std::mutex> lck(mtx_);
+            if(stop_) return false;
+            if(!thread_.joinable()) thread_ = std::thread(&writer_thread::run, this);
+            running_.store(true, std::memory_order_release);
+            return true;
+          } catch(...) {
+            return false;
+          }
+        }
+
+        void wake(bool force) noexcept
+        {
+          if(!force && !sleeping_.load(std::memory_order_relaxed)) return;
+          cv_.notify_one();
+        }
+
+      private:
+
+        void run() noexcept
+        {
+          for(;;) {
+            bool idle;
+            {
+              std::lock_guard<std::mutex> lck(consumer_lock_);
+              idle = !drain_all();
+            }
+            std::unique_lock<std::mutex> lck(mtx_);
+            if(stop_) break;
+            if(idle) {
+              sleeping_.store(true, std::memory_order_relaxed);
+              cv_.wait_for(lck, std::chrono::milliseconds(5));
+              sleeping_.store(false, std::memory_order_relaxed);
+            }
+          }
+        }
+
+        std::thread thread_;
+        std::mutex mtx_;
+        std::condition_variable cv_;
+        bool stop_;
+        std::atomic<bool> sleeping_;
+        static std::atomic<bool> running_;
+      };
+
+      struct writer_shutdown
+      {
+        ~writer_shutdown() noexcept { writer().stop(); }
+      };
+
+      /**
+       * The writer is intentionally never destroyed, so that the terminate
+       * and crash paths can still reach it during the static destruction.
+       * The thread is stopped by the `writer_shutdown` static at exit.
+       */
+      static writer_thread& writer() noexcept
+      {
+        static writer_thread* const w = new writer_thread();
+        static writer_shutdown shutdown;
+        (void)shutdown;
+        return *w;
+      }
+
+      static ring& local()
+      { static thread_local registration reg; return *reg.r; }
+
+      static constexpr std::uint64_t record_size(std::size_t size) noexcept
+      { return (std::uint64_t(sizeof(std::uint32_t) + size) + 3u) & ~std::uint64_t(3u); }
+
+      /**
+       * Writes all pending records of a ring to the sink (consumer lock held).
+       */
+      static bool drain(ring& r) noexcept
+      {
+        std::uint64_t tail = r.tail.load(std::memory_order_relaxed);
+        const std::uint64_t head = r.head.load(std::memory_order_acquire);
+        if(tail == head) return false;
+        while(tail != head) {
+          const std::uint64_t offs = tail & (ring_size-1);
+          std::uint32_t len = 0;
+          std::memcpy(&len, &r.data[offs], sizeof(len));
+          if(len == wrap_marker) { tail += ring_size - offs; continue; }
+          if(sink_) sink_(&r.data[offs+sizeof(len)], len);
+          tail += record_size(len);
+        }
+        r.tail.store(tail, std::memory_order_release);
+        return true;
+      }
+
+      static bool drain_all() noexcept
+      {
+        bool any = false;
+        for(ring* r=rings_; r; r=r->next) any = drain(*r) || any;
+        if(any && sink_) sink_(nullptr, 0);
+        return any;
+      }
+
+      static std::atomic<bool> enabled_;
+      static std::mutex consumer_lock_;
+      static ring* rings_;
+      static sink_type sink_;
+    };
+
+    template <typename T> constexpr std::uint64_t async_writer<T>::ring_size;
+    template <typename T> constexpr std::uint32_t async_writer<T>::wrap_marker;
+    template <typename T> std::atomic<bool> async_writer<T>::enabled_(false);
+    template <typename T> std::mutex async_writer<T>::consumer_lock_;
+    template <typename T> typename async_writer<T>::ring* async_writer<T>::rings_ = nullptr;
+    template <typename T> typename async_writer<T>::sink_type async_writer<T>::sink_ = nullptr;
+    template <typename T> std::atomic<bool> async_writer<T>::writer_thread::running_(false);
+    #endif
+
+    /**
+     * Compact binary log format (`test::reporter(test::report_binary)`) and
+     * its decoder. The stream consists of records with a header of one type
+     * byte and four unsigned LEB128 varints, followed by `size` payload bytes:
+     *
+     *   u8 type (check result 0..4, or `type_site`, `type_literal`, `type_text`,
+     *   `type_magic`), thread, time (microseconds since start), id, size.
+     *
+     * Call sites (file, line, kind, expressions) and the string literals of
+     * the messages are described by `type_site` and `type_literal` records
+     * before their first use in the thread, output, and captured test case.
+     * A later description with the same thread and id replaces the former
+     * one. The payload of a check record (id: site) are the message arguments
+     * as items: references to the site expressions and literals, integer and
+     * floating point values, and the text of other arguments. The decoder
+     * formats the values like the text reporter, and renders the text log
+     * records, or a filtered subset of them.
+     */
+    template <typename=void>
+    class binary_log
+    {
+    public:
+
+      enum : unsigned { type_site=0x53, type_literal=0x4c, type_text=0x54, type_magic=0x4d };
+      enum : unsigned { item_expr=1, item_expr_rhs, item_literal, item_text, item_formatted, item_int, item_uint, item_float, item_short_literal=0x80 };
+
+      /**
+       * Decoded record.
+       */
+      struct record
+      {
+        unsigned type;
+        std::uint64_t thread;
+        std::uint64_t time_us;
+        std::uint64_t id;
+        std::string payload;
+      };
+
+      /**
+       * Site table entry of the decoder.
+       */
+      struct site_info
+      {
+        std::string file;
+        int line;
+        check_kind kind;
+        std::string expr;
+        std::string expr_rhs;
+      };
+
+      /**
+       * Decoder record selection. `results` is a bit mask of the check results
+       * (`1<<osout_pass` ... `1<<osout_info`) and `1<<5` for text records (summaries),
+       * `file` a file name substring, `line` a line number (0: any). Text
+       * records are only selected without file and line filter.
+       */
+      struct filter
+      {
+        unsigned results;
+        std::string file;
+        int line;
+        filter() : results(0x3f), file(), line(0) {}
+      };
+
+    private:
+
+      struct site_slot
+      {
+        const check_site* key;
+        const char* file;
+        int line;
+        check_kind kind;
+        const char* expr;
+        const char* expr_rhs;
+        std::uint32_t id;
+      };
+
+      struct literal_slot
+      {
+        const char* key;
+        std::uint32_t id;
+        std::string text;
+      };
+
+      /**
+       * Thread-local direct mapped caches of the described sites and literals
+       * (a collision describes the entry again with a new id).
+       */
+      struct cache_type
+      {
+        std::uint64_t epoch;
+        const void* capture;
+        std::uint32_t next_id;
+        std::vector<site_slot> sites;
+        std::vector<literal_slot> literals;
+      };
+
+      enum : unsigned { cache_bits=8 };
+
+      static cache_type& cache(std::uint64_t epoch, const void* capture)
+      {
+        static thread_local cache_type c{0, nullptr, 0, {}, {}};
+        if((c.epoch != epoch) || (c.capture != capture) || c.sites.empty()) {
+          c.epoch = epoch;
+          c.capture = capture;
+          c.next_id = 0;
+          c.sites.assign(std::size_t(1) << cache_bits, site_slot{nullptr, nullptr, 0, check_kind::expect, nullptr, nullptr, 0});
+          c.literals.assign(std::size_t(1) << cache_bits, literal_slot{nullptr, 0, std::string()});
+        }
+        return c;
+      }
+
+    public:
+
+      /**
+       * Encoder of one check record: Looks up the site, appends the site and
+       * literal descriptions to the output buffer, and the message items to
+       * the payload buffer. `finish()` appends the record.
+       */
+      class encoder
+      {
+      public:
+
+        encoder(format_streambuf& out, record_formatter<>& payload, const check_site& site, std::uint64_t epoch, const void* capture, unsigned thread, std::uint64_t time_us)
+          : out_(&out), payload_(payload), site_(site), cache_(&cache(epoch, capture)), thread_(thread), time_us_(time_us), id_(lookup_site(out, *cache_, site, thread, time_us))
+        {}
+
+        /**
+         * Encoder of the message items only, literals as text, rendered
+         * with `message()`.
+         */
+        encoder(record_formatter<>& payload, const check_site& site)
+          : out_(nullptr), payload_(payload), site_(site), cache_(nullptr), thread_(0), time_us_(0), id_(0)
+        {}
+
+        encoder(const encoder&) = delete;
+        encoder& operator=(const encoder&) = delete;
+
+        /**
+         * String literals (constant character arrays) by reference.
+         */
+        template <std::size_t N>
+        void add(const char (&s)[N])
+        { add_literal(s, N); }
+
+        template <std::size_t N>
+        void add(char (&s)[N])
+        { add_value(operand_ref::of(s)); }
+
+        template <typename T>
+        void add(const T& v)
+        { add_value(v); }
+
+        /**
+         * Appends the check record with the given result to the output buffer.
+         * @param unsigned what
+         */
+        void finish(unsigned what)
+        {
+          append_header(*out_, what, thread_, time_us_, id_, payload_.buf().size());
+          out_->append(payload_.buf().data(), payload_.buf().size());
+        }
+
+      private:
+
+        /**
+         * Site expressions, other C strings as text.
+         */
+        void add_value(const char* s)
+        {
+          if(s && (s == site_.expr)) { put_byte(item_expr); return; }
+          if(s && (s == site_.expr_rhs)) { put_byte(item_expr_rhs); return; }
+          add_text(s, s ? std::strlen(s) : 0);
+        }
+
+        void add_value(const std::string& s)
+        { add_text(s.data(), s.size()); }
+
+        /**
+         * Integer and floating point operands as values (if the stream
+         * format is the default one), others formatted as text.
+         */
+        void add_value(const operand_ref& r)
+        {
+          std::ostream& os = payload_.os();
+          if((r.type != operand_ref::type_other) && (os.flags() == (std::ios_base::dec|std::ios_base::skipws)) && (os.precision() == 6) && (os.width() == 0)) {
+            const unsigned size = r.type >> 4;
+            switch(r.type & 0x0fu) {
+              case operand_ref::type_int: {
+                const std::int64_t v = (size == 1) ? value<std::int8_t>(r.value) : (size == 2) ? value<std::int16_t>(r.value) : (size == 4) ? value<std::int32_t>(r.value) : value<std::int64_t>(r.value);
+                put_byte(item_int);
+                put_varint((std::uint64_t(v) << 1) ^ ((v < 0) ? ~std::uint64_t(0) : std::uint64_t(0)));
+                return;
+              }
+              case operand_ref::type_uint: {
+                put_byte(item_uint);
+                put_varint((size == 1) ? value<std::uint8_t>(r.value) : (size == 2) ? value<std::uint16_t>(r.value) : (size == 4) ? value<std::uint32_t>(r.value) : value<std::uint64_t>(r.value));
+                return;
+              }
+              case operand_ref::type_float: {
+                const double v = (size == 4) ? double(value<float>(r.value)) : value<double>(r.value);
+                std::uint64_t bits = 0;
+                std::memcpy(&bits, &v, sizeof(bits));
+                char b[9];
+                b[0] = char(item_float);
+                put(b+1, bits, 8);
+                payload_.buf().append(b, sizeof(b));
+                return;
+              }
+            }
+          }
+          const std::size_t start = begin_formatted();
+          r.format(os, r.value);
+          end_formatted(start);
+        }
+
+        /**
+         * Stream manipulators, applied to the stream of the formatted items.
+         */
+        void add_value(std::ios_base& (*manipulator)(std::ios_base&))
+        { payload_.os() << manipulator; }
+
+        void add_value(std::ostream& (*manipulator)(std::ostream&))
+        { const std::size_t start = begin_formatted(); payload_.os() << manipulator; end_formatted(start); }
+
+        template <typename T>
+        void add_value(const T& v)
+        { add_value(operand_ref::of(v)); }
+
+        template <typename T>
+        static T value(const void* p) noexcept
+        { T v; std::memcpy(&v, p, sizeof(T)); return v; }
+
+        void put_byte(unsigned b)
+        { const char c = char(b); payload_.buf().append(&c, 1); }
+
+        void put_varint(std::uint64_t v)
+        { char b[10]; payload_.buf().append(b, binary_log::put_varint(b, v)); }
+
+        void add_text(const char* s, std::size_t n)
+        { put_byte(item_text); put_varint(n); payload_.buf().append(s, n); }
+
+        std::size_t begin_formatted()
+        {
+          const char placeholder[5] = { char(item_formatted), 0, 0, 0, 0 };
+          payload_.buf().append(placeholder, sizeof(placeholder));
+          return payload_.buf().size();
+        }
+
+        void end_formatted(std::size_t start) noexcept
+        {
+          char n[4];
+          put(n, payload_.buf().size()-start, 4);
+          payload_.buf().overwrite(start-4, n, 4);
+        }
+
+        void add_literal(const char* s, std::size_t n)
+        {
+          const char* const end = static_cast<const char*>(std::memchr(s, '\0', n));
+          if(end) n = std::size_t(end - s);
+          if(!cache_) { add_text(s, n); return; }
+          const std::uint64_t id = lookup_literal(*out_, *cache_, s, n, thread_, time_us_);
+          if(id < item_short_literal) { put_byte(unsigned(item_short_literal|id)); return; }
+          put_byte(item_literal);
+          put_varint(id);
+        }
+
+        format_streambuf* out_;
+        record_formatter<>& payload_;
+        const check_site& site_;
+        cache_type* cache_;
+        unsigned thread_;
+        std::uint64_t time_us_;
+        std::uint32_t id_;
+      };
+
+    public:
+
+      /**
+       * Version record that starts each binary log.
+       */
+      static void append_magic(format_streambuf& buf, unsigned thread, std::uint64_t time_us)
+      {
+        static const char version[] = "microtest-binary-log-2";
+        append_header(buf, type_magic, thread, time_us, 0, sizeof(version)-1);
+        buf.append(version, sizeof(version)-1);
+      }
+
+      /**
+       * Appends a plain text record (summary lines).
+       */
+      static void append_text(format_streambuf& buf, unsigned thread, std::uint64_t time_us, const char* text, std::size_t size)
+      {
+        append_header(buf, type_text, thread, time_us, 0, size);
+        buf.append(text, size);
+      }
+
+      /**
+       * Formats the message items of an encoder without literal table,
+       * items truncated in storage are omitted.
+       * @param const std::string& items
+       * @param const char* expr
+       * @param const char* expr_rhs
+       * @return std::string
+       */
+      static std::string message(const std::string& items, const char* expr, const char* expr_rhs)
+      {
+        const record rec{0, 0, 0, 0, items};
+        const site_info site{std::string(), 0, check_kind::expect, expr ? expr : "", expr_rhs ? expr_rhs : ""};
+        std::ostringstream values;
+        std::string msg;
+        render(rec, site, std::unordered_map<std::uint64_t, std::string>(), values, msg);
+        return msg;
+      }
+
+      /**
+       * Reads the next record, returns false at the end of the stream or
+       * on truncated records.
+       * @param std::istream& is
+       * @param record& rec
+       * @return bool
+       */
+      static bool read(std::istream& is, record& rec)
+      {
+        const std::istream::int_type type = is.get();
+        if(type == std::istream::traits_type::eof()) return false;
+        std::uint64_t size = 0;
+        rec.type = unsigned(type) & 0xffu;
+        if(!get_varint(is, rec.thread) || !get_varint(is, rec.time_us) || !get_varint(is, rec.id) || !get_varint(is, size) || (size > (std::uint64_t(1) << 30))) return false;
+        rec.payload.resize(std::size_t(size));
+        return (!size) || bool(is.read(&rec.payload[0], std::streamsize(size)));
+      }
+
+      /**
+       * Renders the binary log `is` as text log records to `os`, selected
+       * by `sel`. Returns false if the input is not a binary log or truncated.
+       * @param std::istream& is
+       * @param std::ostream& os
+       * @param const filter& sel
+       * @return bool
+       */
+      static bool decode(std::istream& is, std::ostream& os, const filter& sel=filter())
+      {
+        static const char* captions[5] = { "pass", "fail", "warn", "note", "info" };
+        std::unordered_map<std::uint64_t, site_info> sites;
+        std::unordered_map<std::uint64_t, std::string> literals;
+        const auto key = [](const record& r) { return (r.thread << 32) ^ r.id; };
+        record rec;
+        if(!read(is, rec) || (rec.type != type_magic)) return false;
+        std::string text, message;
+        std::ostringstream values;
+        while(is.peek() != std::istream::traits_type::eof()) {
+          if(!read(is, rec)) return false;
+          switch(rec.type) {
+            case type_magic:
+              break;
+            case type_site:
+              if(!parse_site(rec, sites[key(rec)])) return false;
+              break;
+            case type_literal:
+              literals[key(rec)] = rec.payload;
+              break;
+            case type_text:
+              if((sel.results & (1u<<5)) && (sel.file.empty()) && (sel.line <= 0)) os << rec.payload;
+              break;
+            default: {
+              if(rec.type > 4) return false;
+              if(!(sel.results & (1u<<rec.type))) break;
+              const auto it = sites.find(key(rec));
+              if(it == sites.end()) return false;
+              const site_info& site = it->second;
+              if((sel.line > 0) && (sel.line != site.line)) break;
+              if((!sel.file.empty()) && (site.file.find(sel.file) == std::string::npos)) break;
+              if(!render(rec, site, literals, values, message)) return false;
+              text.assign("[").append(captions[rec.type]).append("] ");
+              if(!site.file.empty()) { text.append("[@").append(site.file).append(":").append(std::to_string(site.line)).append("] "); }
+              for(const char c: message) { text.push_back(c); if(c == '\n') text.append("          "); }
+              text.append("\n");
+              os << text;
+            }
+          }
+        }
+        return true;
+      }
+
+    private:
+
+      static std::size_t slot_of(const void* p) noexcept
+      { return std::size_t((std::uint64_t(reinterpret_cast<std::uintptr_t>(p)) * 0x9e3779b97f4a7c15ull) >> (64u - cache_bits)); }
+
+      static void append_header(format_streambuf& buf, unsigned type, std::uint64_t thread, std::uint64_t time_us, std::uint64_t id, std::size_t size)
+      {
+        char h[41];
+        std::size_t n = 1;
+        h[0] = char(type);
+        n += put_varint(h+n, thread);
+        n += put_varint(h+n, time_us);
+        n += put_varint(h+n, id);
+        n += put_varint(h+n, size);
+        buf.append(h, n);
+      }
+
+      static void put(char* p, std::uint64_t value, unsigned bytes) noexcept
+      { for(unsigned i=0; i<bytes; ++i) { p[i] = char((value >> (8*i)) & 0xffu); } }
+
+      static std::uint64_t get(const unsigned char* p, unsigned bytes) noexcept
+      { std::uint64_t v = 0; for(unsigned i=0; i<bytes; ++i) { v |= std::uint64_t(p[i]) << (8*i); } return v; }
+
+      static std::size_t put_varint(char* p, std::uint64_t v) noexcept
+      {
+        std::size_t n = 0;
+        while(v >= 0x80u) { p[n++] = char((v & 0x7fu) | 0x80u); v >>= 7; }
+        p[n++] = char(v);
+        return n;
+      }
+
+      static bool get_varint(std::istream& is, std::uint64_t& v)
+      {
+        v = 0;
+        for(unsigned shift=0; shift<64; shift+=7) {
+          const std::istream::int_type c = is.get();
+          if(c == std::istream::traits_type::eof()) return false;
+          v |= std::uint64_t(c & 0x7f) << shift;
+          if(!(c & 0x80)) return true;
+        }
+        return false;
+      }
+
+      static bool get_varint(const std::string& s, std::size_t& pos, std::uint64_t& v) noexcept
+      {
+        v = 0;
+        for(unsigned shift=0; (shift<64) && (pos<s.size()); shift+=7) {
+          const unsigned c = static_cast<unsigned char>(s[pos++]);
+          v |= std::uint64_t(c & 0x7fu) << shift;
+          if(!(c & 0x80u)) return true;
+        }
+        return false;
+      }
+
+      /**
+       * Looks up the site in the thread-local cache (validated by contents,
+       * as non-static sites may reuse addresses), appends a site record for
+       * sites new in this thread, output epoch, and capture buffer. Returns
+       * the site id.
+       */
+      static std::uint32_t lookup_site(format_streambuf& buf, cache_type& c, const check_site& site, unsigned thread, std::uint64_t time_us)
+      {
+        site_slot& cs = c.sites[slot_of(&site)];
+        if((cs.key == &site) && (cs.file == site.file) && (cs.line == site.line) && (cs.kind == site.kind) && (cs.expr == site.expr) && (cs.expr_rhs == site.expr_rhs)) {
+          return cs.id;
+        }
+        cs = site_slot{&site, site.file, site.line, site.kind, site.expr, site.expr_rhs, ++c.next_id};
+        const std::size_t n_file = site.file ? std::strlen(site.file) : 0;
+        const std::size_t n_expr = site.expr ? std::strlen(site.expr) : 0;
+        const std::size_t n_rhs = site.expr_rhs ? std::strlen(site.expr_rhs) : 0;
+        char line_kind[5];
+        put(line_kind, std::uint32_t(site.line), 4);
+        line_kind[4] = char(site.kind);
+        append_header(buf, type_site, thread, time_us, cs.id, sizeof(line_kind) + n_file + n_expr + n_rhs + 3);
+        buf.append(line_kind, sizeof(line_kind));
+        buf.append(site.file ? site.file : "", n_file + 1);
+        buf.append(site.expr ? site.expr : "", n_expr + 1);
+        buf.append(site.expr_rhs ? site.expr_rhs : "", n_rhs + 1);
+        return cs.id;
+      }
+
+      /**
+       * Looks up a string literal, appends a literal record for literals
+       * new in this thread, output epoch, and capture buffer. Returns the
+       * literal id.
+       */
+      static std::uint32_t lookup_literal(format_streambuf& buf, cache_type& c, const char* s, std::size_t n, unsigned thread, std::uint64_t time_us)
+      {
+        literal_slot& ls = c.literals[slot_of(s)];
+        if((ls.key == s) && (ls.text.size() == n) && (std::memcmp(ls.text.data(), s, n) == 0)) return ls.id;
+        ls.key = s;
+        ls.id = ++c.next_id;
+        ls.text.assign(s, n);
+        append_header(buf, type_literal, thread, time_us, ls.id, n);
+        buf.append(s, n);
+        return ls.id;
+      }
+
+      static bool parse_site(const record& rec, site_info& site)
+      {
+        const std::string& p = rec.payload;
+        if(p.size() < 8) return false;
+        site.line = int(std::int32_t(std::uint32_t(get(reinterpret_cast<const unsigned char*>(p.data()), 4))));
+        site.kind = check_kind(static_cast<unsigned char>(p[4]));
+        const std::size_t file_end = p.find('\0', 5);
+        const std::size_t expr_end = (file_end == std::string::npos) ? file_end : p.find('\0', file_end+1);
+        const std::size_t rhs_end = (expr_end == std::string::npos) ? expr_end : p.find('\0', expr_end+1);
+        if(rhs_end == std::string::npos) return false;
+        site.file = p.substr(5, file_end-5);
+        site.expr = p.substr(file_end+1, expr_end-file_end-1);
+        site.expr_rhs = p.substr(expr_end+1, rhs_end-expr_end-1);
+        return true;
+      }
+
+      /**
+       * Renders the message items of a check record, values formatted like
+       * in the default state of the record stream.
+       */
+      static bool render(const record& rec, const site_info& site, const std::unordered_map<std::uint64_t, std::string>& literals, std::ostringstream& values, std::string& message)
+      {
+        const std::string& p = rec.payload;
+        message.clear();
+        std::size_t pos = 0;
+        while(pos < p.size()) {
+          const unsigned item = static_cast<unsigned char>(p[pos++]);
+          std::uint64_t v = item & ~unsigned(item_short_literal);
+          switch((item & item_short_literal) ? unsigned(item_short_literal) : item) {
+            case item_expr:
+              message.append(site.expr);
+              break;
+            case item_expr_rhs:
+              message.append(site.expr_rhs);
+              break;
+            case item_literal:
+            case item_short_literal: {
+              if((item == item_literal) && (!get_varint(p, pos, v))) return false;
+              const auto it = literals.find((rec.thread << 32) ^ v);
+              if(it == literals.end()) return false;
+              message.append(it->second);
+              break;
+            }
+            case item_text:
+              if((!get_varint(p, pos, v)) || (v > (p.size()-pos))) return false;
+              message.append(p, pos, std::size_t(v));
+              pos += std::size_t(v);
+              break;
+            case item_formatted:
+              if((p.size()-pos) < 4) return false;
+              v = get(reinterpret_cast<const unsigned char*>(p.data()+pos), 4);
+              pos += 4;
+              if(v > (p.size()-pos)) return false;
+              message.append(p, pos, std::size_t(v));
+              pos += std::size_t(v);
+              break;
+            case item_int:
+            case item_uint:
+            case item_float:
+              values.str(std::string());
+              values.clear();
+              values.flags(std::ios_base::dec|std::ios_base::skipws);
+              values.precision(6);
+              if(item == item_float) {
+                if((p.size()-pos) < 8) return false;
+                v = get(reinterpret_cast<const unsigned char*>(p.data()+pos), 8);
+                pos += 8;
+                double d = 0;
+                std::memcpy(&d, &v, sizeof(d));
+                values << d;
+              } else {
+                if(!get_varint(p, pos, v)) return false;
+                if(item == item_int) values << std::int64_t((v >> 1) ^ (~(v & 1u) + 1u)); else values << v;
+              }
+              message.append(values.str());
+              break;
+            default:
+              return false;
+          }
+        }
+        return true;
+      }
+    };
+
+    template <typename=void>
+    class microtest
+    {
+    public:
+
+      /**
+       * Returns the number of failed checks.
+       * @return std::uint64_t
+       */
+      static std::uint64_t num_fails() noexcept
+      { return counters::fails(); }
+
+      /**
+       * Returns the number of warnings.
+       * @return std::uint64_t
+       */
+      static std::uint64_t num_warnings() noexcept
+      { return counters::warns(); }
+
+      /**
+       * Returns the number of warnings.
+       * @return std::uint64_t
+       */
+      static std::uint64_t num_passed() noexcept
+      { return counters::checks()-counters::fails(); }
+
+      /**
+       * Returns the number of checks
+       * @return std::uint64_t
+       */
+      static std::uint64_t num_checks() noexcept
+      { return counters::checks(); }
+
+      /**
+       * Output formats of the log records, see `reporter()`.
+       */
+      enum reporter_type : unsigned {
+        report_text=0,  // Human readable `[pass] [@file:line] ...` records (default).
+        report_jsonl,   // One JSON object per record (JSON Lines).
+        report_junit,   // JUnit XML test suite, one `<testcase>` per logged check or test case.
+        report_tap,     // Test Anything Protocol (version 13), plan at the end.
+        report_binary   // Compact binary records, see `detail::binary_log`.
+      };
+
+      /**
+       * Sets the output format of the log records. Structured reporters write
+       * the site (file, line, check kind, expression), the message (values),
+       * the thread, and the time since start of each record, and are not
+       * flushed per record. A given `suite` name (JUnit test suite) starts a
+       * new suite/TAP plan, otherwise the reporter can be switched temporarily.
+       * @param reporter_type type
+       * @param const char* suite
+       */
+      static void reporter(reporter_type type, const char* suite=nullptr) noexcept
+      {
+        flush();
+        std::lock_guard<std::mutex> lck(iolock_);
+        reporter_ = type;
+        reporter_set_ = true;
+        ++output_epoch_;
+        if(suite) { reporter_suite_ = suite; suite_open_ = false; }
+      }
+
+      /**
+       * Sets the reporter given in the `MICROTEST_REPORTER` environment
+       * variable (`text`, `jsonl`, `junit`, `tap`, `binary`), unless a
+       * reporter was already set explicitly.
+       * @param const char* suite
+       */
+      static void environment_reporter(const char* suite) noexcept
+      {
+        reporter_type type = report_text;
+        if((!reporter_set_) && parse_reporter(std::getenv("MICROTEST_REPORTER"), type)) reporter(type, suite);
+      }
+
+      /**
+       * Returns the output format of the log records.
+       * @return reporter_type
+       */
+      static reporter_type reporter() noexcept
+      { return reporter_; }
+
+      /**
+       * Parses a reporter name (`text`, `jsonl`, `junit`, `tap`, `binary`).
+       * @param const char* name
+       * @param reporter_type& type
+       * @return bool
+       */
+      static bool parse_reporter(const char* name, reporter_type& type) noexcept
+      {
+        static const char* const names[5] = { "text", "jsonl", "junit", "tap", "binary" };
+        for(unsigned i=0; (name != nullptr) && (i<5); ++i) {
+          if(std::strcmp(name, names[i]) == 0) { type = reporter_type(i); return true; }
+        }
+        return false;
+      }
+
+      /**
+       * Logs the result of a test case, see `test_case()`.
+       * @param const check_site& site
+       * @param const char* name
+       * @param std::uint64_t checks
+       * @param std::uint64_t fails
+       * @param std::uint64_t warns
+       * @param double ms
+       */
+      static void case_result(const check_site& site, const char* name, std::uint64_t checks, std::uint64_t fails, std::uint64_t warns, double ms) noexcept
+      {
+        if((reporter_ != report_text) && (reporter_ != report_binary)) {
+          if(!has_output()) return;
+          const case_stats cs{name, checks, fails, warns, ms};
+          try { report_record(fails ? osout_fail : osout_pass, site, record_formatter<>::text{"", 0}, &cs); } catch(...) { fatal(); }
+        } else if(!fails) {
+          comment(site, "case '", name, "': passed (", checks, " checks, ", warns, " warnings, ", ms, "ms)");
+        } else {
+          comment(site, "case '", name, "': ", fails, " of ", checks, " checks failed (", warns, " warnings, ", ms, "ms)");
+        }
+      }
+
+      /**
+       * Set the output stream for the testing. By default, the stream is
+       * flushed after each record, other policies see `stream_fd()`. With
+       * `flush_on_crash`, the stream is flushed on `std::terminate()`, but
+       * not on fatal signals (not async-signal-safe).
+       * @param std::ostream& os
+       * @param unsigned flush_policy
+       * @param unsigned flush_interval_ms
+       */
+      static void stream(std::ostream& os, unsigned flush_policy=(flush_on_record|flush_on_summary), unsigned flush_interval_ms=1000) noexcept
+      {
+        flush();
+        std::lock_guard<std::mutex> lck(iolock_);
+        flush_policy_ = flush_policy;
+        flush_interval_ = std::chrono::milliseconds(flush_interval_ms);
+        fdout().fd(-1);
+        os_ = &os;
+        os_flushed_ = std::chrono::steady_clock::now();
+        ++output_epoch_;
+        if(flush_policy & flush_on_crash) crash_hooks<>::add(&crash_flush);
+      }
+
+      /**
+       * Flush policy flags for `stream()` and `stream_fd()`. There is no
+       * timer thread, `flush_on_interval` is checked when the next record is
+       * written, so output of a test that stops logging (e.g. hangs) remains
+       * buffered until it is flushed otherwise (fail, summary, SIGTERM).
+       */
+      enum flush_policy_flags : unsigned {
+        flush_on_fail=0x1,     // Flush when a fail is logged.
+        flush_on_summary=0x2,  // Flush on `summary()`.
+        flush_on_interval=0x4, // Flush on the next record when the last flush is older than the interval.
+        flush_on_crash=0x8,    // Best-effort flush on fatal signals and `std::terminate()`.
+        flush_on_record=0x10   // Flush after each record (batch of the async writer).
+      };
+
+      /**
+       * Set a raw file descriptor (e.g. STDOUT_FILENO) as output. Records are
+       * collected in a large user space buffer and written in batches, flushed
+       * according to the given policy, and when the program exits normally.
+       * The descriptor is not closed by the test harness.
+       * @param int fd
+       * @param unsigned flush_policy
+       * @param unsigned flush_interval_ms
+       */
+      static void stream_fd(int fd, unsigned flush_policy=(flush_on_fail|flush_on_summary|flush_on_crash), unsigned flush_interval_ms=1000) noexcept
+      {
+        flush();
+        std::lock_guard<std::mutex> lck(iolock_);
+        flush_policy_ = flush_policy;
+        flush_interval_ = std::chrono::milliseconds(flush_interval_ms);
+        fdout().fd(fd);
+        os_ = nullptr;
+        ++output_epoch_;
+        if(flush_policy & flush_on_crash) crash_hooks<>::add(&crash_flush);
+      }
+
+      /**
+       * Sets the default output, STDOUT via `std::cout` (with
+       * `WITHOUT_MICROTEST_IOSTREAM` via the raw file descriptor).
+       */
+      static void default_stream() noexcept
+      {
+        #ifndef WITHOUT_MICROTEST_IOSTREAM
+        stream(std::cout);
+        #else
+        stream_fd(1);
+        #endif
+      }
+
+      /**
+       * Writes all pending log records to the output.
+       */
+      static void flush() noexcept
+      {
+        #ifdef WITH_MICROTEST_ASYNC_LOG
+        async::flush();
+        #endif
+        std::lock_guard<std::mutex> lck(iolock_);
+        try {
+          fdout().flush();
+          if(os_) { os_->flush(); os_flushed_ = std::chrono::steady_clock::now(); }
+        } catch(...) {
+          fatal();
+        }
+      }
+
+      /**
+       * Switches the asynchronous logging mode on/off. In async mode,
+       * checking threads only append pre-formatted records to thread
+       * local ring buffers, which a background thread writes to the
+       * output stream. `summary()` and `flush()` drain the buffers.
+       * No effect without `WITH_MICROTEST_ASYNC_LOG`.
+       * @param bool enable
+       */
+      static void async_log(bool enable) noexcept
+      {
+        #ifdef WITH_MICROTEST_ASYNC_LOG
+        (void)fdout(); // constructed before (and destroyed after) the writer.
+        if(enable) crash_hooks<>::add(&crash_flush);
+        async::enable(enable, &write_out);
+        #else
+        (void)enable;
+        #endif
+      }
+
+      /**
+       * Returns true if the asynchronous logging mode is active.
+       * @return bool
+       */
+      static bool async_log() noexcept
+      {
+        #ifdef WITH_MICROTEST_ASYNC_LOG
+        return async::enabled();
+        #else
+        return false;
+        #endif
+      }
+
+      /**
+       * Returns true if ANSI color printing is allowed
+       * for TTY STDOUT.
+       * @return bool
+       */
+      static bool ansi_colors() noexcept
+      { return ansi_colors_; }
+
+      /**
+       * Sets if ANSI color printing is allowed
+       * for TTY STDOUT.
+       * @param bool enable
+       */
+      static void ansi_colors(bool enable) noexcept
+      {
+        #ifdef WITH_MICROTEST_ANSI_COLORS_FORCED
+          ansi_colors_ = true;
+        #else
+          ansi_colors_ = enable;
+        #endif
+        #ifdef __WINDOWS__
+        {
+          #ifndef ENABLE_VIRTUAL_TERMINAL_PROCESSING
+            #define ENABLE_VIRTUAL_TERMINAL_PROCESSING 0x0004
+          #endif
+          const HANDLE hout = ::GetStdHandle(STD_OUTPUT_HANDLE);
+          DWORD conmode = 0;
+          if(hout && ::GetConsoleMode(hout, &conmode)) {::SetConsoleMode(hout, conmode|ENABLE_VIRTUAL_TERMINAL_PROCESSING);}
+        }
+        #endif
+      }
+
+      /**
+       * Register a succeeded expectation, increases test counter, prints message.
+       * The arguments are only formatted if pass logging is on, otherwise
+       * this is only a counter increment.
+       * @param const check_site& site
+       * @param typename ...Args args
+       */
+      template <typename ...Args>
+      static bool pass(const check_site& site, Args&& ...args)
+      {
+        counters::inc_checks();
+        #ifndef WITHOUT_MICROTEST_PASS_LOG_CODE
+        if(!omit_passes_) pass_log(site, std::forward<Args>(args)...);
+        #else
+        (void)site; discard(args...);
+        #endif
+        return true;
+      }
+
+      /**
+       * Register a succeeded expectation, increases test counter, prints message.
+       * @param const char* file
+       * @param int line
+       * @param typename ...Args args
+       */
+      template <typename ...Args>
+      static bool pass(const char* file, int line, Args&& ...args)
+      { return pass(check_site{file, line, check_kind::pass, nullptr, nullptr}, std::forward<Args>(args)...); }
+
+      /**
+       * Register pass without logging
+       * @return bool
+       */
+      static bool pass() noexcept
+      { counters::inc_checks(); return true; }
+
+      /**
+       * Register a failed expectation, increase test counter and fail counter, prints message
+       * @param const check_site& site
+       * @param typename ...Args args
+       */
+      template <typename ...Args>
+      static bool fail(const check_site& site, Args&& ...args)
+      { counters::inc_fails(); osout(osout_fail, site, std::forward<Args>(args)...); return false; }
+
+      /**
+       * Register a failed expectation, increase test counter and fail counter, prints message
+       * @param const char* file
+       * @param int line
+       * @param typename ...Args args
+       */
+      template <typename ...Args>
+      static bool fail(const char* file, int line, Args&& ...args)
+      { return fail(check_site{file, line, check_kind::fail, nullptr, nullptr}, std::forward<Args>(args)...); }
+
+      /**
+       * Register fail without logging
+       * @return bool
+       */
+      static bool fail() noexcept
+      { counters::inc_fails(); return false; }
+
+      /**
+       * Register a check result, optionally tests are
+       * not logged using the `silent` flag.
+       * Note that `file` is not `nullptr` checked and
+       * expected to be always `__FILE__`.
+       * @tparam typename ...Args
+       * @param bool passed
+       * @param const char* file
+       * @param int line
+       * @param bool silent
+       * @param Args ...args
+       * @return bool
+       */
+      template <typename ...Args>
+      static bool commit(bool passed, const char* file, int line, Args&& ...args)
+      { return (passed) ? pass(file, line, std::forward<Args>(args)...) : fail(file, line, std::forward<Args>(args)...); }
+
+      /**
+       * Register a check result, logged with the expression text of the site.
+       * @param bool passed
+       * @param const check_site& site
+       * @return bool
+       */
+      static bool commit(bool passed, const check_site& site)
+      { const char* expr = site.expr ? site.expr : ""; return (passed) ? pass(site, expr) : fail(site, expr); }
+
+      /**
+       * Register a check result, logged with the given message arguments.
+       * @tparam typename ...Args
+       * @param bool passed
+       * @param const check_site& site
+       * @param Args ...args
+       * @return bool
+       */
+      template <typename Arg, typename ...Args>
+      static bool commit(bool passed, const check_site& site, Arg&& arg, Args&& ...args)
+      { return (passed) ? pass(site, std::forward<Arg>(arg), std::forward<Args>(args)...) : fail(site, std::forward<Arg>(arg), std::forward<Args>(args)...); }
+
+      /**
+       * Register a check result without logging.
+       * @param bool passed
+       * @return bool
+       */
+      static bool commit(bool passed) noexcept
+      { return (passed) ? pass() : fail(); }
+
+      /**
+       * Passes if operator==() yields true, fails otherwise.
+       * Note: Expects `site.expr` and `site.expr_rhs` (or `a_code` and `b_code`) to be non-`nullptr`.
+       */
+      template<typename T1, typename T2>
+      static bool check_eq(const T1& a, const T2& b, const check_site& site)
+      {
+        using namespace std;
+        if(a == b) {
+          return pass(site, site.expr, " == ", site.expr_rhs, "   (=", operand_ref::of(a), ")");
+        } else {
+          return fail(site, site.expr, " == ", site.expr_rhs, "   (", operand_ref::of(a), " != ",  operand_ref::of(b), ")");
+        }
+      }
+
+      template<typename T1, typename T2>
+      static bool check_eq(const T1& a, const T2& b, const char* file, int line, const char* a_code, const char* b_code)
+      { return check_eq(a, b, check_site{file, line, check_kind::eq, a_code, b_code}); }
+
+      /**
+       * Passes if operator!=() yields true, fails otherwise.
+       * Note: Expects `site.expr` and `site.expr_rhs` (or `a_code` and `b_code`) to be non-`nullptr`.
+       */
+      template<typename T1, typename T2>
+      static bool check_ne(const T1& a, const T2& b, const check_site& site)
+      {
+        using namespace std;
+        if(a != b) {
+          return pass(site, site.expr, " != ", site.expr_rhs, "   (", operand_ref::of(a), " != ", operand_ref::of(b), ")");
+        } else {
+          return fail(site, site.expr, " != ", site.expr_rhs, "   (both =", operand_ref::of(a), ")");
+        }
+      }
+
+      template<typename T1, typename T2>
+      static bool check_ne(const T1& a, const T2& b, const char* file, int line, const char* a_code, const char* b_code)
+      { return check_ne(a, b, check_site{file, line, check_kind::ne, a_code, b_code}); }
+
+      /**
+       * Passes if operator>() yields true, fails otherwise.
+       * Note: Expects `site.expr` and `site.expr_rhs` (or `a_code` and `b_code`) to be non-`nullptr`.
+       */
+      template<typename T1, typename T2>
+      static bool check_gt(const T1& a, const T2& b, const check_site& site)
+      {
+        using namespace std;
+        if(a > b) {
+          return pass(site, site.expr, " > ", site.expr_rhs, "   (", operand_ref::of(a), " > ", operand_ref::of(b), ")");
+        } else {
+          return fail(site, site.expr, " > ", site.expr_rhs, "   (", operand_ref::of(a), " <= ", operand_ref::of(b), ")");
+        }
+      }
+
+      template<typename T1, typename T2>
+      static bool check_gt(const T1& a, const T2& b, const char* file, int line, const char* a_code, const char* b_code)
+      { return check_gt(a, b, check_site{file, line, check_kind::gt, a_code, b_code}); }
+
+      /**
+       * Passes if operator<() yields true, fails otherwise.
+       * Note: Expects `site.expr` and `site.expr_rhs` (or `a_code` and `b_code`) to be non-`nullptr`.
+       */
+      template<typename T1, typename T2>
+      static bool check_lt(const T1& a, const T2& b, const check_site& site)
+      {
+        using namespace std;
+        if(a < b) {
+          return pass(site, site.expr, " < ", site.expr_rhs, "   (", operand_ref::of(a), " < ", operand_ref::of(b), ")");
+        } else {
+          return fail(site, site.expr, " < ", site.expr_rhs, "   (", operand_ref::of(a), " >= ", operand_ref::of(b), ")");
+        }
+      }
+
+      template<typename T1, typename T2>
+      static bool check_lt(const T1& a, const T2& b, const char* file, int line, const char* a_code, const char* b_code)
+      { return check_lt(a, b, check_site{file, line, check_kind::lt, a_code, b_code}); }
+
+      /**
+       * Passes if operator>=() yields true, fails otherwise.
+       * Note: Expects `site.expr` and `site.expr_rhs` (or `a_code` and `b_code`) to be non-`nullptr`.
+       */
+      template<typename T1, typename T2>
+      static bool check_ge(const T1& a, const T2& b, const check_site& site)
+      {
+        using namespace std;
+        if(a >= b) {
+          return pass(site, site.expr, " >= ", site.expr_rhs, "   (", operand_ref::of(a), " >= ", operand_ref::of(b), ")");
+        } else {
+          return fail(site, site.expr, " >= ", site.expr_rhs, "   (", operand_ref::of(a), " < ", operand_ref::of(b), ")");
+        }
+      }
+
+      template<typename T1, typename T2>
+      static bool check_ge(const T1& a, const T2& b, const char* file, int line, const char* a_code, const char* b_code)
+      { return check_ge(a, b, check_site{file, line, check_kind::ge, a_code, b_code}); }
+
+      /**
+       * Passes if operator<=() yields true, fails otherwise.
+       * Note: Expects `site.expr` and `site.expr_rhs` (or `a_code` and `b_code`) to be non-`nullptr`.
+       */
+      template<typename T1, typename T2>
+      static bool check_le(const T1& a, const T2& b, const check_site& site)
+      {
+        using namespace std;
+        if(a <= b) {
+          return pass(site, site.expr, " <= ", site.expr_rhs, "   (", operand_ref::of(a), " <= ", operand_ref::of(b), ")");
+        } else {
+          return fail(site, site.expr, " <= ", site.expr_rhs, "   (", operand_ref::of(a), " > ", operand_ref::of(b), ")");
+        }
+      }
+
+      template<typename T1, typename T2>
+      static bool check_le(const T1& a, const T2& b, const char* file, int line, const char* a_code, const char* b_code)
+      { return check_le(a, b, check_site{file, line, check_kind::le, a_code, b_code}); }
+
+      /**
+       * Print a comment
+       * @param const check_site& site
+       * @param typename ...Args args
+       */
+      template <typename ...Args>
+      static void comment(const check_site& site, Args&& ...args) noexcept
+      { osout(osout_note, site, std::forward<Args>(args)...); }
+
+      /**
+       * Print a comment
+       * @param const char* file
+       * @param int line
+       * @param typename ...Args args
+       */
+      template <typename ...Args>
+      static void comment(const char* file, int line, Args&& ...args) noexcept
+      { comment(check_site{file, line, check_kind::note, nullptr, nullptr}, std::forward<Args>(args)...); }
+
+      /**
+       * Print an information record (e.g. measurements), without
+       * registering a check.
+       * @param const check_site& site
+       * @param typename ...Args args
+       */
+      template <typename ...Args>
+      static void info(const check_site& site, Args&& ...args) noexcept
+      { osout(osout_info, site, std::forward<Args>(args)...); }
+
+      /**
+       * Print a warning
+       * @param const check_site& site
+       * @param typename ...Args args
+       */
+      template <typename ...Args>
+      static void warning(const check_site& site, Args&& ...args) noexcept
+      { counters::inc_warns(); osout(osout_warn, site, std::forward<Args>(args)...); }
+
+      /**
+       * Print a warning
+       * @param const char* file
+       * @param int line
+       * @param typename ...Args args
+       */
+      template <typename ...Args>
+      static void warning(const char* file, int line, Args&& ...args) noexcept
+      { warning(check_site{file, line, check_kind::warn, nullptr, nullptr}, std::forward<Args>(args)...); }
+
+      /**
+       * Print summary, return 0 on pass, 1 .. 99 on fail.
+       * @return int
+       */
+      static int summary() noexcept
+      {
+        const std::uint64_t n_checks = counters::checks();
+        const std::uint64_t n_fails = counters::fails();
+        const std::uint64_t n_warns = counters::warns();
+        if(fail_log_limit_ && has_output()) fail_site_summary();
+        if(section_report_limit_ && has_output()) section_summary();
+        if((reporter_ != report_text) && (reporter_ != report_binary)) {
+          if(has_output()) { try { report_summary(n_checks, n_fails, n_warns); } catch(...) { fatal(); } }
+        } else try {
+          const bool ansi = ansi_colors() && (reporter_ == report_text);
+          std::stringstream ss;
+          if(!n_fails) {
+            if(!n_checks) {
+              ss << (ansi ? "\033[0;33m[DONE]\033[0m" : "[DONE]") << " No checks" << "\n";
+            } else if(n_warns) {
+              ss << (ansi ? "\033[0;33m[PASS]\033[0m" : "[PASS]") << " All " << n_checks << " checks passed, " << n_warns << " warnings." << "\n";
+            } else {
+              ss << (ansi ? "\033[0;32m[PASS]\033[0m" : "[PASS]") << " All " << n_checks << " checks passed, " << n_warns << " warnings." << "\n";
+            }
+          } else {
+            ss << (ansi ? "\033[0;31m[FAIL]\033[0m" : "[FAIL]") << " " << n_fails << " of " << n_checks << " checks failed, " << n_warns << " warnings." << "\n";
+          }
+          const std::string rec = ss.str();
+          if(reporter_ == report_binary) {
+            if(has_output()) {
+              open_suite();
+              record_formatter<> bin;
+              detail::binary_log<>::append_text(bin.buf(), thread_index(), std::uint64_t(elapsed_us()), rec.data(), rec.size());
+              emit(bin.buf().data(), bin.buf().size(), osout_info);
+            }
+          } else {
+            emit(rec.data(), rec.size(), osout_info);
+          }
+        } catch(...) {
+          ;
+        }
+        if(flush_policy_ & flush_on_summary) {
+          flush();
+        } else {
+          #ifdef WITH_MICROTEST_ASYNC_LOG
+          async::flush();
+          #endif
+        }
+        return int((n_fails > 99u) ? (99u) : (n_fails));
+      }
+
+      /**
+       * Print build information
+       */
+      static void buildinfo(const char* file, int line) noexcept
+      { osout(osout_info, check_site{file, line, check_kind::info, nullptr, nullptr}, detail::buildinfo<>::info()); }
+
+      /**
+       * Switch logging of "[pass] ...." on/off. Useful for bulk tests
+       * where only the fails and comments shall be printed. Note that
+       * the passes are still counted, only not written to the output.
+       * No effect with `WITHOUT_MICROTEST_PASS_LOG_CODE` (always off).
+       * @param bool switch_off
+       */
+      static void omit_pass_log(bool switch_off) noexcept
+      { omit_passes_ = switch_off || MICROTEST_UTEST_STRIP_PASS_LOGS; }
+
+      /**
+       * Returns if logging of "[pass] ...." is off.
+       * @return bool
+       */
+      static bool omit_pass_log() noexcept
+      { return omit_passes_; }
+
+      /**
+       * Sets the maximum number of logged fails per check site (0: unlimited).
+       * Further fails of a site are counted, and `summary()` lists the number
+       * of fails, and the first and last failing messages of each site.
+       * @param unsigned limit
+       */
+      static void fail_log_limit(unsigned limit) noexcept
+      { fail_log_limit_ = limit; }
+
+      /**
+       * Returns the maximum number of logged fails per check site (0: unlimited).
+       * @return unsigned
+       */
+      static unsigned fail_log_limit() noexcept
+      { return fail_log_limit_; }
+
+      /**
+       * Sets the maximum number of `test_section()`s listed in the summary,
+       * slowest first (default 10, 0: no section report).
+       * @param unsigned limit
+       */
+      static void section_report_limit(unsigned limit) noexcept
+      { section_report_limit_ = limit; }
+
+      /**
+       * Returns the maximum number of `test_section()`s listed in the summary.
+       * @return unsigned
+       */
+      static unsigned section_report_limit() noexcept
+      { return section_report_limit_; }
+
+      /**
+       * Sets the seed of the random generators (`test_random`) to
+       * reproduce a test run. Default is the environment variable
+       * `MICROTEST_SEED` or the `--seed=` argument, else random.
+       * @param std::uint64_t seed
+       */
+      static void random_seed(std::uint64_t seed) noexcept
+      { ::sw::utest::detail::random_seed<>::set(seed); }
+
+      /**
+       * Returns the seed of the random generators, which is also
+       * printed in the build information line.
+       * @return std::uint64_t
+       */
+      static std::uint64_t random_seed() noexcept
+      { return ::sw::utest::detail::random_seed<>::get(); }
+
+      /**
+       * Resets the test statistics
+       */
+      static void reset() noexcept
+      { counters::reset(); fail_sites<>::reset(); test_sections<>::reset(); }
+
+      /**
+       * Resets the test statistics
+       */
+      static void reset(const char* file, int line) noexcept
+      { reset(); osout(osout_note, check_site{file, line, check_kind::note, nullptr, nullptr}, "Test statistics reset."); }
+
+      /**
+       * Redirects the log records of the current thread into `buffer`,
+       * `nullptr` ends the capture. Used to keep the output of test cases
+       * running in parallel grouped per case.
+       * @param std::string* buffer
+       */
+      static void capture(std::string* buffer) noexcept
+      { capture_target() = buffer; }
+
+      /**
+       * Returns the capture buffer of the current thread, or `nullptr`.
+       * @return std::string*
+       */
+      static std::string* capture() noexcept
+      { return capture_target(); }
+
+      /**
+       * Writes captured log records to the output.
+       * @param const std::string& records
+       * @param bool failed
+       */
+      static void write_captured(const std::string& records, bool failed) noexcept
+      {
+        if(records.empty()) return;
+        ++output_epoch_; // (binary log site records of other threads/processes in between)
+        emit(records.data(), records.size(), failed ? osout_fail : osout_note);
+      }
+
+      /**
+       * Returns true if the standard output is bound to a console.
+       * @return bool
+       */
+      static bool istty() noexcept
+      {
+        #ifndef _MSC_VER
+        return bool(::isatty(STDOUT_FILENO));
+        #else
+        return bool(_isatty(1));
+        #endif
+      }
+
+    private:
+
+      using counters = check_counters<>;
+      #ifdef WITH_MICROTEST_ASYNC_LOG
+      using async = async_writer<>;
+      #endif
+
+      enum {osout_pass=0, osout_fail, osout_warn, osout_note, osout_info };
+
+      #ifndef WITHOUT_MICROTEST_PASS_LOG_CODE
+      /**
+       * Out-of-line formatting of pass records, keeps the
+       * check call sites small.
+       */
+      template <typename ...Args>
+      MICROTEST_UTEST_COLD static void pass_log(const check_site& site, Args&& ...args) noexcept
+      { osout(osout_pass, site, std::forward<Args>(args)...); }
+      #else
+      template <typename ...Args>
+      static void discard(const Args& ...) noexcept
+      {}
+      #endif
+
+      /**
+       * Logs a record. Only the message arguments are formatted in the
+       * template, the record framing is done by `open_record()` and
+       * `close_record()`.
+       */
+      template <typename ...Args>
+      static void osout(unsigned what, const check_site& site, Args&& ...args) noexcept
+      {
+        try {
+          if(!has_output()) return;
+          if(fail_log_limit_ && ((what == osout_fail) || (what > osout_info)) && (!fail_logged(site, args...))) return;
+          if(reporter_ == report_binary) { binary_record(what, site, std::forward<Args>(args)...); return; }
+          record_formatter<> rec;
+          open_record(what, site, rec);
+          push_stream(rec.os(), std::forward<Args>(args)...);
+          close_record(what, site, rec);
+        } catch(...) {
+          fatal();
+        }
+      }
+
+      /**
+       * Counts a fail for the per-site log limit, returns true if it shall
+       * be logged. The message is kept as items for the summary (needed for
+       * the last failing message): Arithmetic operands are stored as values,
+       * strings and other types are still formatted, only the record text
+       * of fails beyond the limit is not composed.
+       */
+      template <typename ...Args>
+      static bool fail_logged(const check_site& site, const Args& ...args)
+      {
+        record_formatter<> items;
+        binary_log<>::encoder enc(items, site);
+        binary_items(enc, args...);
+        return fail_sites<>::add(site, items.buf().data(), items.buf().size(), fail_log_limit_);
+      }
+
+      /**
+       * Writes a binary log record, the message arguments as items (see
+       * `binary_log`).
+       */
+      template <typename ...Args>
+      static void binary_record(unsigned what, const check_site& site, Args&& ...args)
+      {
+        what = (what > static_cast<unsigned>(osout_info)) ? static_cast<unsigned>(osout_fail) : what;
+        open_suite();
+        record_formatter<> rec, payload;
+        binary_log<>::encoder enc(rec.buf(), payload, site, output_epoch_.load(std::memory_order_relaxed), capture_target(), thread_index(), std::uint64_t(elapsed_us()));
+        binary_items(enc, std::forward<Args>(args)...);
+        enc.finish(what);
+        emit(rec.buf().data(), rec.buf().size(), what);
+      }
+
+      template <typename T, typename ...Args>
+      static void binary_items(binary_log<>::encoder& enc, T&& v, Args&& ...args)
+      { enc.add(std::forward<T>(v)); binary_items(enc, std::forward<Args>(args)...); }
+
+      static void binary_items(binary_log<>::encoder&) noexcept
+      {}
+
+      /**
+       * Writes the text record prefix (result tag and site). Structured
+       * records only contain the message until `close_record()`.
+       */
+      static void open_record(unsigned what, const check_site& site, record_formatter<>& rec)
+      {
+        static const char* captions[5] = { "pass", "fail", "warn", "note", "info" };
+        static const char* caption_colors[5] = { "\033[0;32m", "\033[0;31m", "\033[0;33m", "\033[0;37m", "\033[0;34m" };
+        static const char* color_reset = "\033[0m";
+        if(reporter_ != report_text) return;
+        what = (what > static_cast<unsigned>(osout_info)) ? static_cast<unsigned>(osout_fail) : what;
+        const bool ansi = ansi_colors();
+        format_streambuf& buf = rec.buf();
+        if(ansi) buf.append(caption_colors[what]);
+        buf.append("["); buf.append(captions[what]); buf.append("]");
+        if(ansi) buf.append(color_reset);
+        buf.append(" ");
+        if(site.file && *site.file) {
+          if(ansi) buf.append("\033[0;36m");
+          buf.append("[@"); buf.append(site.file); buf.append(":"); rec.os() << site.line; buf.append("]");
+          if(ansi) buf.append(color_reset);
+          buf.append(" ");
+        }
+        buf.indent("          ");
+      }
+
+      /**
+       * Completes the record formatted by `open_record()` and the message
+       * arguments, and passes it to the output.
+       */
+      static void close_record(unsigned what, const check_site& site, record_formatter<>& rec)
+      {
+        what = (what > static_cast<unsigned>(osout_info)) ? static_cast<unsigned>(osout_fail) : what;
+        format_streambuf& buf = rec.buf();
+        buf.indent(nullptr);
+        if(reporter_ != report_text) {
+          report_record(what, site, rec.str(), nullptr);
+          return;
+        }
+        if(ansi_colors()) buf.append("\033[0m");
+        buf.append("\n");
+        emit(buf.data(), buf.size(), what);
+      }
+
+      /**
+       * Structured data of a test case result record.
+       */
+      struct case_stats
+      {
+        const char* name;
+        std::uint64_t checks;
+        std::uint64_t fails;
+        std::uint64_t warns;
+        double ms;
+      };
+
+      enum { escape_json=0, escape_xml, escape_tap };
+
+      /**
+       * Appends text escaped for JSON strings, XML attributes/comments,
+       * or single TAP lines.
+       */
+      static void append_escaped(format_streambuf& buf, const char* s, std::size_t n, unsigned mode)
+      {
+        static const char hex[] = "0123456789abcdef";
+        for(const char* const end = s+n; s < end; ++s) {
+          const char c = *s;
+          const unsigned char u = static_cast<unsigned char>(c);
+          switch(mode) {
+            case escape_json:
+              if(c == '"') { buf.append("\\\""); }
+              else if(c == '\\') { buf.append("\\\\"); }
+              else if(c == '\n') { buf.append("\\n"); }
+              else if(c == '\t') { buf.append("\\t"); }
+              else if(c == '\r') { buf.append("\\r"); }
+              else if(u < 0x20) { const char e[] = {'\\','u','0','0',hex[u>>4],hex[u&0xf]}; buf.append(e, sizeof(e)); }
+              else { buf.append(s, 1); }
+              break;
+            case escape_xml:
+              if(c == '&') { buf.append("&amp;"); }
+              else if(c == '<') { buf.append("&lt;"); }
+              else if(c == '>') { buf.append("&gt;"); }
+              else if(c == '"') { buf.append("&quot;"); }
+              else if(c == '\n') { buf.append("&#10;"); }
+              else if(c == '-' && (s+1 < end) && (s[1] == '-')) { buf.append("-&#45;"); ++s; }
+              else if((u < 0x20) && (c != '\t')) { buf.append("?"); }
+              else { buf.append(s, 1); }
+              break;
+            default:
+              if(c == '\n') { buf.append("\\n"); }
+              else if(c == '#') { buf.append("\\#"); }
+              else if(c == '\\') { buf.append("\\\\"); }
+              else if((u < 0x20) && (c != '\t')) { buf.append("?"); }
+              else { buf.append(s, 1); }
+          }
+        }
+      }
+
+      static void append_escaped(format_streambuf& buf, const char* s, unsigned mode)
+      { if(s) append_escaped(buf, s, std::strlen(s), mode); }
+
+      /**
+       * Name of a check kind in structured records.
+       */
+      static const char* kind_name(check_kind k) noexcept
+      {
+        static const char* const names[] = { "expect", "eq", "ne", "gt", "lt", "ge", "le", "except", "nothrow", "pass", "fail", "warn", "note", "info", "benchmark", "noalloc" };
+        return (unsigned(k) < (sizeof(names)/sizeof(names[0]))) ? names[unsigned(k)] : "";
+      }
+
+      /**
+       * Small sequential number of the current thread for structured records.
+       */
+      static unsigned thread_index() noexcept
+      {
+        static std::atomic<unsigned> next(0);
+        static thread_local unsigned index = ++next;
+        return index;
+      }
+
+      /**
+       * Microseconds since the start of the test run.
+       */
+      static std::int64_t elapsed_us() noexcept
+      {
+        static const auto start = std::chrono::steady_clock::now();
+        return std::int64_t(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+      }
+
+      /**
+       * Writes the JUnit/TAP header (binary log version record) before the
+       * first structured record.
+       */
+      static void open_suite()
+      {
+        if(suite_open_.load(std::memory_order_acquire) || suite_open_.exchange(true)) return;
+        tap_points_ = 0;
+        record_formatter<> rec;
+        format_streambuf& buf = rec.buf();
+        if(reporter_ == report_binary) {
+          detail::binary_log<>::append_magic(buf, thread_index(), std::uint64_t(elapsed_us()));
+        } else if(reporter_ == report_junit) {
+          buf.append("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<testsuite name=\"");
+          append_escaped(buf, reporter_suite_, escape_xml);
+          buf.append("\">\n");
+        } else if(reporter_ == report_tap) {
+          buf.append("TAP version 13\n");
+        } else {
+          return;
+        }
+        emit(buf.data(), buf.size(), osout_info);
+      }
+
+      /**
+       * Formats a structured log record (JSON Lines, JUnit XML, TAP).
+       */
+      static void report_record(unsigned what, const check_site& site, record_formatter<>::text msg, const case_stats* cs)
+      {
+        static const char* results[5] = { "pass", "fail", "warn", "note", "info" };
+        open_suite();
+        const char* const file = site.file ? site.file : "";
+        record_formatter<> rec;
+        format_streambuf& buf = rec.buf();
+        std::ostream& os = rec.os();
+        switch(reporter_) {
+          case report_jsonl:
+            buf.append("{\"result\":\""); buf.append(results[what]);
+            buf.append("\",\"kind\":\""); buf.append(cs ? "case" : kind_name(site.kind));
+            buf.append("\",\"file\":\""); append_escaped(buf, file, escape_json);
+            buf.append("\",\"line\":"); os << site.line;
+            if(cs) {
+              buf.append(",\"name\":\""); append_escaped(buf, cs->name, escape_json);
+              buf.append("\",\"checks\":"); os << cs->checks;
+              buf.append(",\"fails\":"); os << cs->fails;
+              buf.append(",\"warnings\":"); os << cs->warns;
+              buf.append(",\"duration_ms\":"); os << cs->ms;
+            } else {
+              if(site.expr) { buf.append(",\"expr\":\""); append_escaped(buf, site.expr, escape_json); buf.append("\""); }
+              if(site.expr_rhs) { buf.append(",\"expr_rhs\":\""); append_escaped(buf, site.expr_rhs, escape_json); buf.append("\""); }
+              buf.append(",\"message\":\""); append_escaped(buf, msg.data, msg.size, escape_json); buf.append("\"");
+            }
+            buf.append(",\"thread\":"); os << thread_index();
+            buf.append(",\"time_us\":"); os << elapsed_us();
+            buf.append("}\n");
+            break;
+          case report_junit:
+            if(cs || (what <= osout_fail)) {
+              buf.append("  <testcase classname=\""); append_escaped(buf, reporter_suite_, escape_xml);
+              buf.append("\" name=\"");
+              if(cs) {
+                append_escaped(buf, cs->name, escape_xml);
+              } else {
+                append_escaped(buf, file, escape_xml); buf.append(":"); os << site.line;
+                if(site.expr) { buf.append(" "); append_escaped(buf, site.expr, escape_xml); }
+                if(site.expr_rhs) { buf.append(", "); append_escaped(buf, site.expr_rhs, escape_xml); }
+              }
+              char seconds[32];
+              std::snprintf(seconds, sizeof(seconds), "%.6f", cs ? (cs->ms / 1e3) : 0.0);
+              buf.append("\" time=\""); buf.append(seconds); buf.append("\"");
+              if(what == osout_fail) {
+                buf.append("><failure type=\""); buf.append(cs ? "case" : kind_name(site.kind)); buf.append("\" message=\"");
+                if(cs) {
+                  os << cs->fails; buf.append(" of "); os << cs->checks; buf.append(" checks failed");
+                } else {
+                  append_escaped(buf, file, escape_xml); buf.append(":"); os << site.line; buf.append(": ");
+                  append_escaped(buf, msg.data, msg.size, escape_xml);
+                }
+                buf.append("\"/></testcase>\n");
+              } else {
+                buf.append("/>\n");
+              }
+            } else {
+              buf.append("  <!-- ["); buf.append(results[what]); buf.append("] ");
+              append_escaped(buf, file, escape_xml); buf.append(":"); os << site.line; buf.append(" ");
+              append_escaped(buf, msg.data, msg.size, escape_xml);
+              buf.append(" -->\n");
+            }
+            break;
+          default:
+            if(cs || (what <= osout_fail)) {
+              tap_points_.fetch_add(1, std::memory_order_relaxed);
+              buf.append((what == osout_fail) ? "not ok - " : "ok - ");
+              append_escaped(buf, file, escape_tap); buf.append(":"); os << site.line; buf.append(" ");
+              if(cs) {
+                buf.append("case '"); append_escaped(buf, cs->name, escape_tap); buf.append("' (");
+                if(cs->fails) { os << cs->fails; buf.append(" of "); }
+                os << cs->checks; buf.append(cs->fails ? " checks failed, " : " checks, "); os << cs->ms; buf.append("ms)");
+              } else {
+                append_escaped(buf, msg.data, msg.size, escape_tap);
+              }
+              buf.append("\n");
+            } else {
+              buf.append("# ["); buf.append(results[what]); buf.append("] ");
+              append_escaped(buf, file, escape_tap); buf.append(":"); os << site.line; buf.append(" ");
+              append_escaped(buf, msg.data, msg.size, escape_tap);
+              buf.append("\n");
+            }
+        }
+        emit(buf.data(), buf.size(), what);
+      }
+
+      /**
+       * Message of the fail site summary, shortened to keep the summary
+       * readable for large operands.
+       */
+      static std::string shortened(std::string msg)
+      {
+        constexpr std::size_t max_size = 200;
+        if(msg.size() > max_size) { msg.resize(max_size); msg.append("..."); }
+        return msg;
+      }
+
+      /**
+       * Logs the fail counts of the check sites, if fails were not logged
+       * due to the per-site limit.
+       */
+      static void fail_site_summary() noexcept
+      {
+        try {
+          if(!fail_sites<>::suppressed()) return;
+          const std::vector<fail_sites<>::entry> sites = fail_sites<>::entries();
+          std::stringstream ss;
+          ss << "Fails per check site (" << fail_sites<>::suppressed() << " not logged, limit " << fail_log_limit_ << " per site):";
+          for(const fail_sites<>::entry& e: sites) {
+            ss << "\n[@" << (e.file ? e.file : "") << ":" << e.line << "] " << e.fails << " fails";
+            if(e.fails > fail_log_limit_) ss << " (" << (e.fails - fail_log_limit_) << " not logged)";
+            ss << ", first: " << shortened(binary_log<>::message(e.first, e.expr, e.expr_rhs));
+            if(e.fails > 1) ss << ", last: " << shortened(binary_log<>::message(e.last, e.expr, e.expr_rhs));
+          }
+          osout(osout_info, check_site{nullptr, 0, check_kind::info, nullptr, nullptr}, ss.str());
+        } catch(...) {
+          fatal();
+        }
+      }
+
+      /**
+       * Logs the slowest `test_section()`s with their share of the total
+       * run time (since the start or the last `reset()`).
+       */
+      static void section_summary() noexcept
+      {
+        try {
+          const std::vector<test_sections<>::entry> sections = test_sections<>::slowest(section_report_limit_);
+          if(sections.empty()) return;
+          const double total_ms = test_sections<>::total_ms();
+          std::stringstream ss;
+          ss << "Slowest test sections (of " << total_ms << "ms total):";
+          for(const test_sections<>::entry& e: sections) {
+            const double share = (total_ms > 0) ? (std::floor(1000.0 * e.wall_ms / total_ms + 0.5) / 10.0) : 0.0;
+            ss << "\n[@" << (e.file ? e.file : "") << ":" << e.line << "] " << e.path << ": " << e.wall_ms << "ms (" << share << "%), cpu "
+               << e.cpu_ms << "ms, " << e.runs << " runs, " << e.checks << " checks, " << e.fails << " fails";
+            for(const auto& c: e.counters) ss << ", " << c.first << "=" << c.second;
+          }
+          osout(osout_info, check_site{nullptr, 0, check_kind::info, nullptr, nullptr}, ss.str());
+        } catch(...) {
+          fatal();
+        }
+      }
+
+      /**
+       * Formats the structured summary record (and closes the JUnit suite).
+       */
+      static void report_summary(std::uint64_t n_checks, std::uint64_t n_fails, std::uint64_t n_warns)
+      {
+        open_suite();
+        record_formatter<> rec;
+        format_streambuf& buf = rec.buf();
+        std::ostream& os = rec.os();
+        const char* const result = n_fails ? "fail" : "pass";
+        switch(reporter_) {
+          case report_jsonl:
+            buf.append("{\"result\":\""); buf.append(result); buf.append("\",\"kind\":\"summary\",\"checks\":"); os << n_checks;
+            buf.append(",\"fails\":"); os << n_fails; buf.append(",\"warnings\":"); os << n_warns;
+            buf.append(",\"time_us\":"); os << elapsed_us(); buf.append("}\n");
+            break;
+          case report_junit:
+            buf.append("  <system-out>"); buf.append(n_fails ? "[FAIL] " : "[PASS] ");
+            os << n_fails; buf.append(" of "); os << n_checks; buf.append(" checks failed, "); os << n_warns; buf.append(" warnings.");
+            buf.append("</system-out>\n</testsuite>\n");
+            suite_open_ = false;
+            break;
+          default:
+            buf.append("1.."); os << tap_points_.load(std::memory_order_relaxed); buf.append("\n# "); buf.append(n_fails ? "[FAIL] " : "[PASS] ");
+            os << n_fails; buf.append(" of "); os << n_checks; buf.append(" checks failed, "); os << n_warns; buf.append(" warnings.\n");
+            suite_open_ = false;
+        }
+        emit(buf.data(), buf.size(), n_fails ? osout_fail : osout_info);
+      }
+
+      /**
+       * Passes a complete log record to the asynchronous backend, or
+       * writes it synchronously to the output stream.
+       * @param const char* data
+       * @param std::size_t size
+       */
+      static void emit(const char* data, std::size_t size, unsigned what) noexcept
+      {
+        if(std::string* const captured = capture_target()) {
+          try { captured->append(data, size); } catch(...) { fatal(); }
+          return;
+        }
+        #ifdef WITH_MICROTEST_ASYNC_LOG
+        if(async::enabled()) {
+          if(async::push(data, size)) {
+            if((what == osout_fail) && (flush_policy_ & flush_on_fail) && (fdout().fd() >= 0)) flush();
+            return;
+          }
+          async::flush();
+        }
+        #endif
+        write_out(data, size);
+        if((what == osout_fail) && (flush_policy_ & flush_on_fail)) flush(); else write_out(nullptr, 0);
+      }
+
+      /**
+       * Writes to the output. `nullptr` data marks the end of a record batch,
+       * the output is flushed with `flush_on_record`, or if the
+       * `flush_on_interval` interval has elapsed.
+       * @param const char* data
+       * @param std::size_t size
+       */
+      static void write_out(const char* data, std::size_t size) noexcept
+      {
+        try {
+          std::unique_lock<std::mutex> lck(iolock_, std::defer_lock);
+          if(!crash_hooks<>::active()) {
+            lck.lock();
+          } else {
+            for(int i=0; (i<100000) && (!lck.try_lock()); ++i) {;} // best-effort
+          }
+          if(fdout().fd() >= 0) {
+            if(data) {
+              fdout().write(data, size);
+            } else if(flush_policy_ & flush_on_record) {
+              fdout().flush();
+            } else if(flush_policy_ & flush_on_interval) {
+              fdout().flush_if_older(flush_interval_);
+            }
+          } else if(os_) {
+            if(data) {
+              os_->write(data, std::streamsize(size));
+            } else if(flush_policy_ & flush_on_record) {
+              os_->flush();
+              os_flushed_ = std::chrono::steady_clock::now();
+            } else if(flush_policy_ & flush_on_interval) {
+              const auto now = std::chrono::steady_clock::now();
+              if((now - os_flushed_) >= flush_interval_) { os_->flush(); os_flushed_ = now; }
+            }
+          }
+        } catch(...) {
+          fatal();
+        }
+      }
+
+      /**
+       * Capture buffer of the current thread, see `capture()`.
+       * @return std::string*&
+       */
+      static std::string*& capture_target() noexcept
+      { static thread_local std::string* target = nullptr; return target; }
+
+      /**
+       * Returns true if an output stream or file descriptor is set.
+       * @return bool
+       */
+      static bool has_output() noexcept
+      { return (os_ != nullptr) || (fdout().fd() >= 0); }
+
+      /**
+       * Buffered file descriptor output.
+       * @return fd_sink<>&
+       */
+      static fd_sink<>& fdout() noexcept
+      { static fd_sink<> sink; return sink; }
+
+      /**
+       * Crash hook, writes all pending output (best-effort). In a signal
+       * handler, only `::write()` is used: The file descriptor buffer and
+       * the asynchronous rings are written to the output descriptor (for
+       * `std::cout` to STDOUT, as it is flushed per record). Other output
+       * streams are not signal-safe.
+       * @param bool in_signal
+       */
+      static void crash_flush(bool in_signal) noexcept
+      {
+        if(in_signal) {
+          fdout().flush();
+          #ifdef WITH_MICROTEST_ASYNC_LOG
+          int fd = fdout().fd();
+          #ifndef WITHOUT_MICROTEST_IOSTREAM
+          if((fd < 0) && (os_ == &std::cout)) fd = 1;
+          #endif
+          async::signal_flush(fd);
+          #endif
+          return;
+        }
+        #ifdef WITH_MICROTEST_ASYNC_LOG
+        async::emergency_flush();
+        #endif
+        fdout().flush();
+        try { if(os_) os_->flush(); } catch(...) { ; }
+      }
+
+      /**
+       * Output failure, no further logging possible.
+       */
+      [[noreturn]] static void fatal() noexcept
+      {
+        static const char msg[] = "[fatal  ] Testing frame could not write to the defined output stream, aborting.\n";
+        #ifndef __WINDOWS__
+        (void)!::write(2, msg, sizeof(msg)-1);
+        #else
+        (void)::_write(2, msg, unsigned(sizeof(msg)-1));
+        #endif
+        ::abort();
+      }
+
+      template <typename T, typename ...Args>
+      static void push_stream(std::ostream& os, T&& v, Args&& ...args)
+      { os << v; push_stream(os, std::forward<Args>(args)...); }
+
+      static void push_stream(std::ostream&) noexcept
+      {}
+
+      static std::ostream* os_;
+      static std::mutex iolock_;
+      static bool ansi_colors_;
+      static bool omit_passes_;
+      static unsigned fail_log_limit_;
+      static unsigned section_report_limit_;
+      static unsigned flush_policy_;
+      static std::chrono::milliseconds flush_interval_;
+      static std::chrono::steady_clock::time_point os_flushed_;
+      static reporter_type reporter_;
+      static const char* reporter_suite_;
+      static std::atomic<bool> suite_open_;
+      static std::atomic<std::uint64_t> tap_points_;
+      static std::atomic<std::uint64_t> output_epoch_;
+      static bool reporter_set_;
+    };
+
+    template <typename T> std::ostream* microtest<T>::os_ = nullptr;
+    template <typename T> std::mutex microtest<T>::iolock_;
+    template <typename T> unsigned microtest<T>::flush_policy_ = (microtest<T>::flush_on_record|microtest<T>::flush_on_summary);
+    template <typename T> std::chrono::milliseconds microtest<T>::flush_interval_(1000);
+    template <typename T> std::chrono::steady_clock::time_point microtest<T>::os_flushed_;
+    template <typename T> bool microtest<T>::ansi_colors_(!!(MICROTEST_UTEST_ANSI_COLORS));
+    template <typename T> bool microtest<T>::omit_passes_(!!(MICROTEST_UTEST_OMIT_PASS_LOGS));
+    template <typename T> unsigned microtest<T>::fail_log_limit_(MICROTEST_UTEST_FAIL_LOG_LIMIT);
+    template <typename T> unsigned microtest<T>::section_report_limit_(10);
+    template <typename T> typename microtest<T>::reporter_type microtest<T>::reporter_ = microtest<T>::report_text;
+    template <typename T> const char* microtest<T>::reporter_suite_ = "microtest";
+    template <typename T> std::atomic<bool> microtest<T>::suite_open_(false);
+    template <typename T> std::atomic<std::uint64_t> microtest<T>::tap_points_(0);
+    template <typename T> std::atomic<std::uint64_t> microtest<T>::output_epoch_(1);
+    template <typename T> bool microtest<T>::reporter_set_(false);
+  }
+
+  typedef detail::microtest<> test;
+
+}}
+
+/**
+ * Command line arguments of the test cases and of `main()`: Job count,
+ * shard selection, timeout, and fail log limit. Available without
+ * `WITH_MICROTEST_CASES`, as `test()` is sharded like a test case.
+ */
+namespace sw { namespace utest { namespace detail {
+
+  template <typename=void>
+  class test_case_args
+  {
+  public:
+
+    using function_type = void(*)();
+
+    struct entry
+    {
+      const char* name;
+      const char* file;
+      int line;
+      function_type fn;
+    };
+
+    /**
+     * Parses the number of jobs (`--jobs=N`), 0 meaning the number of
+     * hardware threads.
+     * @param const char* text
+     * @param unsigned& jobs
+     * @return bool
+     */
+    static bool parse_jobs(const char* text, unsigned& jobs) noexcept
+    {
+      if(!text || !*text) return false;
+      char* end = nullptr;
+      errno = 0;
+      const unsigned long n = std::strtoul(text, &end, 10);
+      if((errno != 0) || (!end) || (*end != '\0') || (n > 4096u) || (*text == '-')) return false;
+      jobs = unsigned(n);
+      return true;
+    }
+
+    /**
+     * Parses the per-site fail log limit (`--fail-log-limit=N`),
+     * 0 meaning unlimited.
+     * @param const char* text
+     * @param unsigned& limit
+     * @return bool
+     */
+    static bool parse_fail_log_limit(const char* text, unsigned& limit) noexcept
+    {
+      if(!text || (*text < '0') || (*text > '9')) return false;
+      char* end = nullptr;
+      errno = 0;
+      const unsigned long n = std::strtoul(text, &end, 10);
+      if((errno != 0) || (!end) || (*end != '\0') || (n > 0xfffffffful)) return false;
+      limit = unsigned(n);
+      return true;
+    }
+
+    /**
+     * Parses a shard selection (`--shard=i/n`, 1 <= i <= n).
+     * @param const char* text
+     * @param unsigned& index
+     * @param unsigned& count
+     * @return bool
+     */
+    static bool parse_shard(const char* text, unsigned& index, unsigned& count) noexcept
+    {
+      if(!text || (*text < '0') || (*text > '9')) return false;
+      char* end = nullptr;
+      errno = 0;
+      const unsigned long i = std::strtoul(text, &end, 10);
+      if((errno != 0) || (!end) || (*end != '/') || (end[1] < '0') || (end[1] > '9')) return false;
+      const unsigned long n = std::strtoul(end+1, &end, 10);
+      if((errno != 0) || (!end) || (*end != '\0') || (n < 1) || (n > 65536u) || (i < 1) || (i > n)) return false;
+      index = unsigned(i);
+      count = unsigned(n);
+      return true;
+    }
+
+    /**
+     * Parses a timeout in seconds (`--timeout=S`), finite and >= 0,
+     * 0 meaning no timeout.
+     * @param const char* text
+     * @param double& seconds
+     * @return bool
+     */
+    static bool parse_timeout(const char* text, double& seconds) noexcept
+    {
+      if(!text || (((*text < '0') || (*text > '9')) && (*text != '.'))) return false;
+      char* end = nullptr;
+      errno = 0;
+      const double s = std::strtod(text, &end);
+      if((errno != 0) || (!end) || (*end != '\0') || !(s >= 0) || !(s <= 1e9)) return false;
+      seconds = s;
+      return true;
+    }
+
+    /**
+     * Stable hash of a case name (FNV-1a), independent of the platform
+     * and of the definition order.
+     * @param const char* name
+     * @return std::uint64_t
+     */
+    static std::uint64_t name_hash(const char* name) noexcept
+    {
+      std::uint64_t h = 0xcbf29ce484222325ull;
+      for(const char* p = name; p && *p; ++p) { h ^= std::uint64_t(static_cast<unsigned char>(*p)); h *= 0x100000001b3ull; }
+      return h;
+    }
+
+    /**
+     * Returns true if a case belongs to shard `index` (1-based) of `count`.
+     * @param const entry& c
+     * @param unsigned index
+     * @param unsigned count
+     * @return bool
+     */
+    static bool in_shard(const entry& c, unsigned index, unsigned count) noexcept
+    { return (count <= 1) || ((name_hash(c.name) % count) == (index - 1)); }
+  };
+
+}}}
+
+/**
+ * Registered test cases, see `test_case()` (opt-in `WITH_MICROTEST_CASES`).
+ * With `WITH_MICROTEST_MAIN`, the cases are run after `test()`, optionally
+ * in parallel (`--jobs=N`) or in forked child processes (`--isolate`).
+ */
+#ifdef WITH_MICROTEST_CASES
+  #include <thread>
+  #include <deque>
+  #ifndef __WINDOWS__
+    #include <sys/wait.h>
+    #include <fcntl.h>
+    #include <poll.h>
+  #endif
+namespace sw { namespace utest { namespace detail {
+
+  /**
+   * Registry and runner of the test cases. Parallel cases are executed
+   * on a work-stealing thread pool: Each worker takes cases from the front
+   * of its own queue, and steals from the back of other queues when empty.
+   * The log records of a case are captured and written in registration
+   * order when the case is complete, so that the output is grouped per
+   * case and independent of the number of jobs. The check counts of a
+   * case are those of the thread running it (thread local counters),
+   * checks in threads started by the case are not attributed to the case.
+   */
+  template <typename=void>
+  class test_cases: public test_case_args<>
+  {
+  public:
+
+    /**
+     * Static registration of a case, see `test_case()`.
+     */
+    struct registration
+    {
+      registration(const char* name, const char* file, int line, function_type fn)
+      { registry().push_back(entry{name ? name : "", file, line, fn}); }
+    };
+
+    /**
+     * Registered cases in definition order.
+     * @return std::vector<entry>&
+     */
+    static std::vector<entry>& registry()
+    { static std::vector<entry> cases; return cases; }
+
+    /**
+     * Removes all registered cases not belonging to shard `index` of `count`,
+     * and logs the selection.
+     * @param unsigned index
+     * @param unsigned count
+     */
+    static void shard(unsigned index, unsigned count)
+    {
+      std::vector<entry>& cases = registry();
+      const std::size_t total = cases.size();
+      cases.erase(std::remove_if(cases.begin(), cases.end(), [&](const entry& c) { return !in_shard(c, index, count); }), cases.end());
+      test::info(check_site{__FILE__, __LINE__, check_kind::info, nullptr, nullptr}, "shard ", index, "/", count, ": ", cases.size(), " of ", total, " test cases");
+    }
+
+    /**
+     * Runs all registered cases with the given number of worker threads
+     * (0: number of hardware threads).
+     * @param unsigned jobs
+     */
+    static void run(unsigned jobs)
+    { run(registry(), jobs); }
+
+    /**
+     * Runs the given cases with the given number of worker threads.
+     * @param const std::vector<entry>& cases
+     * @param unsigned jobs
+     */
+    static void run(const std::vector<entry>& cases, unsigned jobs)
+    {
+      if(cases.empty()) return;
+      if(!jobs) jobs = std::thread::hardware_concurrency();
+      if(jobs > cases.size()) jobs = unsigned(cases.size());
+      if(jobs <= 1) {
+        for(const auto& c: cases) run_case(c, nullptr);
+        return;
+      }
+      worker_pool pool(cases, jobs);
+      auto threads = std::vector<std::thread>();
+      threads.reserve(jobs-1);
+      for(unsigned w=1; w<jobs; ++w) threads.emplace_back([&pool, w]() { pool.work(w); });
+      pool.work(0);
+      for(auto& t: threads) t.join();
+    }
+
+    /**
+     * Runs all registered cases each in a forked child process, at most
+     * `jobs` at the same time. Crashes, unexpected exits, and timeouts
+     * (`timeout_s` > 0) fail the case, the other cases continue.
+     * @param unsigned jobs
+     * @param double timeout_s
+     */
+    static void run_isolated(unsigned jobs, double timeout_s)
+    { run_isolated(registry(), jobs, timeout_s); }
+
+    /**
+     * Runs the given cases each in a forked child process. The log records
+     * of the children are streamed back through a pipe, and written grouped
+     * per case in definition order. Asynchronous logging is switched off.
+     * Without `fork()` (Windows), the cases are run in-process.
+     * @param const std::vector<entry>& cases
+     * @param unsigned jobs
+     * @param double timeout_s
+     */
+    static void run_isolated(const std::vector<entry>& cases, unsigned jobs, double timeout_s)
+    {
+      #ifdef __WINDOWS__
+      (void)timeout_s;
+      run(cases, jobs);
+      #else
+      if(cases.empty()) return;
+      if(!jobs) jobs = std::thread::hardware_concurrency();
+      if(jobs < 1) jobs = 1;
+      test::async_log(false);
+      auto running = std::vector<child>();
+      auto outputs = std::vector<std::string>(cases.size());
+      auto done = std::vector<bool>(cases.size(), false);
+      auto failed = std::vector<bool>(cases.size(), false);
+      std::size_t next = 0, next_output = 0;
+      while((next < cases.size()) || (!running.empty())) {
+        while((running.size() < jobs) && (next < cases.size())) {
+          if(!spawn(cases, next, running)) {
+            test::warning(check_site{cases[next].file, cases[next].line, check_kind::warn, nullptr, nullptr}, "case '", cases[next].name, "': Could not fork, running in-process.");
+            failed[next] = !run_case(cases[next], nullptr);
+            done[next] = true;
+          }
+          ++next;
+        }
+        auto fds = std::vector<struct ::pollfd>();
+        for(const auto& ch: running) {
+          if(ch.log_fd >= 0) fds.push_back(pollfd{ch.log_fd, POLLIN, 0});
+          if(ch.status_fd >= 0) fds.push_back(pollfd{ch.status_fd, POLLIN, 0});
+        }
+        if(!fds.empty()) {
+          (void)::poll(fds.data(), nfds_t(fds.size()), 20);
+        } else if(!running.empty()) {
+          std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        for(std::size_t i=0; i<running.size();) {
+          child& ch = running[i];
+          drain(ch);
+          int wait_status = 0;
+          const pid_t r = ::waitpid(ch.pid, &wait_status, WNOHANG);
+          if(r == ch.pid) {
+            drain(ch);
+            failed[ch.index] = !finish(cases[ch.index], ch, wait_status, timeout_s);
+            outputs[ch.index].swap(ch.records);
+            done[ch.index] = true;
+            running.erase(running.begin() + std::ptrdiff_t(i));
+            continue;
+          }
+          if((timeout_s > 0) && (!ch.timed_out) && ((std::chrono::steady_clock::now() - ch.start) > std::chrono::duration<double>(timeout_s))) {
+            ch.timed_out = true;
+            ::kill(ch.pid, SIGKILL);
+          }
+          ++i;
+        }
+        while((next_output < cases.size()) && done[next_output]) {
+          test::write_captured(outputs[next_output], failed[next_output]);
+          std::string().swap(outputs[next_output]);
+          ++next_output;
+        }
+      }
+      #endif
+    }
+
+  private:
+
+    /**
+     * Runs one case, accounts and logs its result. The checks of the case
+     * are the difference of the check counters of the current thread
+     * (or the counts since a `test::reset()` in the case).
+     * @param const entry& c
+     * @param std::string* captured
+     * @return bool
+     */
+    static bool run_case(const entry& c, std::string* captured)
+    {
+      using counters = check_counters<>;
+      const check_site site{c.file, c.line, check_kind::note, c.name, nullptr};
+      std::string* const outer_capture = test::capture();
+      if(captured) { captured->reserve(std::size_t(1) << 16); test::capture(captured); }
+      const counters::shard& shard = counters::local();
+      const std::uint64_t n_checks = shard.checks.load(std::memory_order_relaxed);
+      const std::uint64_t n_fails = shard.fails.load(std::memory_order_relaxed);
+      const std::uint64_t n_warns = shard.warns.load(std::memory_order_relaxed);
+      const auto t0 = std::chrono::steady_clock::now();
+      try {
+        c.fn();
+      } catch(const std::exception& e) {
+        test::fail(site, "case '", c.name, "': Unexpected exception: ", e.what());
+      } catch(...) {
+        test::fail(site, "case '", c.name, "': Unexpected exception");
+      }
+      const double ms = double(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t0).count()) / 1e3;
+      const std::uint64_t checks = since(shard.checks, n_checks);
+      const std::uint64_t fails = since(shard.fails, n_fails);
+      const std::uint64_t warns = since(shard.warns, n_warns);
+      test::case_result(site, c.name, checks, fails, warns, ms);
+      if(captured) test::capture(outer_capture);
+      return !fails;
+    }
+
+    #ifndef __WINDOWS__
+    /**
+     * Result record a child process writes to the status pipe, on
+     * completion or (best-effort) from the crash hooks.
+     */
+    struct child_status
+    {
+      std::uint64_t checks;
+      std::uint64_t fails;
+      std::uint64_t warns;
+      std::uint64_t complete;
+    };
+
+    /**
+     * Running child process of an isolated case.
+     */
+    struct child
+    {
+      pid_t pid;
+      int log_fd;
+      int status_fd;
+      std::size_t index;
+      std::chrono::steady_clock::time_point start;
+      std::string records;
+      child_status status;
+      bool has_status;
+      bool timed_out;
+    };
+
+    static int& child_status_fd() noexcept
+    { static int fd = -1; return fd; }
+
+    static void write_child_status(bool complete, bool in_signal=false) noexcept
+    {
+      using counters = check_counters<>;
+      child_status st{ 0, 0, 0, complete ? 1u : 0u };
+      if(in_signal) {
+        counters::unlocked_totals(st.checks, st.fails, st.warns);
+      } else {
+        st.checks = counters::checks(); st.fails = counters::fails(); st.warns = counters::warns();
+      }
+      if(child_status_fd() >= 0) (void)!::write(child_status_fd(), &st, sizeof(st));
+    }
+
+    static void child_crash_hook(bool in_signal) noexcept
+    { write_child_status(false, in_signal); }
+
+    /**
+     * Child process: Runs the case with unbuffered logging to the log
+     * pipe, and reports the counts via the status pipe.
+     */
+    [[noreturn]] static void run_child(const entry& c, int log_fd, int status_fd) noexcept
+    {
+      check_counters<>::reset();
+      child_status_fd() = status_fd;
+      test::stream_fd(log_fd, test::flush_on_fail|test::flush_on_crash|test::flush_on_interval, 0);
+      crash_hooks<>::add(&child_crash_hook);
+      try { run_case(c, nullptr); } catch(...) { ; }
+      test::flush();
+      std::fflush(nullptr);
+      write_child_status(true);
+      ::_exit(0);
+    }
+
+    /**
+     * Forks a child process for the case `index`.
+     */
+    static bool spawn(const std::vector<entry>& cases, std::size_t index, std::vector<child>& running)
+    {
+      int log_pipe[2] = {-1,-1}, status_pipe[2] = {-1,-1};
+      if(::pipe(log_pipe) != 0) return false;
+      if(::pipe(status_pipe) != 0) { ::close(log_pipe[0]); ::close(log_pipe[1]); return false; }
+      test::flush();
+      const pid_t pid = ::fork();
+      if(pid < 0) {
+        for(int fd: {log_pipe[0], log_pipe[1], status_pipe[0], status_pipe[1]}) ::close(fd);
+        return false;
+      }
+      if(pid == 0) {
+        ::close(log_pipe[0]);
+        ::close(status_pipe[0]);
+        for(const auto& r: running) { ::close(r.log_fd); ::close(r.status_fd); }
+        run_child(cases[index], log_pipe[1], status_pipe[1]);
+      }
+      ::close(log_pipe[1]);
+      ::close(status_pipe[1]);
+      ::fcntl(log_pipe[0], F_SETFL, ::fcntl(log_pipe[0], F_GETFL) | O_NONBLOCK);
+      ::fcntl(status_pipe[0], F_SETFL, ::fcntl(status_pipe[0], F_GETFL) | O_NONBLOCK);
+      running.push_back(child{pid, log_pipe[0], status_pipe[0], index, std::chrono::steady_clock::now(), std::string(), child_status{0,0,0,0}, false, false});
+      running.back().records.reserve(std::size_t(1) << 16);
+      return true;
+    }
+
+    /**
+     * Reads the available data of the child pipes, closes them on EOF.
+     */
+    static void drain(child& ch)
+    {
+      char buffer[4096];
+      while(ch.log_fd >= 0) {
+        const ssize_t n = ::read(ch.log_fd, buffer, sizeof(buffer));
+        if(n > 0) { ch.records.append(buffer, std::size_t(n)); continue; }
+        if((n < 0) && (errno == EINTR)) continue;
+        if(n == 0) { ::close(ch.log_fd); ch.log_fd = -1; }
+        break;
+      }
+      while(ch.status_fd >= 0) {
+        child_status st;
+        const ssize_t n = ::read(ch.status_fd, &st, sizeof(st));
+        if(n == ssize_t(sizeof(st))) { ch.status = st; ch.has_status = true; continue; }
+        if((n < 0) && (errno == EINTR)) continue;
+        if(n == 0) { ::close(ch.status_fd); ch.status_fd = -1; }
+        break;
+      }
+    }
+
+    /**
+     * Accounts a terminated child: Counts of the status record, and a
+     * failed check for crashes, unexpected exits, and timeouts.
+     */
+    static bool finish(const entry& c, child& ch, int wait_status, double timeout_s)
+    {
+      const check_site site{c.file, c.line, check_kind::fail, c.name, nullptr};
+      if(ch.log_fd >= 0) { ::close(ch.log_fd); ch.log_fd = -1; }
+      if(ch.status_fd >= 0) { ::close(ch.status_fd); ch.status_fd = -1; }
+      if(ch.has_status) check_counters<>::add(ch.status.checks, ch.status.fails, ch.status.warns);
+      bool passed = ch.has_status && (!ch.status.fails);
+      std::string* const outer_capture = test::capture();
+      test::capture(&ch.records);
+      if(ch.timed_out) {
+        passed = test::fail(site, "case '", c.name, "': Timeout after ", timeout_s, "s");
+      } else if(WIFSIGNALED(wait_status)) {
+        const int sig = WTERMSIG(wait_status);
+        const char* const name = ::strsignal(sig);
+        passed = test::fail(site, "case '", c.name, "': Terminated by signal ", sig, " (", (name ? name : "?"), ")");
+      } else if(!WIFEXITED(wait_status) || (WEXITSTATUS(wait_status) != 0) || !ch.has_status || !ch.status.complete) {
+        passed = test::fail(site, "case '", c.name, "': Exited unexpectedly with code ", (WIFEXITED(wait_status) ? WEXITSTATUS(wait_status) : -1));
+      }
+      test::capture(outer_capture);
+      return passed;
+    }
+    #endif
+
+    static std::uint64_t since(const std::atomic<std::uint64_t>& counter, std::uint64_t start) noexcept
+    { const std::uint64_t n = counter.load(std::memory_order_relaxed); return (n >= start) ? (n - start) : n; }
+
+    class worker_pool
+    {
+    public:
+
+      worker_pool(const std::vector<entry>& cases, unsigned jobs)
+        : cases_(cases), queues_(new queue[jobs]), num_queues_(jobs), results_(cases.size()), next_output_(0)
+      { for(std::size_t i=0; i<cases.size(); ++i) queues_[i % jobs].items.push_back(i); }
+
+      void work(unsigned self)
+      {
+        std::size_t index = 0;
+        while(pop_front(self, index) || steal(self, index)) {
+          result& r = results_[index];
+          r.passed = run_case(cases_[index], &r.records);
+          complete(index);
+        }
+      }
+
+    private:
+
+      struct queue
+      {
+        std::mutex lock;
+        std::deque<std::size_t> items;
+      };
+
+      struct result
+      {
+        std::string records;
+        bool passed = false;
+        bool done = false;
+      };
+
+      bool pop_front(unsigned self, std::size_t& index)
+      {
+        queue& q = queues_[self];
+        std::lock_guard<std::mutex> lck(q.lock);
+        if(q.items.empty()) return false;
+        index = q.items.front();
+        q.items.pop_front();
+        return true;
+      }
+
+      bool steal(unsigned self, std::size_t& index)
+      {
+        for(unsigned i=1; i<num_queues_; ++i) {
+          queue& q = queues_[(self+i) % num_queues_];
+          std::lock_guard<std::mutex> lck(q.lock);
+          if(q.items.empty()) continue;
+          index = q.items.back();
+          q.items.pop_back();
+          return true;
+        }
+        return false;
+      }
+
+      /**
+       * Marks a case as complete and writes the output of all complete
+       * cases in registration order.
+       */
+      void complete(std::size_t index)
+      {
+        std::lock_guard<std::mutex> lck(output_lock_);
+        results_[index].done = true;
+        while((next_output_ < results_.size()) && results_[next_output_].done) {
+          result& r = results_[next_output_++];
+          test::write_captured(r.records, !r.passed);
+          std::string().swap(r.records);
+        }
+      }
+
+      const std::vector<entry>& cases_;
+      std::unique_ptr<queue[]> queues_;
+      unsigned num_queues_;
+      std::vector<result> results_;
+      std::size_t next_output_;
+      std::mutex output_lock_;
+    };
+  };
+
+}}}
+#endif
+
+/***
+ * Random value and container generation.
+ * Can be omitted using `WITHOUT_MICROTEST_RANDOM`.
+ */
+namespace sw { namespace utest {
+  #ifndef WITHOUT_MICROTEST_RANDOM
+
+    namespace random_generators {
+
+      /**
+       * xoshiro256** 64 bit engine (UniformRandomBitGenerator), state
+       * initialized from a 64 bit seed using splitmix64.
+       */
+      class xoshiro256ss
+      {
+      public:
+
+        using result_type = std::uint64_t;
+
+        static constexpr result_type min() noexcept
+        { return 0; }
+
+        static constexpr result_type max() noexcept
+        { return ~result_type(0); }
+
+        constexpr xoshiro256ss() noexcept : s_{0,0,0,0}
+        {}
+
+        explicit xoshiro256ss(std::uint64_t seed_value) noexcept : s_{0,0,0,0}
+        { seed(seed_value); }
+
+        void seed(std::uint64_t seed_value) noexcept
+        { for(auto& e: s_) e = splitmix64(seed_value); }
+
+        result_type operator()() noexcept
+        {
+          const std::uint64_t result = rotl(s_[1] * 5, 7) * 9;
+          const std::uint64_t t = s_[1] << 17;
+          s_[2] ^= s_[0];
+          s_[3] ^= s_[1];
+          s_[1] ^= s_[2];
+          s_[0] ^= s_[3];
+          s_[2] ^= t;
+          s_[3] = rotl(s_[3], 45);
+          return result;
+        }
+
+        /**
+         * Seed sequence step, advances `state` and returns the next value.
+         */
+        static std::uint64_t splitmix64(std::uint64_t& state) noexcept
+        {
+          std::uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+          z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+          z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+          return z ^ (z >> 31);
+        }
+
+        static constexpr std::uint64_t rotl(std::uint64_t x, int k) noexcept
+        { return (x << k) | (x >> (64 - k)); }
+
+      private:
+
+        std::uint64_t s_[4];
+      };
+
+      /**
+       * Block generator: `lanes` interleaved xoshiro256** states in structure
+       * of arrays layout. The lanes are independent, so that the compiler can
+       * vectorize the state update. Seeded from a scalar engine.
+       */
+      class xoshiro256ss_lanes
+      {
+      public:
+
+        static constexpr std::size_t lanes = 8;
+        static constexpr std::size_t block_size = 256;
+
+        explicit xoshiro256ss_lanes(xoshiro256ss& seeder) noexcept
+        {
+          for(std::size_t l=0; l<lanes; ++l) {
+            std::uint64_t state = seeder();
+            for(std::size_t i=0; i<4; ++i) s_[i][l] = xoshiro256ss::splitmix64(state);
+          }
+        }
+
+        /**
+         * Generates one block of `block_size` random values.
+         * @param std::uint64_t* out
+         */
+        void generate(std::uint64_t* out) noexcept
+        {
+          for(std::size_t k=0; k<block_size; k+=lanes) {
+            for(std::size_t l=0; l<lanes; ++l) {
+              const std::uint64_t s0 = s_[0][l], s1 = s_[1][l];
+              const std::uint64_t s2 = s_[2][l] ^ s0, s3 = s_[3][l] ^ s1;
+              out[k+l] = xoshiro256ss::rotl(s1 * 5, 7) * 9;
+              s_[0][l] = s0 ^ s3;
+              s_[1][l] = s1 ^ s2;
+              s_[2][l] = s2 ^ (s1 << 17);
+              s_[3][l] = xoshiro256ss::rotl(s3, 45);
+            }
+          }
+        }
+
+      private:
+
+        std::uint64_t s_[4][lanes];
+      };
+
+      /**
+       * Thread local engine, seeded from the run seed and the order
+       * in which threads first use it (stream 0 is the first thread).
+       * Constant initialized, so that the access needs no TLS guard.
+       */
+      template <typename=void>
+      struct rndengine
+      {
+        static xoshiro256ss& local() noexcept
+        {
+          thread_local local_engine e;
+          const std::uint64_t generation = detail::random_seed<>::generation();
+          if(e.generation != generation) {
+            if(e.stream == ~std::uint64_t(0)) e.stream = next_stream_.fetch_add(1, std::memory_order_relaxed);
+            e.generation = generation;
+            e.engine.seed(detail::random_seed<>::get() ^ (e.stream * 0xd1b54a32d192ed03ull));
+          }
+          return e.engine;
+        }
+
+      private:
+
+        struct local_engine
+        {
+          constexpr local_engine() noexcept : engine(), generation(~std::uint64_t(0)), stream(~std::uint64_t(0))
+          {}
+
+          xoshiro256ss engine;
+          std::uint64_t generation;
+          std::uint64_t stream;
+        };
+
+        static std::atomic<std::uint64_t> next_stream_;
+      };
+
+      template <typename T> std::atomic<std::uint64_t> rndengine<T>::next_stream_(0);
+
+      /**
+       * Uniform conversion of 64 random bits to [0,1), using the upper
+       * bits as mantissa (24 bit for float, 53 bit otherwise).
+       * @param std::uint64_t bits
+       * @return R
+       */
+      template <typename R>
+      inline typename std::enable_if<std::is_same<R, float>::value, R>::type unit_interval(std::uint64_t bits) noexcept
+      { return float(bits >> 40) * (1.0f / 16777216.0f); }
+
+      template <typename R>
+      inline typename std::enable_if<!std::is_same<R, float>::value, R>::type unit_interval(std::uint64_t bits) noexcept
+      { return R(double(bits >> 11) * (1.0 / 9007199254740992.0)); }
+
+      /**
+       * Uniform integer in [0, range] from 64 random bits, using Lemire's
+       * multiply-shift method (ranges < 2^32) with rejection of the biased
+       * products, or masked rejection for wider ranges. Rejected samples are
+       * redrawn from `engine`.
+       * @param std::uint64_t bits
+       * @param std::uint64_t range
+       * @param xoshiro256ss& engine
+       * @return std::uint64_t
+       */
+      inline std::uint64_t bounded(std::uint64_t bits, std::uint64_t range, xoshiro256ss& engine) noexcept
+      {
+        if(range < 0xffffffffull) {
+          const std::uint64_t n = range + 1;
+          std::uint64_t m = (bits >> 32) * n;
+          if(std::uint32_t(m) < n) {
+            const std::uint32_t threshold = (std::uint32_t(0) - std::uint32_t(n)) % std::uint32_t(n);
+            while(std::uint32_t(m) < threshold) m = (engine() >> 32) * n;
+          }
+          return m >> 32;
+        } else if(range == ~std::uint64_t(0)) {
+          return bits;
+        } else {
+          std::uint64_t mask = range;
+          mask |= mask >> 1; mask |= mask >> 2; mask |= mask >> 4; mask |= mask >> 8; mask |= mask >> 16; mask |= mask >> 32;
+          bits &= mask;
+          while(bits > range) bits = engine() & mask;
+          return bits;
+        }
+      }
+
+      /**
+       * Conversion of random bits to uniformly distributed floating point values.
+       */
+      template <typename T>
+      struct uniform_real
+      {
+        uniform_real(T min, T max) noexcept : min_(min), span_(max-min)
+        {}
+
+        T operator()(std::uint64_t bits, xoshiro256ss&) const noexcept
+        { return min_ + span_ * unit_interval<T>(bits); }
+
+        T min_, span_;
+      };
+
+      /**
+       * Conversion of random bits to uniformly distributed integral values.
+       */
+      template <typename T>
+      struct uniform_int
+      {
+        uniform_int(T min, T max) noexcept : min_(std::uint64_t(min)), range_(std::uint64_t(max) - std::uint64_t(min))
+        {}
+
+        T operator()(std::uint64_t bits, xoshiro256ss& engine) const noexcept
+        { return T(min_ + bounded(bits, range_, engine)); }
+
+        std::uint64_t min_, range_;
+      };
+
+      /**
+       * Value conversion selection and default value ranges
+       * (integral: complete type range, floating point: 0 to 1).
+       */
+      template <typename T, bool=std::is_floating_point<T>::value>
+      struct uniform
+      {
+        using type = uniform_real<T>;
+        static type make() noexcept { return type(T(0), T(1)); }
+      };
+
+      template <typename T>
+      struct uniform<T, false>
+      {
+        using type = uniform_int<T>;
+        static type make() noexcept { return type(std::numeric_limits<T>::min(), std::numeric_limits<T>::max()); }
+      };
+
+      /**
+       * Block fill of a random access range.
+       */
+      template <typename It, typename Convert>
+      void fill_range(It first, It last, const Convert& convert, std::random_access_iterator_tag) noexcept
+      {
+        xoshiro256ss& engine = rndengine<>::local();
+        xoshiro256ss_lanes gen(engine);
+        std::uint64_t bits[xoshiro256ss_lanes::block_size];
+        auto n = std::size_t(last - first);
+        while(n > 0) {
+          const std::size_t k = (n < xoshiro256ss_lanes::block_size) ? n : xoshiro256ss_lanes::block_size;
+          gen.generate(bits);
+          for(std::size_t i=0; i<k; ++i) first[i] = convert(bits[i], engine);
+          first += k;
+          n -= k;
+        }
+      }
+
+      /**
+       * Block fill of a forward range.
+       */
+      template <typename It, typename Convert>
+      void fill_range(It first, It last, const Convert& convert, std::forward_iterator_tag) noexcept
+      {
+        xoshiro256ss& engine = rndengine<>::local();
+        xoshiro256ss_lanes gen(engine);
+        std::uint64_t bits[xoshiro256ss_lanes::block_size];
+        while(first != last) {
+          gen.generate(bits);
+          for(std::size_t i=0; (i<xoshiro256ss_lanes::block_size) && (first != last); ++i, ++first) *first = convert(bits[i], engine);
+        }
+      }
+
+      /**
+       * Grows a reserved, empty contiguous container (vector, string)
+       * block-wise by `n` random values, without initializing it before.
+       */
+      template <typename R, typename Convert>
+      void append_filled(R& container, typename R::size_type n, const Convert& convert)
+      {
+        using value_type = typename R::value_type;
+        xoshiro256ss& engine = rndengine<>::local();
+        xoshiro256ss_lanes gen(engine);
+        std::uint64_t bits[xoshiro256ss_lanes::block_size];
+        value_type values[xoshiro256ss_lanes::block_size];
+        while(n > 0) {
+          const std::size_t k = (n < xoshiro256ss_lanes::block_size) ? std::size_t(n) : xoshiro256ss_lanes::block_size;
+          gen.generate(bits);
+          for(std::size_t i=0; i<k; ++i) values[i] = convert(bits[i], engine);
+          container.insert(container.end(), values, values+k);
+          n -= k;
+        }
+      }
+
+      /**
+       * Fills `r` with `n` random values. Vectors and strings are grown
+       * from reserved, uninitialized storage, other containers are
+       * value initialized and overwritten.
+       */
+      template <typename R, typename Convert>
+      void make_filled(R& r, typename R::size_type n, const Convert& convert)
+      {
+        R container(n, typename R::value_type());
+        fill_range(container.begin(), container.end(), convert, typename std::iterator_traits<typename R::iterator>::iterator_category());
+        r.swap(container);
+      }
+
+      template <typename T, typename Alloc, typename Convert>
+      void make_filled(std::vector<T, Alloc>& r, typename std::vector<T, Alloc>::size_type n, const Convert& convert)
+      {
+        std::vector<T, Alloc> container;
+        container.reserve(n);
+        append_filled(container, n, convert);
+        r.swap(container);
+      }
+
+      template <typename C, typename Traits, typename Alloc, typename Convert>
+      void make_filled(std::basic_string<C, Traits, Alloc>& r, typename std::basic_string<C, Traits, Alloc>::size_type n, const Convert& convert)
+      {
+        std::basic_string<C, Traits, Alloc> container;
+        container.reserve(n);
+        append_filled(container, n, convert);
+        r.swap(container);
+      }
+
+      /**
+       * Random for floating point types, uniform distribution, single value request.
+       * @param T& r
+       * @param T min
+       * @param T max
+       */
+      template <typename R, typename A1, typename A2>
+      typename std::enable_if<
+        std::is_floating_point<typename std::decay<R>::type>::value &&
+        std::is_convertible<typename std::decay<A1>::type,R>::value &&
+        std::is_convertible<typename std::decay<A2>::type,R>::value,
+        void
+      >
+      ::type rnd(R& r, A1 min, A2 max)
+      {
+        using value_type = typename std::decay<R>::type;
+        xoshiro256ss& engine = rndengine<>::local();
+        r = uniform_real<value_type>(static_cast<value_type>(min), static_cast<value_type>(max))(engine(), engine);
+      }
+
+      /**
+       * Random for floating point types, uniform distribution, single value request.
+       * @param T& r
+       * @param T max
+       */
+      template <typename R, typename A1>
+      typename std::enable_if<
+        std::is_floating_point<typename std::decay<R>::type>::value &&
+        std::is_convertible<typename std::decay<A1>::type,R>::value,
+        void
+      >
+      ::type rnd(R& r, A1 max)
+      { rnd(r, 0, max); }
+
+      /**
+       * Random for floating point types, uniform distribution, single
+       * value request. Values between 0 and 1
+       * @param T& r
+       */
+      template <typename R>
+      typename std::enable_if<
+        std::is_floating_point<typename std::decay<R>::type>::value,
+        void
+      >
+      ::type rnd(R& r)
+      { rnd(r, 0, 1); }
+
+      /**
+       * Random for integral types, uniform distribution, min to max (max inclusive
+       * interval [min,max]), single value request.
+       * @param T& r
+       * @param T min
+       * @param T max
+       */
+      template <typename R, typename A1, typename A2>
+      typename std::enable_if<
+        std::is_integral<typename std::decay<R>::type>::value &&
+        std::is_convertible<typename std::decay<A1>::type,R>::value &&
+        std::is_convertible<typename std::decay<A2>::type,R>::value &&
+        !std::is_same<typename std::decay<R>::type, char>::value &&
+        !std::is_same<typename std::decay<R>::type, unsigned char>::value,
+        void
+      >
+      ::type rnd(R& r, A1 min, A2 max)
+      {
+        using value_type = typename std::decay<R>::type;
+        xoshiro256ss& engine = rndengine<>::local();
+        r = uniform_int<value_type>(static_cast<value_type>(min), static_cast<value_type>(max))(engine(), engine);
+      }
+
+      /**
+       * Random for integral types, uniform distribution, 0 to max, single value request.
+       * @param T& r
+       * @param T max
+       */
+      template <typename R, typename A1>
+      typename std::enable_if<
+        std::is_integral<typename std::decay<R>::type>::value &&
+        std::is_convertible<typename std::decay<A1>::type,R>::value &&
+        !std::is_same<typename std::decay<R>::type, char>::value &&
+        !std::is_same<typename std::decay<R>::type, unsigned char>::value,
+        void
+      >
+      ::type rnd(R& r, A1 max)
+      { rnd(r, 0, max); }
+
+      /**
+       * Random for integral types, uniform distribution, over the complete
+       * range of the type, single value request.
+       * @param T& r
+       */
+      template <typename R>
+      typename std::enable_if<
+        std::is_integral<typename std::decay<R>::type>::value &&
         !std::is_same<typename std::decay<R>::type, char>::value &&
         !std::is_same<typename std::decay<R>::type, unsigned char>::value,
         void
@@ -1207,186 +5172,1312 @@ namespace sw { namespace utest {
       { rnd(r, std::numeric_limits<R>::min(), std::numeric_limits<R>::max()); }
 
       /**
-       * Random for byte types, uniform distribution, min to max, single value request.
-       * @param T& r
-       * @param T min
-       * @param T max
+       * Random for byte types, uniform distribution, min to max, single value request.
+       * @param T& r
+       * @param T min
+       * @param T max
+       */
+      template <typename R, typename A1, typename A2>
+      typename std::enable_if<
+        std::is_integral<typename std::decay<A1>::type>::value &&
+        std::is_integral<typename std::decay<A2>::type>::value && (
+          std::is_same<typename std::decay<R>::type, char>::value ||
+          std::is_same<typename std::decay<R>::type, unsigned char>::value
+        ),
+        void
+      >
+      ::type rnd(R& r, A1 min, A2 max)
+      { auto rr = 0; rnd(rr, int(min), int(max)); r = R(rr); }
+
+      /**
+       * Random for byte types, uniform distribution, 0 to max, single value request.
+       * @param T& r
+       * @param T max
+       */
+      template <typename R, typename A1>
+      typename std::enable_if<
+        std::is_integral<typename std::decay<A1>::type>::value && (
+          std::is_same<typename std::decay<R>::type, char>::value ||
+          std::is_same<typename std::decay<R>::type, unsigned char>::value
+        ),
+        void
+      >
+      ::type rnd(R& r, A1 max)
+      { auto rr = 0; rnd(rr, 0, max); r = R(rr); }
+
+      /**
+       * Random for byte types, uniform distribution, over the complete type value
+       * range, single value request.
+       * @param T& r
+       */
+      template <typename R>
+      typename std::enable_if<
+        std::is_same<typename std::decay<R>::type, char>::value ||
+        std::is_same<typename std::decay<R>::type, unsigned char>::value,
+        void
+      >
+      ::type rnd(R& r)
+      { auto rr = 0; rnd(rr, int(std::numeric_limits<R>::min()), int(std::numeric_limits<R>::max())); r = R(rr); }
+
+      /**
+       * Random string, fixed length, uniform dist, values: space (32) to '~' (126)
+       * @param std::basic_string<typename R>& r
+       * @param int length
+       */
+      template <typename R>
+      void rnd(std::basic_string<R>& r, typename std::basic_string<R>::size_type length)
+      {
+        if(length < 1) { r.clear(); return; }
+        make_filled(r, length, uniform_int<R>(R(' '), R('~')));
+      }
+
+      /**
+       * Random arithmetic container, fixed length, uniform distribution, from --> to
+       * Note: No Concept yet in std=c++11, the filter used here applies to objects that
+       * meet the requirements: They must have have allocator, iterator, integral size_type,
+       * arithmetic value_type; arguments 'min' and 'max' are convertible to value_type, argument
+       * 'size' is convertible to size_type, and the object can be constructed with
+       * Class(size_type, value_type) for reservation of the required memory space.
+       *
+       * Means it fits pretty much to STL containers, but not only. Hence, this filter may
+       * fail if the object does not have the methods clear() and swap(...).
+       */
+      template <typename R, typename Sz, typename A1, typename A2>
+      typename std::enable_if<
+        std::is_object<R>::value &&
+        std::is_object<typename R::iterator>::value &&
+        std::is_object<typename R::allocator_type>::value &&
+        std::is_integral<typename R::size_type>::value &&
+        std::is_constructible<R, typename R::size_type, typename R::value_type>::value &&
+        std::is_arithmetic<typename std::decay<typename R::value_type>::type>::value &&
+        std::is_convertible<typename std::decay<Sz>::type, typename R::size_type>::value &&
+        std::is_convertible<typename std::decay<A1>::type, typename R::value_type>::value &&
+        std::is_convertible<typename std::decay<A2>::type, typename R::value_type>::value,
+        void
+      >
+      ::type rnd(R& r, Sz sz, A1 min, A2 max)
+      {
+        using value_type = typename std::decay<typename R::value_type>::type;
+        if(sz < 1) { r.clear(); return; }
+        make_filled(r, static_cast<typename R::size_type>(sz), typename uniform<value_type>::type(static_cast<value_type>(min), static_cast<value_type>(max)));
+      }
+
+      /**
+       * Random arithmetic container, given length, uniform distribution,
+       * from MIN to MAX of the value type.
+       */
+      template <typename R, typename Sz>
+      typename std::enable_if<
+        std::is_object<R>::value &&
+        std::is_object<typename R::iterator>::value &&
+        std::is_object<typename R::allocator_type>::value &&
+        std::is_integral<typename R::size_type>::value &&
+        std::is_constructible<R, typename R::size_type, typename R::value_type>::value &&
+        std::is_arithmetic<typename std::decay<typename R::value_type>::type>::value &&
+        std::is_convertible<typename std::decay<Sz>::type, typename R::size_type>::value &&
+        !std::is_same<typename std::decay<R>::type, std::string>::value &&
+        !std::is_same<typename std::decay<R>::type, std::wstring>::value,
+        void
+      >
+      ::type rnd(R& r, Sz sz)
+      {
+        using value_type = typename std::decay<typename R::value_type>::type;
+        if(sz < 1) { r.clear(); return; }
+        make_filled(r, static_cast<typename R::size_type>(sz), uniform<value_type>::make());
+      }
+
+    }
+
+    /**
+     * Random value generation. Relay function template.
+     */
+    template <typename R, typename ...Args>
+    inline R random(Args&& ...args)
+    { auto r = R(); random_generators::rnd(r, std::forward<Args>(args)...); return r; }
+
+    /**
+     * Fills the range [first, last) with random values between
+     * `min` and `max` (uniform distribution).
+     */
+    template <typename It, typename A1, typename A2>
+    inline void random_fill(It first, It last, A1 min, A2 max)
+    {
+      using value_type = typename std::decay<typename std::iterator_traits<It>::value_type>::type;
+      static_assert(std::is_arithmetic<value_type>::value, "random_fill() requires arithmetic value types.");
+      random_generators::fill_range(first, last,
+        typename random_generators::uniform<value_type>::type(static_cast<value_type>(min), static_cast<value_type>(max)),
+        typename std::iterator_traits<It>::iterator_category()
+      );
+    }
+
+    /**
+     * Fills the range [first, last) with random values, integral
+     * types over the complete value range, floating point 0 to 1.
+     */
+    template <typename It>
+    inline void random_fill(It first, It last)
+    {
+      using value_type = typename std::decay<typename std::iterator_traits<It>::value_type>::type;
+      static_assert(std::is_arithmetic<value_type>::value, "random_fill() requires arithmetic value types.");
+      random_generators::fill_range(first, last, random_generators::uniform<value_type>::make(), typename std::iterator_traits<It>::iterator_category());
+    }
+
+    /**
+     * Fills a complete container (or array, span) with random values
+     * between `min` and `max`.
+     */
+    template <typename Range, typename A1, typename A2>
+    inline void random_fill(Range&& range, A1 min, A2 max)
+    { using std::begin; using std::end; random_fill(begin(range), end(range), min, max); }
+
+    /**
+     * Fills a complete container (or array, span) with random values
+     * in the default range of the value type.
+     */
+    template <typename Range>
+    inline void random_fill(Range&& range)
+    { using std::begin; using std::end; random_fill(begin(range), end(range)); }
+
+  #endif
+}}
+
+/**
+ * Auxiliary generators.
+ */
+#ifdef WITH_MICROTEST_GENERATORS
+  #include <vector>
+  #include <string>
+  #include <array>
+
+  namespace sw { namespace utest {
+
+    /**
+     * Generates a sequential value test vector, with
+     * a given element type T, a size N, and with the
+     * first value being `start_value`.
+     * @tparam typename T
+     * @tparam size_t N
+     * @return std::vector<T>
+     */
+    template <typename T, size_t N>
+    std::vector<T> sequence_vector(T start_value)
+    {
+      static_assert(N>0, "An empty container cannot hold a sequence.");
+      auto v = std::vector<T>();
+      v.reserve(N);
+      for(size_t i=0; i<N; ++i) v.push_back(start_value + T(i));
+      return v;
+    }
+
+    /**
+     * Generates a sequential value test array, with
+     * a given element type T, a size N, and with the
+     * first value being `start_value`.
+     * @tparam typename T
+     * @tparam size_t N
+     * @return std::array<T,N>
+     */
+    template <typename T, size_t N>
+    std::array<T,N> sequence_array(T start_value)
+    {
+      static_assert(N>0, "An empty container cannot hold a sequence.");
+      std::array<T,N> a;
+      for(size_t i=0; i<N; ++i) a[i] = start_value + T(i);
+      return a;
+    }
+
+  }}
+  #define test_sequence_vector ::sw::utest::sequence_vector
+  #define test_sequence_array ::sw::utest::sequence_array
+#endif
+
+/**
+ * Hardware and software performance counters of the current thread,
+ * read via `perf_event_open()` (Linux). Counters that cannot be opened
+ * (e.g. no PMU access in containers/VMs) are reported as not available,
+ * page faults and context switches fall back to `getrusage()`.
+ * Opt-in using `WITH_MICROTEST_PERF_COUNTERS`.
+ */
+#ifdef WITH_MICROTEST_PERF_COUNTERS
+  #if defined(__linux__)
+    #include <linux/perf_event.h>
+    #include <sys/syscall.h>
+    #include <sys/ioctl.h>
+    #include <sys/resource.h>
+  #endif
+
+  namespace sw { namespace utest {
+
+    /**
+     * Counted events.
+     */
+    enum class perf_event : unsigned { cycles=0, instructions, cache_misses, branch_misses, page_faults, context_switches };
+
+    /**
+     * Counter values of a `perf_counters` scope.
+     */
+    struct perf_counts
+    {
+      static constexpr unsigned num_events = 6;
+
+      std::uint64_t values[num_events];
+      bool available[num_events];
+
+      perf_counts() noexcept : values(), available()
+      {}
+
+      /**
+       * Returns true if the event was counted.
+       * @param perf_event e
+       * @return bool
+       */
+      bool has(perf_event e) const noexcept
+      { return available[unsigned(e)]; }
+
+      /**
+       * Returns the counted value of an event, 0 if not available.
+       * @param perf_event e
+       * @return std::uint64_t
+       */
+      std::uint64_t value(perf_event e) const noexcept
+      { return available[unsigned(e)] ? values[unsigned(e)] : 0u; }
+
+      /**
+       * Returns the counted value divided by `n`, e.g. instructions
+       * per processed element. 0 if not available.
+       * @param perf_event e
+       * @param double n
+       * @return double
+       */
+      double per(perf_event e, double n) const noexcept
+      { return (n > 0) ? (double(value(e)) / n) : 0.0; }
+
+      /**
+       * Log name of an event.
+       * @param perf_event e
+       * @return const char*
+       */
+      static const char* name(perf_event e) noexcept
+      {
+        static const char* const names[num_events] = { "cycles", "instructions", "cache_misses", "branch_misses", "page_faults", "context_switches" };
+        return (unsigned(e) < num_events) ? names[unsigned(e)] : "";
+      }
+
+      /**
+       * Log output, e.g. `cycles=10432, instructions=20310, ... context_switches=0`,
+       * `n/a` for events not available.
+       */
+      friend std::ostream& operator<<(std::ostream& os, const perf_counts& c)
+      {
+        for(unsigned i=0; i<num_events; ++i) {
+          os << (i ? ", " : "") << name(perf_event(i)) << "=";
+          if(c.available[i]) os << c.values[i]; else os << "n/a";
+        }
+        return os;
+      }
+    };
+
+    namespace detail {
+
+      /**
+       * Log output of counts divided by a number of iterations,
+       * only the available events.
+       */
+      struct perf_counts_per
+      {
+        const perf_counts& counts;
+        double n;
+
+        friend std::ostream& operator<<(std::ostream& os, const perf_counts_per& p)
+        {
+          bool first = true;
+          for(unsigned i=0; i<perf_counts::num_events; ++i) {
+            if(!p.counts.available[i]) continue;
+            os << (first ? "" : ", ") << perf_counts::name(perf_event(i)) << " " << p.counts.per(perf_event(i), p.n);
+            first = false;
+          }
+          if(first) os << "no counters available";
+          return os;
+        }
+      };
+    }
+
+    /**
+     * Scoped counter group of the current thread, counting from construction
+     * until `stop()` (or until read). The counters are not inherited by threads
+     * started in the scope.
+     */
+    class perf_counters
+    {
+    public:
+
+      explicit perf_counters(const detail::check_site* site=nullptr, const char* name=nullptr) noexcept
+        : site_(site), name_(name ? name : ""), stopped_(false), counts_(), start_usage_()
+      {
+        for(unsigned i=0; i<perf_counts::num_events; ++i) fds_[i] = -1;
+        #if defined(__linux__)
+        static const std::uint32_t types[perf_counts::num_events] = { PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_SOFTWARE, PERF_TYPE_SOFTWARE };
+        static const std::uint64_t configs[perf_counts::num_events] = { PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES, PERF_COUNT_SW_PAGE_FAULTS, PERF_COUNT_SW_CONTEXT_SWITCHES };
+        for(unsigned i=0; i<perf_counts::num_events; ++i) fds_[i] = open_event(types[i], configs[i]);
+        start_usage_ = thread_usage();
+        for(unsigned i=0; i<perf_counts::num_events; ++i) {
+          if(fds_[i] >= 0) { ::ioctl(fds_[i], PERF_EVENT_IOC_RESET, 0); ::ioctl(fds_[i], PERF_EVENT_IOC_ENABLE, 0); }
+        }
+        #endif
+      }
+
+      perf_counters(perf_counters&& o) noexcept
+        : site_(o.site_), name_(o.name_), stopped_(o.stopped_), counts_(o.counts_), start_usage_(o.start_usage_)
+      { for(unsigned i=0; i<perf_counts::num_events; ++i) { fds_[i] = o.fds_[i]; o.fds_[i] = -1; } }
+
+      ~perf_counters() noexcept
+      {
+        #if defined(__linux__)
+        for(unsigned i=0; i<perf_counts::num_events; ++i) { if(fds_[i] >= 0) ::close(fds_[i]); }
+        #endif
+      }
+
+      perf_counters(const perf_counters&) = delete;
+      perf_counters& operator=(const perf_counters&) = delete;
+      perf_counters& operator=(perf_counters&&) = delete;
+
+      /**
+       * Stops counting, the values are kept.
+       */
+      void stop() noexcept
+      {
+        if(stopped_) return;
+        #if defined(__linux__)
+        for(unsigned i=0; i<perf_counts::num_events; ++i) {
+          if(fds_[i] >= 0) ::ioctl(fds_[i], PERF_EVENT_IOC_DISABLE, 0);
+        }
+        #endif
+        counts_ = read();
+        stopped_ = true;
+      }
+
+      /**
+       * Returns the counter values (current values if not stopped).
+       * @return perf_counts
+       */
+      perf_counts counts() const noexcept
+      { return stopped_ ? counts_ : read(); }
+
+      /**
+       * Returns true if the event is counted.
+       * @param perf_event e
+       * @return bool
+       */
+      bool has(perf_event e) const noexcept
+      { return counts().has(e); }
+
+      std::uint64_t cycles() const noexcept { return counts().value(perf_event::cycles); }
+      std::uint64_t instructions() const noexcept { return counts().value(perf_event::instructions); }
+      std::uint64_t cache_misses() const noexcept { return counts().value(perf_event::cache_misses); }
+      std::uint64_t branch_misses() const noexcept { return counts().value(perf_event::branch_misses); }
+      std::uint64_t page_faults() const noexcept { return counts().value(perf_event::page_faults); }
+      std::uint64_t context_switches() const noexcept { return counts().value(perf_event::context_switches); }
+
+      /**
+       * Stops counting and logs the values as `[info]` record, e.g.
+       * `perf 'parse': cycles=10432, instructions=20310, ...`.
+       */
+      void report()
+      {
+        stop();
+        const detail::check_site site = site_ ? (*site_) : detail::check_site{"", 0, detail::check_kind::info, nullptr, nullptr};
+        ::sw::utest::test::info(site, "perf '", name_, "': ", counts_);
+      }
+
+      /**
+       * Log output of the counter values.
+       */
+      friend std::ostream& operator<<(std::ostream& os, const perf_counters& p)
+      { return os << p.counts(); }
+
+    private:
+
+      #if defined(__linux__)
+      struct usage { std::uint64_t page_faults, context_switches; bool valid; };
+
+      static usage thread_usage() noexcept
+      {
+        struct ::rusage ru;
+        if(::getrusage(RUSAGE_THREAD, &ru) != 0) return usage{0,0,false};
+        return usage{ std::uint64_t(ru.ru_minflt + ru.ru_majflt), std::uint64_t(ru.ru_nvcsw + ru.ru_nivcsw), true };
+      }
+
+      static int open_event(std::uint32_t type, std::uint64_t config) noexcept
+      {
+        struct ::perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        long fd = ::syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+        if((fd < 0) && (errno == EACCES || errno == EPERM)) {
+          attr.exclude_kernel = 1;  // perf_event_paranoid >= 2
+          fd = ::syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+        }
+        return int(fd);
+      }
+
+      perf_counts read() const noexcept
+      {
+        perf_counts c;
+        for(unsigned i=0; i<perf_counts::num_events; ++i) {
+          if(fds_[i] < 0) continue;
+          std::uint64_t data[3] = {0,0,0}; // value, time enabled, time running
+          if(::read(fds_[i], data, sizeof(data)) != ssize_t(sizeof(data))) continue;
+          // Scaled when multiplexed with other events.
+          c.values[i] = ((data[2] > 0) && (data[2] < data[1])) ? std::uint64_t(double(data[0]) * double(data[1]) / double(data[2])) : data[0];
+          c.available[i] = true;
+        }
+        const unsigned pf = unsigned(perf_event::page_faults), cs = unsigned(perf_event::context_switches);
+        if((!c.available[pf] || !c.available[cs]) && start_usage_.valid) {
+          const usage u = thread_usage();
+          if(u.valid && !c.available[pf]) { c.values[pf] = u.page_faults - start_usage_.page_faults; c.available[pf] = true; }
+          if(u.valid && !c.available[cs]) { c.values[cs] = u.context_switches - start_usage_.context_switches; c.available[cs] = true; }
+        }
+        return c;
+      }
+      #else
+      struct usage { bool valid; };
+
+      perf_counts read() const noexcept
+      { return perf_counts(); }
+      #endif
+
+      const detail::check_site* site_;
+      const char* name_;
+      bool stopped_;
+      perf_counts counts_;
+      usage start_usage_;
+      int fds_[perf_counts::num_events];
+    };
+
+    /**
+     * Starts a named `perf_counters` scope, e.g.
+     * `auto perf = test_perf_counters("parse"); parse(); perf.report();`
+     */
+    #define test_perf_counters(NAME) ::sw::utest::perf_counters(&MICROTEST_UTEST_SITE(info, nullptr, nullptr), NAME)
+
+    namespace detail {
+
+      /**
+       * Performance counters of a `test_section()` run, added to the
+       * section statistics (only the available events).
+       */
+      template <typename=void>
+      class section_perf
+      {
+      public:
+
+        explicit section_perf(const section_scope<>& section) noexcept : section_(section), counters_(), once_(true)
+        {}
+
+        ~section_perf() noexcept
+        {
+          counters_.stop();
+          const perf_counts c = counters_.counts();
+          std::pair<const char*, std::uint64_t> values[perf_counts::num_events];
+          std::size_t n = 0;
+          for(unsigned i=0; i<perf_counts::num_events; ++i) {
+            if(c.available[i]) values[n++] = std::make_pair(perf_counts::name(perf_event(i)), c.values[i]);
+          }
+          try { test_sections<>::add_counters(section_.site(), section_.path(), values, n); } catch(...) { ; }
+        }
+
+        section_perf(const section_perf&) = delete;
+        section_perf& operator=(const section_perf&) = delete;
+
+        bool once() noexcept
+        { const bool first = once_; once_ = false; return first; }
+
+      private:
+
+        const section_scope<>& section_;
+        perf_counters counters_;
+        bool once_;
+      };
+    }
+
+  }}
+#endif
+
+/**
+ * Microbenchmarks: Warmup, automatic iteration count per sample,
+ * and statistics per iteration, reported as `[info]` log record.
+ * Opt-in using `WITH_MICROTEST_BENCHMARK`.
+ */
+#ifdef WITH_MICROTEST_BENCHMARK
+  #include <vector>
+  #include <string>
+  #include <map>
+  #include <algorithm>
+  #include <cstdio>
+
+  namespace sw { namespace utest {
+
+    /**
+     * Prevents the compiler from optimizing away the computation of
+     * `value` (the value is assumed to be read from memory).
+     * @param const T& value
+     */
+    #if defined(__GNUC__) || defined(__clang__)
+    template <typename T>
+    inline void do_not_optimize(const T& value) noexcept
+    { __asm__ __volatile__("" : : "r,m"(value) : "memory"); }
+
+    template <typename T>
+    inline void do_not_optimize(T& value) noexcept
+    { __asm__ __volatile__("" : "+m"(value) : : "memory"); }
+
+    /**
+     * Compiler barrier: All pending memory writes are assumed
+     * to be observed (forces stores not to be elided).
+     */
+    inline void clobber_memory() noexcept
+    { __asm__ __volatile__("" : : : "memory"); }
+    #else
+    template <typename T>
+    inline void do_not_optimize(const T& value) noexcept
+    {
+      static const void* volatile sink = nullptr;
+      sink = static_cast<const void*>(&value);
+      std::atomic_signal_fence(std::memory_order_seq_cst);
+    }
+
+    inline void clobber_memory() noexcept
+    { std::atomic_signal_fence(std::memory_order_seq_cst); }
+    #endif
+
+    /**
+     * Measurement settings of a benchmark.
+     */
+    struct benchmark_options
+    {
+      double warmup_ms = 20;    // Warmup time before the measurement.
+      double measure_ms = 200;  // Total measurement time (all samples).
+      unsigned samples = 50;    // Number of timed samples (batches of iterations).
+    };
+
+    /**
+     * Statistics of a benchmark, times in nanoseconds per iteration.
+     */
+    struct benchmark_result
+    {
+      std::string name;
+      std::uint64_t iterations = 0;   // Iterations per sample.
+      unsigned samples = 0;
+      double min = 0;
+      double median = 0;
+      double mean = 0;
+      double p99 = 0;
+      double stddev = 0;
+      double mad = 0;                 // Median absolute deviation.
+      std::vector<double> sample_ns;  // Sorted per-iteration times of all samples.
+      #ifdef WITH_MICROTEST_PERF_COUNTERS
+      perf_counts counters;           // Counter values of all samples (samples x iterations).
+      #endif
+    };
+
+    /**
+     * Stored reference measurement of a benchmark.
+     */
+    struct benchmark_baseline
+    {
+      double median = 0;     // ns per iteration
+      double mad = 0;        // ns per iteration
+      unsigned samples = 0;
+    };
+
+    namespace detail {
+
+      /**
+       * Baseline file `benchmark.baseline`, located in the directory given by
+       * the environment variable `MICROTEST_BASELINE_DIR` (set by testenv.mk
+       * to the source directory of the test), or the working directory.
+       * Line format: `<name>\t<median ns>\t<mad ns>\t<samples>`.
+       */
+      template <typename=void>
+      struct benchmark_baselines
+      {
+        using entries_type = std::map<std::string, benchmark_baseline>;
+
+        /**
+         * Returns the baseline file path.
+         * @return std::string
+         */
+        static std::string path()
+        {
+          const char* dir = std::getenv("MICROTEST_BASELINE_DIR");
+          return (dir && *dir) ? (std::string(dir) + "/benchmark.baseline") : std::string("benchmark.baseline");
+        }
+
+        /**
+         * Loads the baseline `name`, returns false if not found.
+         * @param const std::string& name
+         * @param benchmark_baseline& baseline
+         * @return bool
+         */
+        static bool load(const std::string& name, benchmark_baseline& baseline)
+        {
+          std::lock_guard<std::mutex> lck(lock_);
+          const auto entries = read();
+          const auto it = entries.find(sanitized(name));
+          if(it == entries.end()) return false;
+          baseline = it->second;
+          return true;
+        }
+
+        /**
+         * Adds or replaces the baseline `name` in the file.
+         * @param const std::string& name
+         * @param const benchmark_baseline& baseline
+         * @return bool
+         */
+        static bool store(const std::string& name, const benchmark_baseline& baseline)
+        {
+          std::lock_guard<std::mutex> lck(lock_);
+          auto entries = read();
+          entries[sanitized(name)] = baseline;
+          std::ofstream os(path(), std::ios::out|std::ios::trunc);
+          if(!os) return false;
+          os.precision(17);
+          for(const auto& e: entries) {
+            os << e.first << '\t' << e.second.median << '\t' << e.second.mad << '\t' << e.second.samples << '\n';
+          }
+          return bool(os);
+        }
+
+      private:
+
+        static std::string sanitized(std::string name)
+        {
+          for(auto& c: name) { if((c == '\t') || (c == '\n') || (c == '\r')) c = ' '; }
+          return name;
+        }
+
+        static entries_type read()
+        {
+          auto entries = entries_type();
+          std::ifstream is(path());
+          auto line = std::string();
+          while(std::getline(is, line)) {
+            const auto p = line.find('\t');
+            if((p == line.npos) || (p == 0)) continue;
+            auto ss = std::stringstream(line.substr(p+1));
+            auto baseline = benchmark_baseline();
+            if(ss >> baseline.median >> baseline.mad >> baseline.samples) entries[line.substr(0, p)] = baseline;
+          }
+          return entries;
+        }
+
+        static std::mutex lock_;
+      };
+
+      template <typename T> std::mutex benchmark_baselines<T>::lock_;
+
+      template <typename=void>
+      struct benchmark
+      {
+        using clock = std::chrono::steady_clock;
+
+        /**
+         * Runs the benchmark `fn` and returns the statistics.
+         * @param const char* name
+         * @param Fn&& fn
+         * @param const benchmark_options& options
+         * @return benchmark_result
+         */
+        template <typename Fn>
+        static benchmark_result run(const char* name, Fn&& fn, const benchmark_options& options)
+        {
+          auto result = benchmark_result();
+          result.name = name ? name : "";
+          const unsigned num_samples = options.samples ? options.samples : 1u;
+          const double sample_ns = (options.measure_ms * 1e6) / double(num_samples);
+          // Warmup and per iteration estimate.
+          std::uint64_t iterations = 1;
+          std::uint64_t timed_iterations = 1;
+          double batch_ns = 0;
+          {
+            const auto t_end = clock::now() + std::chrono::microseconds(std::int64_t(options.warmup_ms * 1e3));
+            do {
+              timed_iterations = iterations;
+              batch_ns = time_batch(fn, timed_iterations);
+              if((batch_ns < sample_ns) && (iterations < (std::uint64_t(1) << 40))) iterations *= 2;
+            } while(clock::now() < t_end);
+          }
+          // Iterations per sample from the estimate (minimum one).
+          const double per_iteration_ns = (batch_ns > 0) ? (batch_ns / double(timed_iterations)) : 1.0;
+          iterations = std::uint64_t(sample_ns / per_iteration_ns);
+          if(iterations < 1) iterations = 1;
+          // Measurement
+          result.iterations = iterations;
+          result.samples = num_samples;
+          result.sample_ns.reserve(num_samples);
+          #ifdef WITH_MICROTEST_PERF_COUNTERS
+          auto counters = perf_counters();
+          #endif
+          for(unsigned i=0; i<num_samples; ++i) {
+            result.sample_ns.push_back(time_batch(fn, iterations) / double(iterations));
+          }
+          #ifdef WITH_MICROTEST_PERF_COUNTERS
+          counters.stop();
+          result.counters = counters.counts();
+          #endif
+          evaluate(result);
+          return result;
+        }
+
+        /**
+         * Sorts the samples and calculates the statistics.
+         * @param benchmark_result& result
+         */
+        static void evaluate(benchmark_result& result) noexcept
+        {
+          auto& v = result.sample_ns;
+          if(v.empty()) return;
+          std::sort(v.begin(), v.end());
+          const std::size_t n = v.size();
+          double sum = 0;
+          for(const auto e: v) sum += e;
+          result.mean = sum / double(n);
+          double sq = 0;
+          for(const auto e: v) sq += (e - result.mean) * (e - result.mean);
+          result.stddev = (n > 1) ? std::sqrt(sq / double(n-1)) : 0.0;
+          result.min = v.front();
+          result.median = (n % 2) ? v[n/2] : ((v[n/2-1] + v[n/2]) / 2);
+          const std::size_t p99_rank = std::size_t(std::ceil(0.99 * double(n)));
+          result.p99 = v[(p99_rank > 0) ? (p99_rank-1) : 0];
+          auto deviations = std::vector<double>();
+          deviations.reserve(n);
+          for(const auto e: v) deviations.push_back(std::abs(e - result.median));
+          std::sort(deviations.begin(), deviations.end());
+          result.mad = (n % 2) ? deviations[n/2] : ((deviations[n/2-1] + deviations[n/2]) / 2);
+        }
+
+        /**
+         * Returns the slowest acceptable median for a baseline: The relative
+         * `tolerance` above the baseline median, plus three standard errors
+         * of the difference of both medians (robust sigma from the MAD).
+         * @param const benchmark_baseline& baseline
+         * @param const benchmark_result& current
+         * @param double tolerance
+         * @return double
+         */
+        static double threshold(const benchmark_baseline& baseline, const benchmark_result& current, double tolerance) noexcept
+        {
+          const auto standard_error = [](double mad, unsigned samples) {
+            return 1.253 * 1.4826 * mad / std::sqrt(double(samples ? samples : 1u));
+          };
+          const double se_baseline = standard_error(baseline.mad, baseline.samples);
+          const double se_current = standard_error(current.mad, current.samples);
+          return baseline.median * (1.0 + tolerance) + 3.0 * std::sqrt(se_baseline*se_baseline + se_current*se_current);
+        }
+
+        /**
+         * Measures `fn` and compares the median with the stored baseline
+         * `name`. A check fails if the median exceeds the threshold (also
+         * after one re-measurement). Missing baselines are warned about.
+         * In update mode (`MICROTEST_UPDATE_BASELINES` set), the baseline
+         * is (re-)written instead.
+         * @param const check_site& site
+         * @param const char* name
+         * @param double tolerance
+         * @param Fn&& fn
+         * @param const benchmark_options& options
+         * @return bool
+         */
+        template <typename Fn>
+        static bool expect_faster_than(const check_site& site, const char* name, double tolerance, Fn&& fn, const benchmark_options& options)
+        {
+          auto current = run(name, fn, options);
+          report(site, current);
+          auto baseline = benchmark_baseline();
+          if(baseline_update()) {
+            baseline.median = current.median;
+            baseline.mad = current.mad;
+            baseline.samples = current.samples;
+            if(!benchmark_baselines<>::store(current.name, baseline)) {
+              return ::sw::utest::test::fail(site, "Failed to write baseline '", current.name, "' to ", benchmark_baselines<>::path());
+            }
+            return ::sw::utest::test::pass(site, "Baseline '", current.name, "' updated: ", duration_text(baseline.median));
+          }
+          if(!benchmark_baselines<>::load(current.name, baseline)) {
+            ::sw::utest::test::warning(site, "No baseline '", current.name, "' in ", benchmark_baselines<>::path(), " (update with `make test UPDATE_BASELINES=1`)");
+            return true;
+          }
+          double limit = threshold(baseline, current, tolerance);
+          if(current.median > limit) {
+            auto retry = run(name, fn, options);
+            if(retry.median < current.median) {
+              current = std::move(retry);
+              report(site, current);
+              limit = threshold(baseline, current, tolerance);
+            }
+          }
+          if(current.median <= limit) {
+            return ::sw::utest::test::pass(site, "benchmark '", current.name, "': median ", duration_text(current.median), " <= ", duration_text(limit),
+              " (baseline ", duration_text(baseline.median), " +", tolerance*100, "%)");
+          } else {
+            return ::sw::utest::test::fail(site, "benchmark '", current.name, "': median ", duration_text(current.median), " > ", duration_text(limit),
+              " (baseline ", duration_text(baseline.median), " +", tolerance*100, "%)");
+          }
+        }
+
+        /**
+         * Returns true if baselines shall be written instead of compared,
+         * enabled via environment variable `MICROTEST_UPDATE_BASELINES`.
+         * @return bool
+         */
+        static bool baseline_update() noexcept
+        {
+          const char* e = std::getenv("MICROTEST_UPDATE_BASELINES");
+          return e && *e && (std::string(e) != "0");
+        }
+
+        /**
+         * Returns a time duration text with suitable unit (ns, us, ms, s).
+         * @param double ns
+         * @return std::string
+         */
+        static std::string duration_text(double ns)
+        {
+          char buf[32];
+          if(ns < 1e3) {
+            std::snprintf(buf, sizeof(buf), "%.3gns", ns);
+          } else if(ns < 1e6) {
+            std::snprintf(buf, sizeof(buf), "%.3gus", ns / 1e3);
+          } else if(ns < 1e9) {
+            std::snprintf(buf, sizeof(buf), "%.3gms", ns / 1e6);
+          } else {
+            std::snprintf(buf, sizeof(buf), "%.3gs", ns / 1e9);
+          }
+          return std::string(buf);
+        }
+
+        /**
+         * Logs the statistics as info record.
+         * @param const check_site& site
+         * @param const benchmark_result& result
+         */
+        static void report(const check_site& site, const benchmark_result& r)
+        {
+          ::sw::utest::test::info(site, "benchmark '", r.name, "': ", duration_text(r.median), "/iteration",
+            " (min ", duration_text(r.min), ", median ", duration_text(r.median), ", mean ", duration_text(r.mean),
+            ", p99 ", duration_text(r.p99), ", stddev ", duration_text(r.stddev), "; ",
+            r.samples, " samples x ", r.iterations, " iterations)"
+            #ifdef WITH_MICROTEST_PERF_COUNTERS
+            , "\nper iteration: ", detail::perf_counts_per{r.counters, double(r.samples) * double(r.iterations)}
+            #endif
+          );
+        }
+
+      private:
+
+        template <typename Fn>
+        static double time_batch(Fn& fn, std::uint64_t iterations)
+        {
+          const auto t0 = clock::now();
+          for(std::uint64_t i=0; i<iterations; ++i) fn();
+          const auto t1 = clock::now();
+          return double(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+        }
+      };
+
+    }
+
+    /**
+     * Runs a benchmark, logs and returns the statistics.
+     * @param const detail::check_site& site
+     * @param const char* name
+     * @param Fn&& fn
+     * @param const benchmark_options& options
+     * @return benchmark_result
+     */
+    template <typename Fn>
+    benchmark_result benchmark(const detail::check_site& site, const char* name, Fn&& fn, const benchmark_options& options=benchmark_options())
+    {
+      auto result = detail::benchmark<>::run(name, std::forward<Fn>(fn), options);
+      detail::benchmark<>::report(site, result);
+      return result;
+    }
+
+    /**
+     * Benchmarks `fn`, and registers a failed check if the median time per
+     * iteration is significantly slower than the stored baseline `name`
+     * plus the relative `tolerance` (e.g. 0.1 for 10%).
+     * @param const detail::check_site& site
+     * @param const char* name
+     * @param double tolerance
+     * @param Fn&& fn
+     * @param const benchmark_options& options
+     * @return bool
+     */
+    template <typename Fn>
+    bool expect_faster_than(const detail::check_site& site, const char* name, double tolerance, Fn&& fn, const benchmark_options& options=benchmark_options())
+    { return detail::benchmark<>::expect_faster_than(site, name, tolerance, std::forward<Fn>(fn), options); }
+
+    #define test_benchmark(...) ::sw::utest::benchmark(MICROTEST_UTEST_SITE(benchmark, nullptr, nullptr), __VA_ARGS__)
+    #define test_expect_faster_than(...) ::sw::utest::expect_faster_than(MICROTEST_UTEST_SITE(benchmark, nullptr, nullptr), __VA_ARGS__)
+    #define test_do_not_optimize ::sw::utest::do_not_optimize
+    #define test_clobber_memory ::sw::utest::clobber_memory
+
+  }}
+#endif
+
+/**
+ * Heap allocation accounting. The global `operator new`/`delete` are
+ * replaced in the translation unit that defines `main()` (`WITH_MICROTEST_MAIN`),
+ * and `alloc_scope` objects provide the counts from their construction on.
+ * Opt-in using `WITH_MICROTEST_ALLOC_TRACKING`.
+ */
+#ifdef WITH_MICROTEST_ALLOC_TRACKING
+  #include <new>
+  #include <cstddef>
+
+  namespace sw { namespace utest {
+
+    namespace detail {
+
+      /**
+       * Allocation counters, process wide (atomic) and per thread.
+       * Each allocation has a header in front of the returned memory,
+       * containing the requested size and the pointer to free.
+       */
+      template <typename=void>
+      struct alloc_tracker
+      {
+        struct counts
+        {
+          std::uint64_t allocations;
+          std::uint64_t frees;
+          std::uint64_t bytes;
+        };
+
+        static constexpr std::size_t header_size = (alignof(std::max_align_t) > 16) ? alignof(std::max_align_t) : 16;
+
+        struct header
+        {
+          std::size_t size;
+          void* base;
+        };
+
+        static void* allocate(std::size_t size, std::size_t alignment) noexcept
+        {
+          if(alignment <= header_size) {
+            char* const base = static_cast<char*>(std::malloc(size + header_size));
+            if(!base) return nullptr;
+            return track(base, base + header_size, size);
+          } else {
+            char* const base = static_cast<char*>(std::malloc(size + header_size + alignment));
+            if(!base) return nullptr;
+            const std::uintptr_t p = (reinterpret_cast<std::uintptr_t>(base) + header_size + alignment - 1) & ~std::uintptr_t(alignment - 1);
+            return track(base, reinterpret_cast<char*>(p), size);
+          }
+        }
+
+        static void deallocate(void* ptr) noexcept
+        {
+          if(!ptr) return;
+          header h;
+          std::memcpy(&h, static_cast<char*>(ptr) - sizeof(header), sizeof(header));
+          frees_.fetch_add(1, std::memory_order_relaxed);
+          live_.fetch_sub(std::int64_t(h.size), std::memory_order_relaxed);
+          ++local().frees;
+          std::free(h.base);
+        }
+
+        static counts global() noexcept
+        {
+          return counts{
+            allocations_.load(std::memory_order_relaxed),
+            frees_.load(std::memory_order_relaxed),
+            bytes_.load(std::memory_order_relaxed)
+          };
+        }
+
+        static counts& local() noexcept
+        { thread_local counts c = {0,0,0}; return c; }
+
+        /**
+         * Allocations of the current thread inside a no-allocation region,
+         * see `test_expect_no_alloc()`. The first `max_sizes` requested
+         * sizes are kept for the failure report.
+         */
+        struct region_state
+        {
+          static constexpr std::size_t max_sizes = 8;
+          bool active;
+          std::uint64_t allocations;
+          std::uint64_t bytes;
+          std::size_t num_sizes;
+          std::size_t sizes[max_sizes];
+        };
+
+        static region_state& region() noexcept
+        { thread_local region_state r = {false,0,0,0,{0}}; return r; }
+
+        static std::int64_t live() noexcept
+        { return live_.load(std::memory_order_relaxed); }
+
+        static std::int64_t peak() noexcept
+        { return peak_.load(std::memory_order_relaxed); }
+
+        /**
+         * Restarts the peak tracking at the current live bytes, returns
+         * the previous peak (for restoring it when a scope ends).
+         */
+        static std::int64_t restart_peak() noexcept
+        { return peak_.exchange(live_.load(std::memory_order_relaxed), std::memory_order_relaxed); }
+
+        /**
+         * Merges a peak of an enclosing scope back.
+         */
+        static void merge_peak(std::int64_t value) noexcept
+        { update_peak(value); }
+
+      private:
+
+        static void* track(char* base, char* ptr, std::size_t size) noexcept
+        {
+          const header h = { size, base };
+          std::memcpy(ptr - sizeof(header), &h, sizeof(header));
+          allocations_.fetch_add(1, std::memory_order_relaxed);
+          bytes_.fetch_add(size, std::memory_order_relaxed);
+          update_peak(live_.fetch_add(std::int64_t(size), std::memory_order_relaxed) + std::int64_t(size));
+          counts& c = local();
+          ++c.allocations;
+          c.bytes += size;
+          region_state& r = region();
+          if(r.active) {
+            ++r.allocations;
+            r.bytes += size;
+            if(r.num_sizes < region_state::max_sizes) r.sizes[r.num_sizes++] = size;
+          }
+          return ptr;
+        }
+
+        static void update_peak(std::int64_t value) noexcept
+        {
+          std::int64_t current = peak_.load(std::memory_order_relaxed);
+          while((value > current) && !peak_.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+        }
+
+        static std::atomic<std::uint64_t> allocations_;
+        static std::atomic<std::uint64_t> frees_;
+        static std::atomic<std::uint64_t> bytes_;
+        static std::atomic<std::int64_t> live_;
+        static std::atomic<std::int64_t> peak_;
+      };
+
+      template <typename T> constexpr std::size_t alloc_tracker<T>::header_size;
+      template <typename T> constexpr std::size_t alloc_tracker<T>::region_state::max_sizes;
+      template <typename T> std::atomic<std::uint64_t> alloc_tracker<T>::allocations_(0);
+      template <typename T> std::atomic<std::uint64_t> alloc_tracker<T>::frees_(0);
+      template <typename T> std::atomic<std::uint64_t> alloc_tracker<T>::bytes_(0);
+      template <typename T> std::atomic<std::int64_t> alloc_tracker<T>::live_(0);
+      template <typename T> std::atomic<std::int64_t> alloc_tracker<T>::peak_(0);
+
+      /**
+       * No-allocation region of the current thread, used by `test_expect_no_alloc()`.
+       * Regions can be nested, allocations in an inner region also count for
+       * the enclosing ones.
        */
-      template <typename R, typename A1, typename A2>
-      typename std::enable_if<
-        std::is_integral<typename std::decay<A1>::type>::value &&
-        std::is_integral<typename std::decay<A2>::type>::value && (
-          std::is_same<typename std::decay<R>::type, char>::value ||
-          std::is_same<typename std::decay<R>::type, unsigned char>::value
-        ),
-        void
-      >
-      ::type rnd(R& r, A1 min, A2 max)
-      { auto rr = 0; rnd(rr, int(min), int(max)); r = R(rr); }
+      template <typename=void>
+      class alloc_region
+      {
+      public:
+
+        using tracker = alloc_tracker<>;
+        using state_type = typename tracker::region_state;
+
+        alloc_region() noexcept : outer_(tracker::region())
+        {
+          state_type& r = tracker::region();
+          r = state_type{true,0,0,0,{0}};
+        }
+
+        ~alloc_region() noexcept
+        {
+          const state_type inner = tracker::region();
+          state_type& r = tracker::region();
+          r = outer_;
+          if(!r.active) return;
+          r.allocations += inner.allocations;
+          r.bytes += inner.bytes;
+          for(std::size_t i=0; (i < inner.num_sizes) && (r.num_sizes < state_type::max_sizes); ++i) {
+            r.sizes[r.num_sizes++] = inner.sizes[i];
+          }
+        }
+
+        alloc_region(const alloc_region&) = delete;
+        alloc_region& operator=(const alloc_region&) = delete;
+
+        /**
+         * Snapshot of the allocations in this region so far.
+         * @return state_type
+         */
+        state_type state() const noexcept
+        { return tracker::region(); }
+
+        /**
+         * Log output of the offending allocations, e.g. `2 heap allocation(s), 124 bytes (sizes 24, 100)`.
+         */
+        struct report
+        {
+          state_type state;
+
+          friend std::ostream& operator<<(std::ostream& os, const report& rp)
+          {
+            os << rp.state.allocations << " heap allocation(s), " << rp.state.bytes << " bytes (sizes ";
+            for(std::size_t i=0; i<rp.state.num_sizes; ++i) os << (i ? ", " : "") << rp.state.sizes[i];
+            if(rp.state.allocations > rp.state.num_sizes) os << ", ...";
+            return os << ")";
+          }
+        };
+
+      private:
+
+        const state_type outer_;
+      };
+    }
+
+    /**
+     * Allocation counts since the construction of the scope object, either
+     * of all threads (default), or only of the constructing thread. The peak
+     * and live bytes are always process wide. Scopes are expected to be
+     * nested (destroyed in reverse construction order).
+     */
+    class alloc_scope
+    {
+    public:
+
+      enum mode_type { all_threads=0, this_thread };
+
+      explicit alloc_scope(mode_type mode=all_threads) noexcept
+        : mode_(mode), start_(current()), live_start_(tracker::live()), outer_peak_(tracker::restart_peak()), active_(true)
+      {}
+
+      alloc_scope(alloc_scope&& o) noexcept
+        : mode_(o.mode_), start_(o.start_), live_start_(o.live_start_), outer_peak_(o.outer_peak_), active_(o.active_)
+      { o.active_ = false; }
+
+      ~alloc_scope() noexcept
+      { if(active_) tracker::merge_peak(outer_peak_); }
+
+      alloc_scope(const alloc_scope&) = delete;
+      alloc_scope& operator=(const alloc_scope&) = delete;
+      alloc_scope& operator=(alloc_scope&&) = delete;
 
       /**
-       * Random for byte types, uniform distribution, 0 to max, single value request.
-       * @param T& r
-       * @param T max
+       * Number of allocations (`new`) in this scope.
+       * @return std::uint64_t
        */
-      template <typename R, typename A1>
-      typename std::enable_if<
-        std::is_integral<typename std::decay<A1>::type>::value && (
-          std::is_same<typename std::decay<R>::type, char>::value ||
-          std::is_same<typename std::decay<R>::type, unsigned char>::value
-        ),
-        void
-      >
-      ::type rnd(R& r, A1 max)
-      { auto rr = 0; rnd(rr, 0, max); r = R(rr); }
+      std::uint64_t allocations() const noexcept
+      { return current().allocations - start_.allocations; }
 
       /**
-       * Random for byte types, uniform distribution, over the complete type value
-       * range, single value request.
-       * @param T& r
+       * Number of deallocations (`delete`) in this scope.
+       * @return std::uint64_t
        */
-      template <typename R>
-      typename std::enable_if<
-        std::is_same<typename std::decay<R>::type, char>::value ||
-        std::is_same<typename std::decay<R>::type, unsigned char>::value,
-        void
-      >
-      ::type rnd(R& r)
-      { auto rr = 0; rnd(rr, int(std::numeric_limits<R>::min()), int(std::numeric_limits<R>::max())); r = R(rr); }
+      std::uint64_t frees() const noexcept
+      { return current().frees - start_.frees; }
 
       /**
-       * Random string, fixed length, uniform dist, values: space (32) to '~' (126)
-       * @param std::basic_string<typename R>& r
-       * @param int length
+       * Sum of all allocated bytes in this scope.
+       * @return std::uint64_t
        */
-      template <typename R>
-      void rnd(std::basic_string<R>& r, typename std::basic_string<R>::size_type length)
-      {
-        if(length < 1) { r.clear(); return; }
-        typedef std::basic_string<R> str_t;
-        str_t s(length, typename str_t::value_type());
-        std::uniform_int_distribution<int> d(int(' '), int('~'));
-        for(auto& e:s) e = char(d(rnddev<>::uni));
-        r.swap(s);
-      }
+      std::uint64_t bytes() const noexcept
+      { return current().bytes - start_.bytes; }
 
       /**
-       * Random arithmetic container, fixed length, uniform distribution, from --> to
-       * Note: No Concept yet in std=c++11, the filter used here applies to objects that
-       * meet the requirements: They must have have allocator, iterator, integral size_type,
-       * arithmetic value_type; arguments 'min' and 'max' are convertible to value_type, argument
-       * 'size' is convertible to size_type, and the object can be constructed with
-       * Class(size_type, value_type) for reservation of the required memory space.
-       *
-       * Means it fits pretty much to STL containers, but not only. Hence, this filter may
-       * fail if the object does not have the methods clear() and swap(...).
+       * Maximum of the additionally allocated (live) bytes in this scope.
+       * @return std::uint64_t
        */
-      template <typename R, typename Sz, typename A1, typename A2>
-      typename std::enable_if<
-        std::is_object<R>::value &&
-        std::is_object<typename R::iterator>::value &&
-        std::is_object<typename R::allocator_type>::value &&
-        std::is_integral<typename R::size_type>::value &&
-        std::is_constructible<R, typename R::size_type, typename R::value_type>::value &&
-        std::is_arithmetic<typename std::decay<typename R::value_type>::type>::value &&
-        std::is_convertible<typename std::decay<Sz>::type, typename R::size_type>::value &&
-        std::is_convertible<typename std::decay<A1>::type, typename R::value_type>::value &&
-        std::is_convertible<typename std::decay<A2>::type, typename R::value_type>::value,
-        void
-      >
-      ::type rnd(R& r, Sz sz, A1 min, A2 max)
+      std::uint64_t peak_bytes() const noexcept
+      { const std::int64_t d = tracker::peak() - live_start_; return (d > 0) ? std::uint64_t(d) : 0u; }
+
+      /**
+       * Bytes allocated in the scope and not freed yet (can be negative
+       * if memory allocated before the scope was freed).
+       * @return std::int64_t
+       */
+      std::int64_t live_bytes() const noexcept
+      { return tracker::live() - live_start_; }
+
+      /**
+       * Restarts counting.
+       */
+      void reset() noexcept
       {
-        if(sz < 1) { r.clear(); return; }
-        R container(static_cast<typename R::size_type>(sz), typename R::value_type());
-        for(auto& e: container) rnd(e, min, max);
-        r.swap(container);
+        const std::int64_t peak = tracker::restart_peak();
+        if(peak > outer_peak_) outer_peak_ = peak;
+        start_ = current();
+        live_start_ = tracker::live();
       }
 
       /**
-       * Random arithmetic container, given length, uniform distribution,
-       * from MIN to MAX of the value type.
+       * Log output, e.g. `test_info("Allocations: ", scope);`
        */
-      template <typename R, typename Sz>
-      typename std::enable_if<
-        std::is_object<R>::value &&
-        std::is_object<typename R::iterator>::value &&
-        std::is_object<typename R::allocator_type>::value &&
-        std::is_integral<typename R::size_type>::value &&
-        std::is_constructible<R, typename R::size_type, typename R::value_type>::value &&
-        std::is_arithmetic<typename std::decay<typename R::value_type>::type>::value &&
-        std::is_convertible<typename std::decay<Sz>::type, typename R::size_type>::value &&
-        !std::is_same<typename std::decay<R>::type, std::string>::value &&
-        !std::is_same<typename std::decay<R>::type, std::wstring>::value,
-        void
-      >
-      ::type rnd(R& r, Sz sz)
+      friend std::ostream& operator<<(std::ostream& os, const alloc_scope& s)
       {
-        if(sz < 1) { r.clear(); return; }
-        R container(static_cast<typename R::size_type>(sz), typename R::value_type());
-        for(auto& e: container) rnd(e);
-        r.swap(container);
+        return os << "allocations=" << s.allocations() << ", frees=" << s.frees() << ", bytes=" << s.bytes()
+                  << ", peak_bytes=" << s.peak_bytes() << ", live_bytes=" << s.live_bytes();
       }
 
-    }
-
-    /**
-     * Random value generation. Relay function template.
-     */
-    template <typename R, typename ...Args>
-    static inline R random(Args&& ...args)
-    { auto r = R(); random_generators::rnd(r, std::forward<Args>(args)...); return r; }
+    private:
 
-  #endif
-}}
+      using tracker = detail::alloc_tracker<>;
 
-/**
- * Auxiliary generators.
- */
-#ifdef WITH_MICROTEST_GENERATORS
-  #include <vector>
-  #include <string>
-  #include <array>
+      tracker::counts current() const noexcept
+      { return (mode_ == this_thread) ? tracker::local() : tracker::global(); }
 
-  namespace sw { namespace utest {
+      mode_type mode_;
+      tracker::counts start_;
+      std::int64_t live_start_;
+      std::int64_t outer_peak_;
+      bool active_;
+    };
 
-    /**
-     * Generates a sequential value test vector, with
-     * a given element type T, a size N, and with the
-     * first value being `start_value`.
-     * @tparam typename T
-     * @tparam size_t N
-     * @return std::vector<T>
-     */
-    template <typename T, size_t N>
-    std::vector<T> sequence_vector(T start_value)
-    {
-      static_assert(N>0, "An empty container cannot hold a sequence.");
-      auto v = std::vector<T>();
-      v.reserve(N);
-      for(size_t i=0; i<N; ++i) v.push_back(start_value + T(i));
-      return v;
-    }
+    #define test_alloc_scope ::sw::utest::alloc_scope
 
     /**
-     * Generates a sequential value test array, with
-     * a given element type T, a size N, and with the
-     * first value being `start_value`.
-     * @tparam typename T
-     * @tparam size_t N
-     * @return std::array<T,N>
+     * Registers a passed check if the given statement or block does not
+     * allocate heap memory in the current thread, otherwise a failed check
+     * with the number of allocations, bytes, and the first requested sizes.
+     * Exceptions fail the check as well.
+     * E.g. `test_expect_no_alloc({ parser.parse(input); });`
+     * @param Statements...
+     * @return void
      */
-    template <typename T, size_t N>
-    std::array<T,N> sequence_array(T start_value)
-    {
-      static_assert(N>0, "An empty container cannot hold a sequence.");
-      std::array<T,N> a;
-      for(size_t i=0; i<N; ++i) a[i] = start_value + T(i);
-      return a;
+    #define test_expect_no_alloc(...) { \
+      const ::sw::utest::detail::check_site& microtest_site_ = MICROTEST_UTEST_SITE(noalloc, #__VA_ARGS__, nullptr); \
+      try { \
+        auto microtest_state_ = ::sw::utest::detail::alloc_region<>::state_type(); \
+        { \
+          const ::sw::utest::detail::alloc_region<> microtest_region_; \
+          { __VA_ARGS__; } \
+          microtest_state_ = microtest_region_.state(); \
+        } \
+        if(!microtest_state_.allocations) { \
+          (void)::sw::utest::test::commit(true, microtest_site_); \
+        } else { \
+          (void)::sw::utest::test::commit(false, microtest_site_, #__VA_ARGS__ " | ", ::sw::utest::detail::alloc_region<>::report{microtest_state_}); \
+        } \
+      } catch(const std::exception& e) { \
+        (::sw::utest::test::fail(microtest_site_, #__VA_ARGS__ " | Unexpected exception: ", e.what())); \
+      } catch(...) { \
+        (::sw::utest::test::fail(microtest_site_, #__VA_ARGS__ " | Unexpected exception")); \
+      } \
     }
 
-    #define test_sequence_vector ::sw::utest::sequence_vector
-    #define test_sequence_array ::sw::utest::sequence_array
-
   }}
 #endif
 
@@ -1400,15 +6491,136 @@ namespace sw { namespace utest {
   #include <string>
   auto testenv_argv = std::vector<std::string>();
   auto testenv_envv = std::vector<std::string>();
-  void test(const std::vector<std::string>& args);
+  #if defined(WITH_MICROTEST_CASES) && (defined(__GNUC__) || defined(__clang__)) && !defined(_WIN32)
+    // Optional with registered `test_case()`s (weak declaration).
+    void test(const std::vector<std::string>& args) __attribute__((weak));
+  #else
+    void test(const std::vector<std::string>& args);
+  #endif
   int main(int argc, char* argv[], char* envv[])
   {
+    using args = ::sw::utest::detail::test_case_args<>;
+    unsigned jobs = 1;
+    bool isolate = false;
+    double timeout_s = 0;
+    unsigned shard_index = 1, shard_count = 1;
+    auto reporter = ::sw::utest::test::report_text;
+    for(size_t i=1; (i<size_t(argc)) && (argv[i]!=nullptr); ++i) {
+      if(std::strncmp(argv[i], "--seed=", 7) == 0) {
+        std::uint64_t seed = 0;
+        if(!::sw::utest::detail::random_seed<>::parse(argv[i]+7, seed)) { std::fprintf(stderr, "[fail] Invalid argument '%s' (expected --seed=N, decimal or 0x hex)\n", argv[i]); return 2; }
+        ::sw::utest::test::random_seed(seed);
+      } else if(std::strncmp(argv[i], "--jobs=", 7) == 0) {
+        if(!args::parse_jobs(argv[i]+7, jobs)) { std::fprintf(stderr, "[fail] Invalid argument '%s' (expected --jobs=N, 0 <= N <= 4096)\n", argv[i]); return 2; }
+      } else if(std::strncmp(argv[i], "--shard=", 8) == 0) {
+        if(!args::parse_shard(argv[i]+8, shard_index, shard_count)) { std::fprintf(stderr, "[fail] Invalid argument '%s' (expected --shard=I/N, 1 <= I <= N)\n", argv[i]); return 2; }
+      } else if(std::strncmp(argv[i], "--reporter=", 11) == 0) {
+        if(!::sw::utest::test::parse_reporter(argv[i]+11, reporter)) { std::fprintf(stderr, "[fail] Invalid argument '%s' (expected --reporter=text|jsonl|junit|tap|binary)\n", argv[i]); return 2; }
+        ::sw::utest::test::reporter(reporter, MICROTEST_UTEST_BASE_FILE);
+      } else if(std::strncmp(argv[i], "--fail-log-limit=", 17) == 0) {
+        unsigned limit = 0;
+        if(!args::parse_fail_log_limit(argv[i]+17, limit)) { std::fprintf(stderr, "[fail] Invalid argument '%s' (expected --fail-log-limit=N, N >= 0)\n", argv[i]); return 2; }
+        ::sw::utest::test::fail_log_limit(limit);
+      } else if(std::strcmp(argv[i], "--isolate") == 0) {
+        isolate = true;
+      } else if(std::strncmp(argv[i], "--timeout=", 10) == 0) {
+        if(!args::parse_timeout(argv[i]+10, timeout_s)) { std::fprintf(stderr, "[fail] Invalid argument '%s' (expected --timeout=SECONDS, >= 0)\n", argv[i]); return 2; }
+      }
+    }
     test_initialize();
     for(size_t i=1; (i<size_t(argc)) && (argv[i]!=nullptr); ++i) { testenv_argv.push_back(argv[i]); }
     for(size_t i=0; envv[i]!=nullptr; ++i) { testenv_envv.push_back(envv[i]); }
-    test(testenv_argv);
+    // `test()` is sharded like a test case named "test()".
+    const args::entry main_entry{"test()", __FILE__, __LINE__, nullptr};
+    #ifdef WITH_MICROTEST_CASES
+    void (*const test_fn)(const std::vector<std::string>&) = &test;
+    if(test_fn && args::in_shard(main_entry, shard_index, shard_count)) test_fn(testenv_argv);
+    if(shard_count > 1) {
+      ::sw::utest::detail::test_cases<>::shard(shard_index, shard_count);
+    }
+    if(isolate) {
+      ::sw::utest::detail::test_cases<>::run_isolated(jobs, timeout_s);
+    } else {
+      ::sw::utest::detail::test_cases<>::run(jobs);
+    }
+    #else
+    if(args::in_shard(main_entry, shard_index, shard_count)) test(testenv_argv);
+    (void)isolate; (void)timeout_s; (void)jobs;
+    #endif
     return test_summary();
   }
+
+  #ifdef WITH_MICROTEST_ALLOC_TRACKING
+    void* operator new(std::size_t size)
+    {
+      if(void* p = ::sw::utest::detail::alloc_tracker<>::allocate(size, 0)) return p;
+      throw std::bad_alloc();
+    }
+
+    void* operator new[](std::size_t size)
+    { return ::operator new(size); }
+
+    void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+    { return ::sw::utest::detail::alloc_tracker<>::allocate(size, 0); }
+
+    void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+    { return ::sw::utest::detail::alloc_tracker<>::allocate(size, 0); }
+
+    void operator delete(void* p) noexcept
+    { ::sw::utest::detail::alloc_tracker<>::deallocate(p); }
+
+    void operator delete[](void* p) noexcept
+    { ::sw::utest::detail::alloc_tracker<>::deallocate(p); }
+
+    void operator delete(void* p, const std::nothrow_t&) noexcept
+    { ::sw::utest::detail::alloc_tracker<>::deallocate(p); }
+
+    void operator delete[](void* p, const std::nothrow_t&) noexcept
+    { ::sw::utest::detail::alloc_tracker<>::deallocate(p); }
+
+    #if defined(__cpp_sized_deallocation) || (defined(_MSC_VER) && (__cplusplus >= 201402L))
+    void operator delete(void* p, std::size_t) noexcept
+    { ::sw::utest::detail::alloc_tracker<>::deallocate(p); }
+
+    void operator delete[](void* p, std::size_t) noexcept
+    { ::sw::utest::detail::alloc_tracker<>::deallocate(p); }
+    #endif
+
+    #ifdef __cpp_aligned_new
+    void* operator new(std::size_t size, std::align_val_t al)
+    {
+      if(void* p = ::sw::utest::detail::alloc_tracker<>::allocate(size, std::size_t(al))) return p;
+      throw std::bad_alloc();
+    }
+
+    void* operator new[](std::size_t size, std::align_val_t al)
+    { return ::operator new(size, al); }
+
+    void* operator new(std::size_t size, std::align_val_t al, const std::nothrow_t&) noexcept
+    { return ::sw::utest::detail::alloc_tracker<>::allocate(size, std::size_t(al)); }
+
+    void* operator new[](std::size_t size, std::align_val_t al, const std::nothrow_t&) noexcept
+    { return ::sw::utest::detail::alloc_tracker<>::allocate(size, std::size_t(al)); }
+
+    void operator delete(void* p, std::align_val_t) noexcept
+    { ::sw::utest::detail::alloc_tracker<>::deallocate(p); }
+
+    void operator delete[](void* p, std::align_val_t) noexcept
+    { ::sw::utest::detail::alloc_tracker<>::deallocate(p); }
+
+    void operator delete(void* p, std::size_t, std::align_val_t) noexcept
+    { ::sw::utest::detail::alloc_tracker<>::deallocate(p); }
+
+    void operator delete[](void* p, std::size_t, std::align_val_t) noexcept
+    { ::sw::utest::detail::alloc_tracker<>::deallocate(p); }
+
+    void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept
+    { ::sw::utest::detail::alloc_tracker<>::deallocate(p); }
+
+    void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept
+    { ::sw::utest::detail::alloc_tracker<>::deallocate(p); }
+    #endif
+  #endif
 #endif
 
 /**
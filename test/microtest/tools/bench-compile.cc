@@ -0,0 +1,211 @@
+/**
+ * @file bench-compile.cc
+ * @tool bench-compile
+ *
+ * Compile time benchmark of `microtest.hh` (`make bench-compile`): Generates a
+ * synthetic test translation unit with a given number of checks of mixed
+ * operand types, compiles it with the given compiler command, and prints one
+ * result row: compile wall time, peak memory of the compiler processes (max.
+ * resident set size), object size, and the number of weak symbols defined in
+ * the object (the emitted template instantiations and inline functions, read
+ * with `nm`, -1 when not available). With several runs, the minimum wall
+ * time is reported.
+ *
+ *  Usage: bench-compile --checks=<n> --dir=<output directory> [--label=<text>]
+ *                       [--runs=<n>] -- <compiler> [<flags>...]
+ *         bench-compile --header
+ *
+ *  Output columns: <label> <checks> <wall s> <peak MB> <object kB> <weak symbols>
+ *
+ *  Exit code: 0 when compiled, 1 on compile errors, 2 on invalid arguments or
+ *  when not supported on the platform (POSIX only).
+ */
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <cerrno>
+#if defined(__unix__) || defined(__unix) || defined(__APPLE__)
+  #include <unistd.h>
+  #include <fcntl.h>
+  #include <sys/stat.h>
+  #include <sys/wait.h>
+  #include <sys/resource.h>
+  #define BENCH_COMPILE_POSIX
+#endif
+
+namespace {
+
+  int usage()
+  {
+    std::cerr << "Usage: bench-compile --checks=<n> --dir=<output directory> [--label=<text>] [--runs=<n>] -- <compiler> [<flags>...]\n"
+              << "       bench-compile --header\n";
+    return 2;
+  }
+
+  /**
+   * Synthetic test source: `WITH_MICROTEST_MAIN`, `n` checks in functions of
+   * 100 checks, cycling through int, double, string, and size comparisons.
+   */
+  std::string synthetic_test(unsigned n)
+  {
+    auto ss = std::stringstream();
+    ss << "#define WITH_MICROTEST_MAIN\n"
+       << "#include <microtest.hh>\n"
+       << "#include <string>\n"
+       << "#include <vector>\n\n"
+       << "namespace {\n";
+    const unsigned functions = (n + 99) / 100;
+    for(unsigned f=0; f<functions; ++f) {
+      ss << "\n  void checks_" << f << "(int i, double d, const std::string& s, const std::vector<int>& v)\n  {\n";
+      for(unsigned k=f*100; (k<n) && (k<(f+1)*100); ++k) {
+        switch(k % 8) {
+          case 0: ss << "    test_expect_eq(i + " << k << ", " << k << ");\n"; break;
+          case 1: ss << "    test_expect_lt(d, " << k << ".5);\n"; break;
+          case 2: ss << "    test_expect_ne(s, \"x" << k << "\");\n"; break;
+          case 3: ss << "    test_expect(v.size() < " << k << "u + 4u);\n"; break;
+          case 4: ss << "    test_expect_le(v.size(), std::size_t(" << k << "u + 3u));\n"; break;
+          case 5: ss << "    test_expect_eq(s, std::string(\"s\"));\n"; break;
+          case 6: ss << "    test_expect_ne(d, " << k << ".25);\n"; break;
+          default: ss << "    test_expect_gt(long(" << k << ") + 1, long(i));\n"; break;
+        }
+      }
+      ss << "  }\n";
+    }
+    ss << "\n}\n\n"
+       << "void test(const std::vector<std::string>& args)\n{\n"
+       << "  const int i = int(args.size());\n"
+       << "  const auto s = std::string(\"s\");\n"
+       << "  const auto v = std::vector<int>{1,2,3};\n";
+    for(unsigned f=0; f<functions; ++f) ss << "  checks_" << f << "(i, 0.5, s, v);\n";
+    ss << "}\n";
+    return ss.str();
+  }
+
+  #ifdef BENCH_COMPILE_POSIX
+
+  /**
+   * Runs the command, output to `log`, returns the exit status, the wall time,
+   * and the peak memory of the process and its (waited) child processes.
+   */
+  int run(const std::vector<std::string>& cmd, const std::string& log, double& wall_s, long& peak_kb)
+  {
+    auto argv = std::vector<char*>();
+    for(const auto& arg: cmd) argv.push_back(const_cast<char*>(arg.c_str()));
+    argv.push_back(nullptr);
+    const auto start = std::chrono::steady_clock::now();
+    const pid_t pid = ::fork();
+    if(pid < 0) return -1;
+    if(pid == 0) {
+      const int fd = ::open(log.c_str(), O_WRONLY|O_CREAT|O_TRUNC, 0644);
+      if(fd >= 0) { ::dup2(fd, 1); ::dup2(fd, 2); ::close(fd); }
+      ::execvp(argv[0], argv.data());
+      ::_exit(127);
+    }
+    int status = 0;
+    struct rusage ru;
+    std::memset(&ru, 0, sizeof(ru));
+    while(::wait4(pid, &status, 0, &ru) < 0) {
+      if(errno != EINTR) return -1;
+    }
+    wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    peak_kb = long(ru.ru_maxrss);
+    #ifdef __APPLE__
+    peak_kb /= 1024;
+    #endif
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+  }
+
+  /**
+   * Number of defined weak symbols (`nm` types `W`, `V`), -1 when `nm` fails.
+   */
+  long weak_symbols(const std::string& object)
+  {
+    FILE* const fp = ::popen(("nm --defined-only '" + object + "' 2>/dev/null").c_str(), "r");
+    if(!fp) return -1;
+    long n = 0;
+    bool any = false;
+    char line[4096];
+    while(std::fgets(line, sizeof(line), fp)) {
+      any = true;
+      if(std::strstr(line, " W ") || std::strstr(line, " V ")) ++n;
+    }
+    return ((::pclose(fp) == 0) && any) ? n : -1;
+  }
+
+  long file_size(const std::string& path)
+  {
+    struct stat st;
+    return (::stat(path.c_str(), &st) == 0) ? long(st.st_size) : -1;
+  }
+
+  #endif
+
+}
+
+int main(int argc, char* argv[])
+{
+  auto checks = 0u;
+  auto runs = 1u;
+  auto dir = std::string();
+  auto label = std::string("-");
+  auto cmd = std::vector<std::string>();
+  for(int i=1; i<argc; ++i) {
+    const char* const arg = argv[i];
+    if(std::strcmp(arg, "--header") == 0) {
+      std::printf("%-40s %8s %9s %9s %11s %12s\n", "# configuration", "checks", "wall[s]", "peak[MB]", "object[kB]", "weak-symbols");
+      return 0;
+    } else if(std::strncmp(arg, "--checks=", 9) == 0) {
+      checks = unsigned(std::strtoul(arg+9, nullptr, 10));
+    } else if(std::strncmp(arg, "--runs=", 7) == 0) {
+      runs = unsigned(std::strtoul(arg+7, nullptr, 10));
+      if(runs < 1) return usage();
+    } else if(std::strncmp(arg, "--dir=", 6) == 0) {
+      dir = arg+6;
+    } else if(std::strncmp(arg, "--label=", 8) == 0) {
+      label = arg+8;
+    } else if(std::strcmp(arg, "--") == 0) {
+      for(++i; i<argc; ++i) cmd.push_back(argv[i]);
+    } else {
+      return usage();
+    }
+  }
+  if(dir.empty() || cmd.empty()) return usage();
+  #ifndef BENCH_COMPILE_POSIX
+  std::cerr << "bench-compile: Not supported on this platform.\n";
+  return 2;
+  #else
+  auto name = std::string();
+  for(const char c: label) name += ((c == ' ') || (c == '/') || (c == '+') || (c == '=')) ? '_' : c;
+  const auto base = dir + "/" + name + "-" + std::to_string(checks);
+  {
+    std::ofstream os(base + ".cc");
+    os << synthetic_test(checks);
+    if(!os) { std::cerr << "bench-compile: Failed to write '" << base << ".cc'\n"; return 2; }
+  }
+  cmd.push_back("-c");
+  cmd.push_back(base + ".cc");
+  cmd.push_back("-o");
+  cmd.push_back(base + ".o");
+  double wall_s = 0;
+  long peak_kb = 0;
+  for(unsigned i=0; i<runs; ++i) {
+    double run_wall_s = 0;
+    long run_peak_kb = 0;
+    if(run(cmd, base + ".log", run_wall_s, run_peak_kb) != 0) {
+      std::cerr << "[fail] bench-compile: " << label << " (" << checks << " checks), see '" << base << ".log'\n";
+      return 1;
+    }
+    if((i == 0) || (run_wall_s < wall_s)) wall_s = run_wall_s;
+    if(run_peak_kb > peak_kb) peak_kb = run_peak_kb;
+  }
+  std::printf("%-40s %8u %9.2f %9.1f %11.1f %12ld\n", label.c_str(), checks, wall_s, double(peak_kb)/1024.0,
+    double(file_size(base + ".o"))/1024.0, weak_symbols(base + ".o"));
+  return 0;
+  #endif
+}
@@ -0,0 +1,211 @@
+/**
+ * @file bench-harness.cc
+ * @tool bench-harness
+ *
+ * Runtime benchmark of the harness itself (`make bench-harness`): Measures the
+ * checks per second of `test_expect`, `test_expect_silent`, `test_expect_eq`
+ * (int, string, double operands), and `test_note`, with pass logging on/off,
+ * ANSI colors on/off, output to a `std::ostream` (`test::stream()`) or to a
+ * file descriptor (`test::stream_fd()`, `/dev/null`), and with 1 to N threads
+ * checking concurrently (powers of two and N). With several runs, the minimum
+ * time is reported.
+ *
+ *  Usage: bench-harness [--checks=<n per thread>] [--max-threads=<n>] [--runs=<n>]
+ *
+ *  Output: A `#` header line with the format version and the build, a `#`
+ *  column line, and one row per measurement, whitespace separated, always in
+ *  the same order:
+ *
+ *    <check> <pass-log on|off> <ansi on|off> <sink stream|fd> <threads>
+ *    <checks> <seconds> <checks/s> <ns/check>
+ *
+ *  Exit code: 0 when all measurements completed, 1 when the harness counted
+ *  unexpected results, 2 on invalid arguments.
+ */
+#include <microtest.hh>
+#include <iostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <cerrno>
+#include <climits>
+#if defined(__unix__) || defined(__unix) || defined(__APPLE__)
+  #include <fcntl.h>
+  #include <unistd.h>
+  #define BENCH_HARNESS_FD_SINK
+#endif
+
+namespace {
+
+  using test = ::sw::utest::test;
+
+  int usage()
+  {
+    std::cerr << "Usage: bench-harness [--checks=<n per thread>] [--max-threads=<n>] [--runs=<n>]\n";
+    return 2;
+  }
+
+  /**
+   * Strict positive decimal count argument (no sign, no trailing characters).
+   */
+  bool parse_count(const char* s, unsigned& value)
+  {
+    if(!s || (*s < '0') || (*s > '9')) return false;
+    char* end = nullptr;
+    errno = 0;
+    const unsigned long n = std::strtoul(s, &end, 10);
+    if((errno != 0) || (!end) || (*end != '\0') || (n < 1) || (n > UINT_MAX)) return false;
+    value = unsigned(n);
+    return true;
+  }
+
+  /**
+   * Discarding stream buffer of the `stream` sink.
+   */
+  class null_streambuf: public std::streambuf
+  {
+  protected:
+    int_type overflow(int_type c) override
+    { return traits_type::not_eof(c); }
+
+    std::streamsize xsputn(const char*, std::streamsize n) override
+    { return n; }
+  };
+
+  enum check_type { check_expect=0, check_expect_silent, check_eq_int, check_eq_string, check_eq_double, check_note };
+
+  const char* const check_names[] = { "expect", "expect_silent", "eq_int", "eq_string", "eq_double", "note" };
+
+  /**
+   * Checks of one thread, all passing.
+   */
+  void checks(check_type type, unsigned n)
+  {
+    const auto s1 = std::string("bench-harness string operand");
+    const auto s2 = std::string("bench-harness string operand");
+    switch(type) {
+      case check_expect:
+        for(unsigned i=0; i<n; ++i) test_expect(i < n);
+        break;
+      case check_expect_silent:
+        for(unsigned i=0; i<n; ++i) test_expect_silent(i < n);
+        break;
+      case check_eq_int:
+        for(unsigned i=0; i<n; ++i) test_expect_eq(int(i), int(i));
+        break;
+      case check_eq_string:
+        for(unsigned i=0; i<n; ++i) test_expect_eq(s1, s2);
+        break;
+      case check_eq_double:
+        for(unsigned i=0; i<n; ++i) test_expect_eq(double(i) * 0.5, double(i) / 2.0);
+        break;
+      case check_note:
+        for(unsigned i=0; i<n; ++i) test_note("note " << i);
+        break;
+    }
+  }
+
+  /**
+   * Runs the checks in `threads` threads, returns the wall time in seconds,
+   * or a negative value when the counters do not match.
+   */
+  double measure(check_type type, unsigned threads, unsigned n)
+  {
+    test::reset();
+    const auto start = std::chrono::steady_clock::now();
+    if(threads <= 1) {
+      checks(type, n);
+    } else {
+      auto workers = std::vector<std::thread>();
+      for(unsigned t=0; t<threads; ++t) workers.emplace_back(checks, type, n);
+      for(auto& worker: workers) worker.join();
+    }
+    test::flush();
+    const double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const std::uint64_t expected = (type == check_note) ? 0u : std::uint64_t(threads) * n;
+    return ((test::num_checks() == expected) && (test::num_fails() == 0)) ? s : -1.0;
+  }
+
+}
+
+int main(int argc, char* argv[])
+{
+  auto n = 100000u;
+  auto max_threads = std::thread::hardware_concurrency();
+  auto runs = 1u;
+  for(int i=1; i<argc; ++i) {
+    const char* const arg = argv[i];
+    if(std::strncmp(arg, "--checks=", 9) == 0) {
+      if(!parse_count(arg+9, n)) return usage();
+    } else if(std::strncmp(arg, "--max-threads=", 14) == 0) {
+      if(!parse_count(arg+14, max_threads)) return usage();
+    } else if(std::strncmp(arg, "--runs=", 7) == 0) {
+      if(!parse_count(arg+7, runs)) return usage();
+    } else {
+      return usage();
+    }
+  }
+  if(max_threads < 1) max_threads = 1;
+  auto thread_counts = std::vector<unsigned>();
+  for(unsigned t=1; t<max_threads; t*=2) thread_counts.push_back(t);
+  thread_counts.push_back(max_threads);
+
+  const char* const sinks[] = { "stream", "fd" };
+  #ifdef BENCH_HARNESS_FD_SINK
+  const int null_fd = ::open("/dev/null", O_WRONLY);
+  const unsigned num_sinks = (null_fd >= 0) ? 2u : 1u;
+  #else
+  const unsigned num_sinks = 1u;
+  #endif
+  null_streambuf nullbuf;
+  std::ostream nullos(&nullbuf);
+
+  std::printf("# bench-harness v1 %s %s\n", ::sw::utest::detail::buildinfo<>::compiler(), ::sw::utest::detail::buildinfo<>::compilation_standard());
+  std::printf("# %-14s %8s %4s %6s %7s %10s %10s %12s %9s\n", "check", "pass-log", "ansi", "sink", "threads", "checks", "seconds", "checks/s", "ns/check");
+  std::fflush(stdout);
+  int rc = 0;
+  for(unsigned type=check_expect; type<=check_note; ++type) {
+    for(unsigned pass_log=0; pass_log<2; ++pass_log) {
+      for(unsigned ansi=0; ansi<2; ++ansi) {
+        for(unsigned sink=0; sink<num_sinks; ++sink) {
+          for(const auto threads: thread_counts) {
+            if(sink == 0) {
+              test::stream(nullos);
+            } else {
+              #ifdef BENCH_HARNESS_FD_SINK
+              test::stream_fd(null_fd);
+              #endif
+            }
+            test::omit_pass_log(!pass_log);
+            test::ansi_colors(ansi != 0);
+            double s = 0;
+            for(unsigned run=0; run<runs; ++run) {
+              const double run_s = measure(check_type(type), threads, n);
+              if(run_s < 0) { s = -1; break; }
+              if((run == 0) || (run_s < s)) s = run_s;
+            }
+            const double total = double(threads) * n;
+            if(s < 0) {
+              std::fprintf(stderr, "[fail] bench-harness: unexpected check counts (%s, %u threads)\n", check_names[type], threads);
+              rc = 1;
+            }
+            std::printf("  %-14s %8s %4s %6s %7u %10.0f %10.6f %12.0f %9.1f\n", check_names[type], pass_log ? "on" : "off",
+              ansi ? "on" : "off", sinks[sink], threads, total, s, (s > 0) ? (total/s) : 0.0, (s > 0) ? (s*1e9/total) : 0.0);
+            std::fflush(stdout);
+          }
+        }
+      }
+    }
+  }
+  test::default_stream();
+  test::reset();
+  #ifdef BENCH_HARNESS_FD_SINK
+  if(null_fd >= 0) ::close(null_fd);
+  #endif
+  return rc;
+}
@@ -0,0 +1,81 @@
+/**
+ * @file binlog-decode.cc
+ * @tool binlog-decode
+ *
+ * Renders binary test logs (`--reporter=binary`, `make test REPORTER=binary`)
+ * as the text log records `[pass] [@file:line] ...`, optionally filtered by
+ * result, source file, and line.
+ *
+ *  Usage: binlog-decode [--results=pass,fail,warn,note,info,summary]
+ *                       [--file=<name part>] [--line=<line>] [<log file>|-]
+ *
+ *  Exit code: 0 when decoded, 1 on invalid or truncated input, 2 on
+ *  invalid arguments.
+ */
+#include <microtest.hh>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+
+namespace {
+
+  using binary_log = ::sw::utest::detail::binary_log<>;
+
+  int usage()
+  {
+    std::cerr << "Usage: binlog-decode [--results=pass,fail,warn,note,info,summary] [--file=<name part>] [--line=<line>] [<log file>|-]\n";
+    return 2;
+  }
+
+  bool parse_results(std::string list, unsigned& results)
+  {
+    static const char* const names[6] = { "pass", "fail", "warn", "note", "info", "summary" };
+    results = 0;
+    list += ",";
+    for(std::string::size_type p=0, e=list.find(','); e != std::string::npos; p=e+1, e=list.find(',', p)) {
+      const std::string name = list.substr(p, e-p);
+      unsigned i = 0;
+      while((i < 6) && (name != names[i])) ++i;
+      if(i >= 6) return false;
+      results |= 1u << i;
+    }
+    return true;
+  }
+
+}
+
+int main(int argc, char* argv[])
+{
+  auto sel = binary_log::filter();
+  auto path = std::string("-");
+  for(int i=1; i<argc; ++i) {
+    const char* const arg = argv[i];
+    if(std::strncmp(arg, "--results=", 10) == 0) {
+      if(!parse_results(arg+10, sel.results)) return usage();
+    } else if(std::strncmp(arg, "--file=", 7) == 0) {
+      sel.file = arg+7;
+    } else if(std::strncmp(arg, "--line=", 7) == 0) {
+      sel.line = std::atoi(arg+7);
+      if(sel.line <= 0) return usage();
+    } else if((arg[0] == '-') && (arg[1] != '\0')) {
+      return usage();
+    } else {
+      path = arg;
+    }
+  }
+  std::ifstream file;
+  if(path != "-") {
+    file.open(path, std::ios::in|std::ios::binary);
+    if(!file) { std::cerr << "binlog-decode: Failed to open '" << path << "'\n"; return 1; }
+  }
+  std::istream& is = (path != "-") ? static_cast<std::istream&>(file) : std::cin;
+  std::ios::sync_with_stdio(false);
+  if(!binary_log::decode(is, std::cout, sel)) {
+    std::cout.flush();
+    std::cerr << "binlog-decode: Invalid or truncated binary log '" << path << "'\n";
+    return 1;
+  }
+  return 0;
+}
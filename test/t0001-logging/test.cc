@@ -11,15 +11,6 @@
 
 using namespace std;
 
-// Guard to prevent stream overrides (which is normally not done)
-// falling out of scope.
-struct teststream_restore
-{
-  teststream_restore() noexcept = default;
-
-  ~teststream_restore() noexcept { ::sw::utest::test::stream(std::cout); }
-};
-
 void test(const vector<string>& args)
 {
   using namespace sw::utest;
@@ -44,6 +35,7 @@ void test(const vector<string>& args)
     test::fail("FILENAME", 3, "fail-message");
     const auto exit_code = test::summary();
     test::stream(cout);
+    test::reporter(restore.reporter);
     test::ansi_colors(was_ansi);
     const auto num_pass = test::num_passed();
     const auto num_fail = test::num_fails();
@@ -74,6 +66,7 @@ void test(const vector<string>& args)
     test::pass("FILE", 2, "pass-msg");
     test::fail("FILE", 3, "fail-msg");
     test::stream(cout);
+    test::reporter(restore.reporter);
     test::ansi_colors(was_ansi);
     test::reset();
 
@@ -122,6 +115,7 @@ void test(const vector<string>& args)
     test::ansi_colors(was_ansi);
     test::omit_pass_log(was_omit);
     test::stream(cout);
+    test::reporter(restore.reporter);
     test::reset();
 
     const auto s = stripped(os.str());
@@ -143,6 +137,7 @@ void test(const vector<string>& args)
     test::ansi_colors(was_ansi);
     test::omit_pass_log(was_omit);
     test::stream(cout);
+    test::reporter(restore.reporter);
     test::reset();
     const auto s = stripped(os.str());
     test_info("text_check_summary_allpass: ", s);
@@ -163,6 +158,7 @@ void test(const vector<string>& args)
     test::ansi_colors(was_ansi);
     test::omit_pass_log(was_omit);
     test::stream(cout);
+    test::reporter(restore.reporter);
     test::reset();
     const auto s = stripped(os.str());
     test_info("text_check_summary_pass_warnings: ", s);
@@ -179,6 +175,7 @@ void test(const vector<string>& args)
     test_summary();
     test::ansi_colors(was_ansi);
     test::stream(cout);
+    test::reporter(restore.reporter);
     test::reset();
     const auto s = stripped(os.str());
     test_info("text_check_summary_no_checks: ", s);
@@ -187,7 +184,26 @@ void test(const vector<string>& args)
     test::reset();
   };
 
+  const auto text_check_site_identity = [&]() -> void {
+    using sw::utest::detail::check_site;
+    using sw::utest::detail::check_kind;
+    const check_site* sites[3] = {nullptr, nullptr, nullptr};
+    for(int i = 0; i < 3; ++i) { sites[i] = &MICROTEST_UTEST_SITE(eq, "a", "b"); }
+    const check_site& other = MICROTEST_UTEST_SITE(expect, "c", nullptr); const int other_line = __LINE__;
+    test_expect((sites[0] == sites[1]) && (sites[1] == sites[2]));
+    test_expect(sites[0] != &other);
+    test_expect(string(other.file) == __FILE__);
+    test_expect_eq(other.line, other_line);
+    test_expect(other.kind == check_kind::expect);
+    test_expect(string(sites[0]->expr) == "a");
+    test_expect(string(sites[0]->expr_rhs) == "b");
+    test_expect(other.expr_rhs == nullptr);
+    if(test::num_fails() > 0) { testenv_fails += "text_check_site_identity failed. "; }
+    test::reset();
+  };
+
   // Run all.
+  text_check_site_identity();
   text_check_noansi();
   text_check_ansi();
   text_check_omit_combined();
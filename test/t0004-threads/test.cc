@@ -0,0 +1,67 @@
+/**
+ * @test threads
+ *
+ * Checks the check statistics when multiple threads register
+ * passes, fails, and warnings concurrently (per-thread counter
+ * shards, folding of terminated threads).
+ */
+#include <testenv.hh>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+void test(const vector<string>& args)
+{
+  using namespace sw::utest;
+  (void)args;
+  constexpr unsigned num_threads = 8;
+  constexpr unsigned num_iterations = 100000;
+
+  const auto was_omit = test::omit_pass_log();
+  test::omit_pass_log(true);
+  test::reset();
+  {
+    auto threads = vector<thread>();
+    for(unsigned t = 0; t < num_threads; ++t) {
+      threads.emplace_back([]() {
+        for(unsigned i = 0; i < num_iterations; ++i) { test_expect_silent(i < num_iterations); }
+        (void)test::fail();
+        (void)test::commit(false);
+      });
+    }
+    for(auto& t: threads) { t.join(); }
+  }
+  const auto num_checks = test::num_checks();
+  const auto num_fails = test::num_fails();
+  const auto num_passed = test::num_passed();
+  test::reset();
+  test::omit_pass_log(was_omit);
+
+  test_info("Checks registered by terminated threads: ", num_checks);
+  test_expect_eq(num_checks, std::uint64_t(num_threads) * (num_iterations + 2));
+  test_expect_eq(num_fails, std::uint64_t(num_threads) * 2);
+  test_expect_eq(num_passed, std::uint64_t(num_threads) * num_iterations);
+
+  // Counts of running threads are folded as well.
+  {
+    const auto checks_before = test::num_checks();
+    const auto warnings_before = test::num_warnings();
+    std::atomic<unsigned> ready(0);
+    std::atomic<bool> done(false);
+    auto th = thread([&]() {
+      test::pass();
+      test::warning("F", 1, "W");
+      ready = 1;
+      while(!done) { std::this_thread::yield(); }
+    });
+    while(!ready) { std::this_thread::yield(); }
+    const auto running_checks = test::num_checks() - checks_before;
+    const auto running_warnings = test::num_warnings() - warnings_before;
+    done = true;
+    th.join();
+    test_expect_eq(running_checks, 1u);
+    test_expect_eq(running_warnings, 1u);
+    test_expect_eq(test::num_checks() - checks_before, 3u);
+  }
+}
@@ -0,0 +1,121 @@
+/**
+ * @test async-log
+ *
+ * Checks the asynchronous logging backend: Records of multiple
+ * threads must all be written (in per-thread order) after a flush,
+ * including ring buffer wrap-arounds and oversized records, and the
+ * pending records are written by the signal handler on a crash.
+ */
+#define WITH_MICROTEST_ASYNC_LOG
+#include <testenv.hh>
+#include <cstdio>
+#include <thread>
+#include <vector>
+#include <set>
+#include <csignal>
+#ifndef __WINDOWS__
+  #include <unistd.h>
+  #include <sys/wait.h>
+#endif
+
+using namespace std;
+
+#ifndef __WINDOWS__
+// Child process: Logs records to STDOUT (redirected to `fd`) and
+// crashes before they are flushed.
+[[noreturn]] void crash_child(int fd, unsigned num_records)
+{
+  ::dup2(fd, STDOUT_FILENO);
+  ::sw::utest::test::ansi_colors(false);
+  ::sw::utest::test::default_stream();
+  ::sw::utest::test::async_log(true);
+  for(unsigned i = 0; i < num_records; ++i) { ::sw::utest::test::comment("", 0, "crash ", i); }
+  std::raise(SIGSEGV);
+  ::_exit(4);
+}
+#endif
+
+void test(const vector<string>& args)
+{
+  using namespace sw::utest;
+  (void)args;
+  constexpr unsigned num_threads = 4;
+  constexpr unsigned num_records = 20000;
+  test_expect(test::async_log());
+
+  auto lines = vector<string>();
+  {
+    const auto was_ansi = test::ansi_colors();
+    const auto restore = teststream_restore();
+    auto os = std::stringstream();
+    test::ansi_colors(false);
+    test::stream(os);
+    auto threads = vector<thread>();
+    for(unsigned t = 0; t < num_threads; ++t) {
+      threads.emplace_back([t]() {
+        for(unsigned i = 0; i < num_records; ++i) { test::comment("", 0, t, " ", i); }
+      });
+    }
+    for(auto& th: threads) { th.join(); }
+    test::comment("F", 1, string(size_t(1) << 15, 'x'));  // oversized, synchronous fallback
+    test::flush();
+    test::stream(cout);
+    test::reporter(restore.reporter);
+    test::ansi_colors(was_ansi);
+    auto line = string();
+    while(std::getline(os, line)) { lines.push_back(line); }
+  }
+
+  test_expect_eq(lines.size(), size_t(num_threads * num_records + 1));
+  test_expect_eq(lines.back().size(), size_t(14 + (size_t(1) << 15)));
+
+  // Per-thread order is preserved.
+  {
+    auto next = vector<unsigned>(num_threads, 0);
+    auto in_order = true;
+    for(size_t i = 0; i + 1 < lines.size(); ++i) {
+      unsigned t = 0, n = 0;
+      if(sscanf(lines[i].c_str(), "[note] %u %u", &t, &n) != 2 || t >= num_threads || next[t] != n) {
+        in_order = false;
+        test_info("Unexpected line: ", lines[i]);
+        break;
+      }
+      ++next[t];
+    }
+    test_expect(in_order);
+  }
+
+  #ifndef __WINDOWS__
+  // Pending records are written on a crash.
+  {
+    constexpr unsigned num_crash_records = 1000;
+    FILE* fp = std::tmpfile();
+    test_expect(fp != nullptr);
+    if(fp) {
+      std::fflush(nullptr);
+      test::async_log(false); // no writer thread across fork()
+      const pid_t pid = ::fork();
+      if(pid == 0) crash_child(fileno(fp), num_crash_records);
+      test::async_log(true);
+      int status = 0;
+      test_expect(::waitpid(pid, &status, 0) == pid);
+      test_expect(WIFSIGNALED(status) && (WTERMSIG(status) == SIGSEGV));
+      std::fseek(fp, 0, SEEK_SET);
+      auto seen = set<unsigned>();
+      char buf[256];
+      while(std::fgets(buf, sizeof(buf), fp)) {
+        unsigned n = 0;
+        if(sscanf(buf, "[note] crash %u", &n) == 1) seen.insert(n);
+      }
+      std::fclose(fp);
+      test_expect_eq(seen.size(), size_t(num_crash_records));
+    }
+  }
+  #endif
+
+  // Switching back to synchronous mode.
+  test::async_log(false);
+  test_expect(!test::async_log());
+  test::async_log(true);
+  test_expect(test::async_log());
+}
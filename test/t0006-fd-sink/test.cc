@@ -0,0 +1,227 @@
+/**
+ * @test fd-sink
+ *
+ * Checks the buffered raw file descriptor output and its flush
+ * policies, using a temporary file as output, and the per-record
+ * flushing of the default output stream.
+ */
+#include <testenv.hh>
+#include <cstdio>
+#include <thread>
+#include <csignal>
+#ifndef __WINDOWS__
+  #include <signal.h>
+  #include <unistd.h>
+  #include <sys/wait.h>
+#endif
+
+using namespace std;
+
+#ifdef __WINDOWS__
+  #define fileno _fileno
+#endif
+
+// Output stream buffer counting the flushes (`sync()`).
+struct sync_counting_buf: public std::stringbuf
+{
+  int syncs = 0;
+  int sync() override { ++syncs; return std::stringbuf::sync(); }
+};
+
+#ifndef __WINDOWS__
+// Child process: A fatal signal flushes the fd buffer and is passed on to
+// the handler installed before. Exits with 3 from that handler.
+[[noreturn]] void crash_child(int fd)
+{
+  struct ::sigaction sa;
+  std::memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = [](int) { ::_exit(3); };
+  ::sigemptyset(&sa.sa_mask);
+  ::sigaction(SIGTERM, &sa, nullptr);
+  ::sw::utest::test::stream_fd(fd, ::sw::utest::test::flush_on_crash);
+  ::sw::utest::test::comment("F", 9, "before signal");
+  std::raise(SIGTERM);
+  ::_exit(4);
+}
+
+// Child process: Records of the default output stream are flushed
+// individually, so that they are not lost on a crash.
+[[noreturn]] void default_stream_child(int fd)
+{
+  ::dup2(fd, STDOUT_FILENO);
+  ::sw::utest::test::default_stream();
+  ::sw::utest::test::comment("F", 14, "before crash");
+  ::sw::utest::test::pass("F", 15, "P");
+  std::raise(SIGSEGV);
+  ::_exit(4);
+}
+
+// Child process: An ignored signal stays ignored (no crash flush), a
+// later fatal signal still flushes. Terminates with SIGABRT.
+[[noreturn]] void ignored_signal_child(int fd)
+{
+  std::signal(SIGTERM, SIG_IGN);
+  ::sw::utest::test::stream_fd(fd, ::sw::utest::test::flush_on_crash);
+  ::sw::utest::test::comment("F", 12, "before ignored signal");
+  std::raise(SIGTERM);
+  ::sw::utest::test::comment("F", 13, "after ignored signal");
+  std::raise(SIGABRT);
+  ::_exit(4);
+}
+#endif
+
+// Returns the current contents of the temporary file.
+string contents(FILE* fp)
+{
+  auto s = string();
+  std::fseek(fp, 0, SEEK_SET);
+  char buf[256];
+  for(size_t n = 0; (n = std::fread(buf, 1, sizeof(buf), fp)) > 0;) { s.append(buf, n); }
+  std::fseek(fp, 0, SEEK_END);
+  return s;
+}
+
+void test(const vector<string>& args)
+{
+  using namespace sw::utest;
+  (void)args;
+  const auto was_ansi = test::ansi_colors();
+  const auto was_omit = test::omit_pass_log();
+  test::ansi_colors(false);
+  test::omit_pass_log(false);
+
+  FILE* fp = std::tmpfile();
+  if(!fp) {
+    test_fail("Failed to create temporary file");
+    return;
+  }
+
+  auto buffered = string();
+  auto after_fail = string();
+  auto after_flush = string();
+  auto after_summary = string();
+  auto expected = string();
+  {
+    const auto restore = teststream_restore();
+    test::stream_fd(fileno(fp), test::flush_on_fail | test::flush_on_summary);
+    test::pass("F", 1, "P");
+    test::comment("F", 2, "line1\nline2");
+    buffered = contents(fp);
+    test::fail("F", 3, "F");
+    after_fail = contents(fp);
+    test::warning("F", 4, "W");
+    test::flush();
+    after_flush = contents(fp);
+    test::pass("F", 5, "P");
+    (void)test::summary();
+    after_summary = contents(fp);
+    test::reset();
+  }
+  expected = "[pass] [@F:1] P\n[note] [@F:2] line1\n          line2\n[fail] [@F:3] F\n";
+  test_expect(buffered.empty());
+  test_expect_eq(after_fail, expected);
+  expected += "[warn] [@F:4] W\n";
+  test_expect_eq(after_flush, expected);
+  expected += "[pass] [@F:5] P\n[FAIL] 1 of 3 checks failed, 1 warnings.\n";
+  test_expect_eq(after_summary, expected);
+
+  // Interval policy: Flushed with the first record after the interval.
+  {
+    const auto restore = teststream_restore();
+    const auto size_before = contents(fp).size();
+    test::stream_fd(fileno(fp), test::flush_on_interval, 10);
+    test::comment("F", 6, "N");
+    buffered = contents(fp);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    test::comment("F", 7, "N");
+    after_flush = contents(fp);
+    test_expect_eq(buffered.size(), size_before);
+    test_expect_eq(after_flush.size(), size_before + 2 * string("[note] [@F:6] N\n").size());
+  }
+
+  // Batched output larger than the buffer.
+  {
+    const auto restore = teststream_restore();
+    const auto size_before = contents(fp).size();
+    const auto line = string(1000, 'x');
+    test::stream_fd(fileno(fp), 0);
+    for(int i = 0; i < 1000; ++i) { test::comment("", 0, line); }
+    test::stream(cout);
+    test::reporter(restore.reporter);
+    test_expect_eq(contents(fp).size(), size_before + 1000 * (line.size() + 8));
+  }
+
+  // Output streams are flushed according to the policy, not per record.
+  {
+    sync_counting_buf buf;
+    auto syncs_before_flush = 0;
+    {
+      const auto restore = teststream_restore();
+      std::ostream os(&buf);
+      test::stream(os, test::flush_on_summary);
+      test::comment("F", 10, "N");
+      test::comment("F", 11, "N");
+      syncs_before_flush = buf.syncs;
+      test::flush();
+    }
+    test_expect_eq(syncs_before_flush, 0);
+    test_expect_eq(buf.syncs, 2); // flush(), and when switching back to the default stream.
+    test_expect_eq(buf.str(), "[note] [@F:10] N\n[note] [@F:11] N\n");
+  }
+
+  // Output streams are flushed per record by default.
+  {
+    sync_counting_buf buf;
+    auto syncs = 0;
+    {
+      const auto restore = teststream_restore();
+      std::ostream os(&buf);
+      test::stream(os);
+      test::comment("F", 10, "N");
+      test::comment("F", 11, "N");
+      syncs = buf.syncs;
+    }
+    test_expect_eq(syncs, 2);
+  }
+
+  #ifndef __WINDOWS__
+  // Crash flush in the signal handler, and chaining to the previous handler.
+  {
+    std::fflush(nullptr);
+    const auto size_before = contents(fp).size();
+    const pid_t pid = ::fork();
+    if(pid == 0) crash_child(fileno(fp));
+    int status = 0;
+    test_expect(::waitpid(pid, &status, 0) == pid);
+    test_expect(WIFEXITED(status) && (WEXITSTATUS(status) == 3));
+    test_expect_eq(contents(fp).substr(size_before), "[note] [@F:9] before signal\n");
+  }
+  // Default output stream records written before a crash.
+  {
+    std::fflush(nullptr);
+    const auto size_before = contents(fp).size();
+    const pid_t pid = ::fork();
+    if(pid == 0) default_stream_child(fileno(fp));
+    int status = 0;
+    test_expect(::waitpid(pid, &status, 0) == pid);
+    test_expect(WIFSIGNALED(status) && (WTERMSIG(status) == SIGSEGV));
+    test_expect_eq(contents(fp).substr(size_before), "[note] [@F:14] before crash\n[pass] [@F:15] P\n");
+  }
+
+  // Ignored signals are not hooked.
+  {
+    std::fflush(nullptr);
+    const auto size_before = contents(fp).size();
+    const pid_t pid = ::fork();
+    if(pid == 0) ignored_signal_child(fileno(fp));
+    int status = 0;
+    test_expect(::waitpid(pid, &status, 0) == pid);
+    test_expect(WIFSIGNALED(status) && (WTERMSIG(status) == SIGABRT));
+    test_expect_eq(contents(fp).substr(size_before), "[note] [@F:12] before ignored signal\n[note] [@F:13] after ignored signal\n");
+  }
+  #endif
+
+  std::fclose(fp);
+  test::ansi_colors(was_ansi);
+  test::omit_pass_log(was_omit);
+}
@@ -0,0 +1,185 @@
+/**
+ * @test format-alloc
+ *
+ * Checks that logged checks and notes are formatted without heap
+ * allocations, and that the formatted text matches the (previous)
+ * `std::stringstream` based formatting. The global `operator new`
+ * is replaced here to count allocations of the current thread.
+ */
+#include <testenv.hh>
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+
+#if defined(__GNUC__) && !defined(__clang__) && (__GNUC__ >= 11)
+  // The malloc/free pairing below is correct, g++ only cannot see it through inlining.
+  #pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+namespace {
+  thread_local unsigned long long num_allocations = 0;
+}
+
+void* operator new(std::size_t size)
+{
+  ++num_allocations;
+  if(void* p = std::malloc(size ? size : 1)) { return p; }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+// Output stream discarding all data.
+struct null_streambuf : public std::streambuf
+{
+  int_type overflow(int_type c) override { return c; }
+
+  std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+// Reference: Record formatting as done before (std::string file,
+// stringstream message, copied record).
+template<typename... Args>
+string legacy_record(const string& file, int line, Args&&... args)
+{
+  stringstream ss;
+  const int unpack[] = {0, ((ss << args), 0)...};
+  (void)unpack;
+  const auto msg = ss.str();
+  auto rec = string("[pass] ");
+  rec += "[@" + file + ":" + to_string(line) + "] ";
+  for(const auto c: msg) {
+    if(c == '\n') {
+      rec += "\n          ";
+    } else {
+      rec += c;
+    }
+  }
+  return rec + "\n";
+}
+
+// Value type counting how often it is formatted.
+struct format_counted
+{
+  static unsigned num_formatted;
+  int value;
+  bool operator==(const format_counted& o) const noexcept { return value == o.value; }
+};
+
+unsigned format_counted::num_formatted = 0;
+
+std::ostream& operator<<(std::ostream& os, const format_counted& v)
+{ ++format_counted::num_formatted; return os << v.value; }
+
+// Allocations per call of `fn`, averaged over `n` calls.
+template<typename Fn>
+double allocations_per_call(unsigned n, Fn fn)
+{
+  fn();  // warm-up (thread-local buffers)
+  const auto n0 = num_allocations;
+  for(unsigned i = 0; i < n; ++i) { fn(); }
+  return double(num_allocations - n0) / n;
+}
+
+void test(const vector<string>& args)
+{
+  using namespace sw::utest;
+  (void)args;
+  constexpr unsigned n = 1000;
+  const auto str_a = string("a string value exceeding the small string optimization");
+  const auto str_b = string("a string value exceeding the small string optimization");
+  const auto dbl = 3.14159265;
+  const auto i = 42;
+
+  // Allocations per logged check
+  {
+    const auto was_omit = test::omit_pass_log();
+    const auto restore = teststream_restore();
+    null_streambuf nullbuf;
+    std::ostream nullos(&nullbuf);
+    test::omit_pass_log(false);
+    test::stream(nullos);
+    const auto n_before_int = allocations_per_call(n, [&]() { legacy_record(__FILE__, __LINE__, "i", " == ", "42", "   (=", i, ")"); });
+    const auto n_before_str = allocations_per_call(n, [&]() { legacy_record(__FILE__, __LINE__, "str_a", " == ", "str_b", "   (=", str_a, ")"); });
+    const auto n_eq_int = allocations_per_call(n, [&]() { test_expect_eq(i, 42); });
+    const auto n_eq_dbl = allocations_per_call(n, [&]() { test_expect_eq(dbl, 3.14159265); });
+    const auto n_eq_str = allocations_per_call(n, [&]() { test_expect_eq(str_a, str_b); });
+    const auto n_expect = allocations_per_call(n, [&]() { test_expect(i == 42); });
+    const auto n_note = allocations_per_call(n, [&]() { test_note("note " << i << " " << dbl << " " << str_a); });
+    const auto n_info = allocations_per_call(n, [&]() { test_info("info ", i, " ", dbl, " ", str_a, "\nline2"); });
+    const auto n_except = allocations_per_call(n, [&]() { test_expect_except(throw 1); });
+    test::stream(cout);
+    test::reporter(restore.reporter);
+    test::omit_pass_log(was_omit);
+    test::reset();
+
+    test_info("Allocations per logged check (stringstream reference): int=", n_before_int, ", string=", n_before_str);
+    test_info("Allocations per test_expect_eq(int): ", n_eq_int);
+    test_info("Allocations per test_expect_eq(double): ", n_eq_dbl);
+    test_info("Allocations per test_expect_eq(string): ", n_eq_str);
+    test_info("Allocations per test_expect(): ", n_expect);
+    test_info("Allocations per test_note(): ", n_note);
+    test_info("Allocations per test_info(): ", n_info);
+    test_info("Allocations per test_expect_except(): ", n_except);
+    test_expect(n_before_int > 0);
+    test_expect_eq(n_eq_int, 0);
+    test_expect_eq(n_eq_dbl, 0);
+    test_expect_eq(n_eq_str, 0);
+    test_expect_eq(n_expect, 0);
+    test_expect_eq(n_note, 0);
+    test_expect_eq(n_info, 0);
+    test_expect_le(n_except, 1);  // (the exception object itself may be allocated)
+  }
+
+  // Omitted pass logs: passing checks are not formatted at all.
+  {
+    const auto was_omit = test::omit_pass_log();
+    const auto a = format_counted{1};
+    const auto b = format_counted{1};
+    test::omit_pass_log(true);
+    const auto n_checks = test::num_checks();
+    const auto n_eq_omit = allocations_per_call(n, [&]() { test_expect_eq(a, b); });
+    const auto n_str_omit = allocations_per_call(n, [&]() { test_expect_eq(str_a, str_b); });
+    const auto n_dif_omit = allocations_per_call(n, [&]() { test_expect_diff_in_tolerance(dbl-3.1415, 1e-3); });
+    const auto num_formatted = format_counted::num_formatted;
+    test::omit_pass_log(was_omit);
+    test_info("Allocations per passed check with omitted pass log: ", n_eq_omit, ", ", n_str_omit, ", ", n_dif_omit);
+    test_expect_eq(test::num_checks() - n_checks, 3 * (n + 1));
+    test_expect_eq(num_formatted, 0u);
+    test_expect_eq(n_eq_omit, 0);
+    test_expect_eq(n_str_omit, 0);
+    test_expect_eq(n_dif_omit, 0);
+  }
+
+  // Formatted text equals the stringstream based formatting.
+  {
+    const auto was_ansi = test::ansi_colors();
+    const auto was_omit = test::omit_pass_log();
+    const auto restore = teststream_restore();
+    auto os = std::stringstream();
+    auto expected = string();
+    const auto big = string(5000, 'x') + "\n" + string(5000, 'y');
+    test::ansi_colors(false);
+    test::omit_pass_log(false);
+    test::stream(os);
+    test::pass("F", 1, 'c', true, -1, 2u, -3l, 4ull, 1.5f, -2.25, 1e300, 1.0L / 3, "text", str_a);
+    expected += legacy_record("F", 1, 'c', true, -1, 2u, -3l, 4ull, 1.5f, -2.25, 1e300, 1.0L / 3, "text", str_a);
+    test::pass("F", 2, "line1\nline2\n", "line3");
+    expected += legacy_record("F", 2, "line1\nline2\n", "line3");
+    test::pass("F", 3, big);
+    expected += legacy_record("F", 3, big);
+    test::pass("F", 4, static_cast<const void*>(nullptr), " ", std::hex, 255, " ", 255);
+    expected += legacy_record("F", 4, static_cast<const void*>(nullptr), " ", std::hex, 255, " ", 255);
+    test::pass("F", 5, 255, " ", 0.1);  // stream state (hex) reset
+    expected += legacy_record("F", 5, 255, " ", 0.1);
+    test::stream(cout);
+    test::reporter(restore.reporter);
+    test::ansi_colors(was_ansi);
+    test::omit_pass_log(was_omit);
+    test_expect(os.str() == expected);
+    if(os.str() != expected) { test_info("Got:\n", os.str(), "\nExpected:\n", expected); }
+  }
+}
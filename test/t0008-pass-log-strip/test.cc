@@ -0,0 +1,79 @@
+/**
+ * @test pass-log-strip
+ *
+ * With `WITHOUT_MICROTEST_PASS_LOG_CODE` passes are only counted, the
+ * pass logging can not be switched on, and fails are logged as usual.
+ */
+#define WITHOUT_MICROTEST_PASS_LOG_CODE
+#include <testenv.hh>
+
+using namespace std;
+
+// Value type counting how often it is formatted.
+struct format_counted
+{
+  static unsigned num_formatted;
+  int value;
+  bool operator==(const format_counted& o) const noexcept { return value == o.value; }
+};
+
+unsigned format_counted::num_formatted = 0;
+
+std::ostream& operator<<(std::ostream& os, const format_counted& v)
+{ ++format_counted::num_formatted; return os << v.value; }
+
+void test(const vector<string>& args)
+{
+  using namespace sw::utest;
+  (void)args;
+
+  test_expect(test::omit_pass_log());
+  test::omit_pass_log(false);
+  test_expect(test::omit_pass_log());
+
+  {
+    auto os = std::stringstream();
+    const auto a = format_counted{1};
+    const auto b = format_counted{2};
+    test::reset();
+    const auto was_reporter = test::reporter();  // text records checked
+    test::reporter(test::report_text);
+    test::stream(os);
+    test_expect_eq(a, a);
+    test_expect(a == a);
+    test_expect_noexcept(a == a);
+    test_expect_except(throw 1);
+    test_pass("passed");
+    test_expect_cond(!(a == b));
+    test_expect_eq(a, b);
+    test_info("info");
+    test::stream(cout);
+    test::reporter(was_reporter);
+    const auto num_checks = test::num_checks();
+    const auto num_fails = test::num_fails();
+    test::reset();
+    const auto log = os.str();
+    test_info("Log:\n", log);
+    test_expect_eq(format_counted::num_formatted, 2u);  // only the fail record
+    test_expect(log.find("[pass]") == log.npos);
+    test_expect(log.find("[fail]") != log.npos);
+    test_expect(log.find("[note]") != log.npos);
+    test_expect_eq(num_checks, 7u);
+    test_expect_eq(num_fails, 1u);
+  }
+
+  {
+    auto os = std::stringstream();
+    const auto num_checks = test::num_checks();
+    const auto was_reporter = test::reporter();  // text records checked
+    test::reporter(test::report_text);
+    test::stream(os);
+    for(int i = 0; i < 1000; ++i) { test_expect_eq(i, i); }
+    test::stream(cout);
+    test::reporter(was_reporter);
+    const auto num_new_checks = test::num_checks() - num_checks;
+    test_expect(os.str().empty());
+    test_expect_eq(num_new_checks, 1000u);
+    test_expect_eq(test::num_fails(), 0u);
+  }
+}
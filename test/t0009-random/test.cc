@@ -0,0 +1,184 @@
+/**
+ * @test random
+ *
+ * Checks the seeding of the `test_random` engine: Reproducible
+ * sequences for a given seed, the seed in the build information,
+ * independent per-thread streams, and the value ranges. Checks the
+ * bulk generation with `test_random_fill` for different containers.
+ */
+#include <testenv.hh>
+#include <algorithm>
+#include <numeric>
+#include <thread>
+#include <chrono>
+#include <array>
+#include <deque>
+#include <list>
+
+using namespace std;
+
+void test(const vector<string>& args)
+{
+  using namespace sw::utest;
+  (void)args;
+  const auto initial_seed = test::random_seed();
+  test_info("Initial seed: ", initial_seed);
+
+  // Seed text parsing (`MICROTEST_SEED`, `--seed=`)
+  {
+    auto seed = std::uint64_t(0);
+    test_expect(detail::random_seed<>::parse("12345", seed) && (seed == 12345u));
+    test_expect(detail::random_seed<>::parse("0x10", seed) && (seed == 16u));
+    test_expect(detail::random_seed<>::parse("18446744073709551615", seed) && (seed == ~std::uint64_t(0)));
+    test_expect(!detail::random_seed<>::parse("", seed));
+    test_expect(!detail::random_seed<>::parse(nullptr, seed));
+    test_expect(!detail::random_seed<>::parse("12a", seed));
+    test_expect(!detail::random_seed<>::parse("-1", seed));
+    test_expect(!detail::random_seed<>::parse("18446744073709551616", seed));
+  }
+
+  // Seed is printed in the build information.
+  {
+    auto os = std::stringstream();
+    test::stream(os);
+    test::buildinfo("F", 1);
+    test::stream(cout);
+    test_expect(os.str().find(", seed=" + std::to_string(initial_seed)) != string::npos);
+  }
+
+  // Same seed, same sequences.
+  {
+    test::random_seed(42);
+    test_expect_eq(test::random_seed(), 42u);
+    const auto a = test_random<vector<double>>(100, 0, 1);
+    const auto b = test_random<vector<int>>(100, -100, 100);
+    const auto c = test_random<string>(100);
+    test::random_seed(43);
+    const auto a2 = test_random<vector<double>>(100, 0, 1);
+    test::random_seed(42);
+    const auto a1 = test_random<vector<double>>(100, 0, 1);
+    const auto b1 = test_random<vector<int>>(100, -100, 100);
+    const auto c1 = test_random<string>(100);
+    test_expect(a == a1);
+    test_expect(b == b1);
+    test_expect(c == c1);
+    test_expect(a != a2);
+  }
+
+  // Threads use independent streams.
+  {
+    test::random_seed(42);
+    const auto main_values = test_random<vector<std::uint64_t>>(16);
+    auto thread_values = vector<std::uint64_t>();
+    std::thread([&]() { thread_values = test_random<vector<std::uint64_t>>(16); }).join();
+    test_expect(main_values != thread_values);
+  }
+
+  // Value ranges and coarse distribution.
+  {
+    const auto n = size_t(1000000);
+    const auto d = test_random<vector<double>>(n, -1, 1);
+    const auto i = test_random<vector<int>>(n, 0, 9);
+    test_expect(*std::min_element(d.begin(), d.end()) >= -1.0);
+    test_expect(*std::max_element(d.begin(), d.end()) <= 1.0);
+    test_expect(std::abs(std::accumulate(d.begin(), d.end(), 0.0) / double(n)) < 0.01);
+    test_expect_eq(*std::min_element(i.begin(), i.end()), 0);
+    test_expect_eq(*std::max_element(i.begin(), i.end()), 9);
+    auto histogram = vector<size_t>(10, 0);
+    for(const auto v: i) { ++histogram[size_t(v)]; }
+    test_expect(*std::min_element(histogram.begin(), histogram.end()) > (n/10 - n/100));
+    test_expect(*std::max_element(histogram.begin(), histogram.end()) < (n/10 + n/100));
+  }
+
+  // Bulk fill of iterator ranges and containers.
+  {
+    auto v = vector<double>(1001, 10.0);
+    auto d = deque<int>(1001, 1000);
+    auto l = list<short>(1001, 1000);
+    auto a = array<std::uint8_t, 1001>();
+    char c[1001] = {0};
+    test_random_fill(v.begin(), v.end(), -2, 2);
+    test_random_fill(d.begin(), d.end(), -5, 5);
+    test_random_fill(l.begin(), l.end(), 10, 12);
+    test_random_fill(a, 'a', 'c');
+    test_random_fill(&c[0], &c[1001], 'x', 'z');
+    test_expect(std::all_of(v.begin(), v.end(), [](double e){ return (e >= -2) && (e <= 2); }));
+    test_expect(std::all_of(d.begin(), d.end(), [](int e){ return (e >= -5) && (e <= 5); }));
+    test_expect(std::all_of(l.begin(), l.end(), [](short e){ return (e >= 10) && (e <= 12); }));
+    test_expect(std::all_of(a.begin(), a.end(), [](std::uint8_t e){ return (e >= 'a') && (e <= 'c'); }));
+    test_expect(std::all_of(&c[0], &c[1001], [](char e){ return (e >= 'x') && (e <= 'z'); }));
+    test_expect(std::count(l.begin(), l.end(), short(12)) > 0);
+    test_expect(std::count(d.begin(), d.end(), -5) > 0);
+    test_expect(std::count(d.begin(), d.end(), 5) > 0);
+  }
+
+  // Strings grown block-wise, lengths around the block size.
+  {
+    for(const auto n: {size_t(1), size_t(7), size_t(64), size_t(65), size_t(100001)}) {
+      const auto s = test_random<string>(n);
+      const auto r = test_random<string>(n, 'a', 'f');
+      const auto w = test_random<wstring>(n);
+      test_expect_eq(s.size(), n);
+      test_expect_eq(r.size(), n);
+      test_expect_eq(w.size(), n);
+      test_expect(std::all_of(s.begin(), s.end(), [](char e){ return (e >= ' ') && (e <= '~'); }));
+      test_expect(std::all_of(r.begin(), r.end(), [](char e){ return (e >= 'a') && (e <= 'f'); }));
+      test_expect(std::all_of(w.begin(), w.end(), [](wchar_t e){ return (e >= L' ') && (e <= L'~'); }));
+    }
+  }
+
+  // Bulk fill, default value ranges and full 64 bit ranges.
+  {
+    auto d = vector<float>(10000, 10.0f);
+    auto i = vector<std::int64_t>(10000, 0);
+    auto u = vector<std::uint64_t>(10000, 0);
+    test_random_fill(d);
+    test_random_fill(i);
+    test_random_fill(u, std::uint64_t(1) << 63, ~std::uint64_t(0));
+    test_expect(std::all_of(d.begin(), d.end(), [](float e){ return (e >= 0) && (e < 1); }));
+    test_expect(std::count_if(i.begin(), i.end(), [](std::int64_t e){ return e < 0; }) > 4000);
+    test_expect(std::count_if(i.begin(), i.end(), [](std::int64_t e){ return e > 0; }) > 4000);
+    test_expect(std::all_of(u.begin(), u.end(), [](std::uint64_t e){ return e >= (std::uint64_t(1) << 63); }));
+  }
+
+  // Bulk fill, same seed, same sequences.
+  {
+    auto a = vector<int>(5000), b = vector<int>(5000);
+    test::random_seed(7);
+    test_random_fill(a, -1000, 1000);
+    test::random_seed(7);
+    test_random_fill(b, -1000, 1000);
+    test_expect(a == b);
+    test::random_seed(7);
+    test_expect(test_random<vector<int>>(5000, -1000, 1000) == a);
+  }
+
+  // Bounded integers with a range that is not a power of two (no modulo bias).
+  {
+    const auto n = size_t(3000000);
+    auto v = vector<std::uint32_t>(n);
+    test_random_fill(v, 0u, 2u);
+    auto histogram = vector<size_t>(3, 0);
+    for(const auto e: v) { ++histogram[e]; }
+    test_expect(*std::min_element(histogram.begin(), histogram.end()) > (n/3 - n/300));
+    test_expect(*std::max_element(histogram.begin(), histogram.end()) < (n/3 + n/300));
+  }
+
+  // Throughput information.
+  {
+    const auto t0 = std::chrono::steady_clock::now();
+    const auto v = test_random<vector<double>>(10000000, 0, 1);
+    const auto dt = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0).count();
+    test_info("random<vector<double>>(1e7, 0, 1): ", dt, "ms");
+    test_expect_eq(v.size(), 10000000u);
+  }
+  {
+    auto v = vector<double>(10000000);
+    const auto t0 = std::chrono::steady_clock::now();
+    test_random_fill(v, 0, 1);
+    const auto dt = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0).count();
+    test_info("random_fill(vector<double>(1e7), 0, 1): ", dt, "ms");
+  }
+
+  test::random_seed(initial_seed);
+}
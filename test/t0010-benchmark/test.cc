@@ -0,0 +1,215 @@
+/**
+ * @test benchmark
+ *
+ * Checks the `test_benchmark` measurement (warmup, iterations per
+ * sample, statistics), and the `[info]` record it logs. Checks the
+ * baseline comparison of `test_expect_faster_than` in a temporary
+ * baseline directory.
+ */
+#define WITH_MICROTEST_BENCHMARK
+#define WITH_MICROTEST_TMPFILE
+#include <testenv.hh>
+#include <thread>
+#include <numeric>
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace std;
+
+void set_env(const char* name, const char* value)
+{
+#ifdef _WIN32
+  ::_putenv_s(name, value ? value : "");
+#else
+  if(value) { ::setenv(name, value, 1); } else { ::unsetenv(name); }
+#endif
+}
+
+string read_file(const string& path)
+{
+  auto is = std::ifstream(path);
+  auto ss = std::stringstream();
+  ss << is.rdbuf();
+  return ss.str();
+}
+
+// Baseline comparison, run first because of the intentional fails.
+void test_baselines()
+{
+  using namespace sw::utest;
+  const auto dir = test_make_tmpdir();
+  const auto baseline_file = dir.path() + "/benchmark.baseline";
+  const auto had_baseline_dir = (std::getenv("MICROTEST_BASELINE_DIR") != nullptr);
+  const auto had_update = (std::getenv("MICROTEST_UPDATE_BASELINES") != nullptr);
+  const auto restore_dir = had_baseline_dir ? string(std::getenv("MICROTEST_BASELINE_DIR")) : string();
+  const auto restore_update = had_update ? string(std::getenv("MICROTEST_UPDATE_BASELINES")) : string();
+  auto options = benchmark_options();
+  options.warmup_ms = 1;
+  options.measure_ms = 10;
+  options.samples = 10;
+  const auto sleep_1ms = []() { std::this_thread::sleep_for(std::chrono::milliseconds(1)); };
+  set_env("MICROTEST_BASELINE_DIR", dir.path().c_str());
+  set_env("MICROTEST_UPDATE_BASELINES", nullptr);
+  test_expect(detail::benchmark_baselines<>::path() == baseline_file);
+
+  // Missing baseline: warning, no fail.
+  auto os = std::stringstream();
+  const auto was_reporter = test::reporter();  // text records checked
+  test::reporter(test::report_text);
+  test::stream(os);
+  const auto missing_ok = test_expect_faster_than("sleep\t1ms", 0.1, sleep_1ms, options);
+  const auto missing_warns = test::num_warnings();
+  const auto missing_fails = test::num_fails();
+  // Stored baseline much faster than the measurement: fail.
+  {
+    auto fast = benchmark_baseline();
+    fast.median = 1000;
+    fast.mad = 10;
+    fast.samples = 10;
+    detail::benchmark_baselines<>::store("too slow", fast);
+  }
+  const auto slower_ok = test_expect_faster_than("too slow", 0.1, sleep_1ms, options);
+  const auto slower_fails = test::num_fails();
+  test::stream(cout);
+  test::reporter(was_reporter);
+  test::reset();
+  test_info("Log:\n", os.str());
+  test_expect(missing_ok);
+  test_expect_eq(missing_warns, 1u);
+  test_expect_eq(missing_fails, 0u);
+  test_expect(!slower_ok);
+  test_expect_eq(slower_fails, 1u);
+
+  // Update mode writes the baseline, the comparison then passes.
+  set_env("MICROTEST_UPDATE_BASELINES", "1");
+  test_expect(test_expect_faster_than("sleep\t1ms", 0.1, sleep_1ms, options));
+  set_env("MICROTEST_UPDATE_BASELINES", nullptr);
+  auto baseline = benchmark_baseline();
+  test_expect(detail::benchmark_baselines<>::load("sleep 1ms", baseline));
+  test_expect((baseline.median >= 1e6) && (baseline.median < 1e8));
+  test_expect_eq(baseline.samples, 10u);
+  test_expect(read_file(baseline_file).find("sleep 1ms\t") != string::npos);
+  test_expect(read_file(baseline_file).find("too slow\t1000\t10\t10\n") != string::npos);
+  test_expect(test_expect_faster_than("sleep\t1ms", 0.5, sleep_1ms, options));
+
+  // Threshold: tolerance plus three standard errors of the median difference.
+  {
+    auto current = benchmark_result();
+    current.mad = 0;
+    current.samples = 10;
+    auto b = benchmark_baseline();
+    b.median = 100;
+    b.mad = 0;
+    b.samples = 10;
+    test_expect(std::abs(detail::benchmark<>::threshold(b, current, 0.1) - 110) < 1e-9);
+    current.mad = 10;
+    test_expect(detail::benchmark<>::threshold(b, current, 0.1) > 110 + 3 * 10 / std::sqrt(10.0));
+  }
+
+  std::remove(baseline_file.c_str());
+  set_env("MICROTEST_BASELINE_DIR", had_baseline_dir ? restore_dir.c_str() : nullptr);
+  set_env("MICROTEST_UPDATE_BASELINES", had_update ? restore_update.c_str() : nullptr);
+}
+
+void test(const vector<string>& args)
+{
+  using namespace sw::utest;
+  (void)args;
+  test_baselines();
+
+  // Statistics of a known sample set.
+  {
+    auto r = benchmark_result();
+    r.sample_ns = vector<double>{5, 1, 4, 2, 3};
+    detail::benchmark<>::evaluate(r);
+    test_expect_eq(r.min, 1);
+    test_expect_eq(r.median, 3);
+    test_expect_eq(r.mean, 3);
+    test_expect_eq(r.p99, 5);
+    test_expect(std::abs(r.stddev - std::sqrt(2.5)) < 1e-9);
+    test_expect(r.sample_ns == vector<double>({1, 2, 3, 4, 5}));
+    test_expect_eq(r.mad, 1);
+  }
+
+  // Duration texts.
+  {
+    test_expect_eq(detail::benchmark<>::duration_text(12.5), "12.5ns");
+    test_expect_eq(detail::benchmark<>::duration_text(1500), "1.5us");
+    test_expect_eq(detail::benchmark<>::duration_text(2.5e6), "2.5ms");
+    test_expect_eq(detail::benchmark<>::duration_text(3e9), "3s");
+  }
+
+  // Cheap function: many iterations per sample.
+  {
+    auto options = benchmark_options();
+    options.warmup_ms = 5;
+    options.measure_ms = 20;
+    options.samples = 20;
+    auto v = vector<int>(1000);
+    std::iota(v.begin(), v.end(), 0);
+    const auto r = test_benchmark("accumulate 1000 ints", [&]() {
+      auto sum = std::accumulate(v.begin(), v.end(), 0);
+      test_do_not_optimize(sum);
+    }, options);
+    test_expect_eq(r.name, "accumulate 1000 ints");
+    test_expect_eq(r.samples, 20u);
+    test_expect_eq(r.sample_ns.size(), 20u);
+    test_expect(r.iterations > 1);
+    test_expect((r.min > 0) && (r.min <= r.median) && (r.median <= r.p99));
+    test_expect(r.mean >= r.min);
+  }
+
+  // Slow function: per iteration time matches, at least one iteration per sample.
+  {
+    auto options = benchmark_options();
+    options.warmup_ms = 1;
+    options.measure_ms = 5;  // 1ms per sample < 2ms per iteration
+    options.samples = 5;
+    auto n = 0u;
+    const auto r = test_benchmark("sleep 2ms", [&]() { ++n; std::this_thread::sleep_for(std::chrono::milliseconds(2)); }, options);
+    test_expect_eq(r.iterations, 1u);
+    test_expect(r.min >= 2e6);
+    test_expect(n >= 6);
+  }
+
+  // Sample duration: iterations per sample from the warmup estimate, the
+  // total time matches the measurement time (tolerant, timing on loaded
+  // machines, a wrong estimate would double the times).
+  {
+    auto options = benchmark_options();
+    options.warmup_ms = 5;
+    options.measure_ms = 100;
+    options.samples = 5;
+    const auto sleep_1ms = []() { std::this_thread::sleep_for(std::chrono::milliseconds(1)); };
+    const auto t0 = std::chrono::steady_clock::now();
+    const auto r = test_benchmark("sleep 1ms", sleep_1ms, options);
+    const auto total_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    const auto sample_ms = double(r.iterations) * r.median * 1e-6;
+    test_info("sample: ", sample_ms, "ms, total: ", total_ms, "ms");
+    test_expect((sample_ms > 0.5 * 20) && (sample_ms < 1.6 * 20));
+    test_expect((total_ms > 0.5 * 100) && (total_ms < 1.6 * 100 + 5 + 10));
+  }
+
+  // Log record format.
+  {
+    auto os = std::stringstream();
+    auto options = benchmark_options();
+    options.warmup_ms = 1;
+    options.measure_ms = 1;
+    options.samples = 3;
+    auto x = 1;
+    const auto was_reporter = test::reporter();  // text records checked
+    test::reporter(test::report_text);
+    test::stream(os);
+    test_benchmark("increment", [&]() { ++x; test_clobber_memory(); }, options);
+    test::stream(cout);
+    test::reporter(was_reporter);
+    const auto log = os.str();
+    test_info("Log: ", log);
+    test_expect(log.rfind("[info] [@", 0) == 0);
+    test_expect(log.find("benchmark 'increment': ") != log.npos);
+    test_expect(log.find("/iteration (min ") != log.npos);
+    test_expect(log.find("; 3 samples x ") != log.npos);
+  }
+}
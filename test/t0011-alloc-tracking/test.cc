@@ -0,0 +1,180 @@
+/**
+ * @test alloc-tracking
+ *
+ * Checks the allocation counting of `test_alloc_scope` with the replaced
+ * global `operator new`/`delete`: Counts, bytes, peak and live bytes,
+ * nested scopes, per-thread counting, and alignment of the returned
+ * memory. Checks the `test_expect_no_alloc` pass/fail records.
+ */
+#define WITH_MICROTEST_ALLOC_TRACKING
+#include <testenv.hh>
+#include <thread>
+#include <memory>
+#include <cstddef>
+#include <sstream>
+
+using namespace std;
+
+// Keeps the compiler from eliding new/delete pairs.
+void* volatile sink = nullptr;
+
+struct alignas(64) overaligned
+{
+  char data[64];
+};
+
+void test(const vector<string>& args)
+{
+  using namespace sw::utest;
+  (void)args;
+
+  // Counts and bytes of single allocations.
+  {
+    auto scope = test_alloc_scope();
+    test_expect_eq(scope.allocations(), 0u);
+    auto* p = new char[100];
+    sink = p;
+    test_expect_eq(scope.allocations(), 1u);
+    test_expect_eq(scope.bytes(), 100u);
+    test_expect_eq(scope.live_bytes(), 100);
+    test_expect_eq(scope.peak_bytes(), 100u);
+    delete[] p;
+    test_expect_eq(scope.frees(), 1u);
+    test_expect_eq(scope.live_bytes(), 0);
+    test_expect_eq(scope.peak_bytes(), 100u);
+    test_info("new char[100]: ", scope);
+  }
+
+  // Peak bytes: maximum of simultaneously allocated memory.
+  {
+    auto scope = test_alloc_scope();
+    for(int i = 0; i < 10; ++i) {
+      auto v = unique_ptr<char[]>(new char[1000]);
+      sink = v.get();
+    }
+    test_expect_eq(scope.allocations(), 10u);
+    test_expect_eq(scope.frees(), 10u);
+    test_expect_eq(scope.bytes(), 10000u);
+    test_expect_eq(scope.peak_bytes(), 1000u);
+    scope.reset();
+    test_expect_eq(scope.allocations(), 0u);
+    test_expect_eq(scope.peak_bytes(), 0u);
+  }
+
+  // Nested scopes: the inner peak restart does not hide the outer peak.
+  {
+    auto outer = test_alloc_scope();
+    auto* p = new char[4096];
+    sink = p;
+    delete[] p;
+    {
+      auto inner = test_alloc_scope();
+      auto* q = new char[16];
+      sink = q;
+      delete[] q;
+      test_expect_eq(inner.peak_bytes(), 16u);
+      test_expect_eq(inner.allocations(), 1u);
+    }
+    test_expect_eq(outer.peak_bytes(), 4096u);
+    test_expect_eq(outer.allocations(), 2u);
+  }
+
+  // Containers and non-allocating code.
+  {
+    auto v = vector<int>();
+    v.reserve(1000);
+    auto scope = test_alloc_scope();
+    for(int i = 0; i < 1000; ++i) { v.push_back(i); }
+    test_expect_eq(scope.allocations(), 0u);
+    auto s = string(1000, 'x');
+    test_expect_ge(scope.allocations(), 1u);
+    test_expect_ge(scope.bytes(), 1000u);
+  }
+
+  // Per-thread and process wide counting.
+  {
+    auto all = test_alloc_scope();
+    auto self = test_alloc_scope(alloc_scope::this_thread);
+    auto thread_allocations = 0ull;
+    auto t = thread([&]() {
+      auto local = test_alloc_scope(alloc_scope::this_thread);
+      for(int i = 0; i < 100; ++i) { auto p = unique_ptr<int>(new int(i)); sink = p.get(); }
+      thread_allocations = local.allocations();
+    });
+    t.join();
+    test_expect_eq(thread_allocations, 100u);
+    test_expect_ge(all.allocations(), 100u);
+    test_expect_lt(self.allocations(), all.allocations());
+  }
+
+  // Nothrow and over-aligned allocations.
+  {
+    auto scope = test_alloc_scope();
+    auto* p = new(std::nothrow) int(1);
+    test_expect(p != nullptr);
+    delete p;
+    test_expect_eq(scope.allocations(), 1u);
+    #ifdef __cpp_aligned_new
+    auto* a = new overaligned();
+    test_expect_eq(reinterpret_cast<std::uintptr_t>(a) % 64, 0u);
+    delete a;
+    auto* b = new overaligned[3];
+    test_expect_eq(reinterpret_cast<std::uintptr_t>(b) % 64, 0u);
+    delete[] b;
+    test_expect_eq(scope.allocations(), 3u);
+    test_expect_eq(scope.frees(), 3u);
+    #endif
+    test_expect_eq(scope.live_bytes(), 0);
+  }
+
+  // No-allocation regions.
+  {
+    auto v = vector<int>();
+    v.reserve(100);
+    test_expect_no_alloc({ for(int i = 0; i < 100; ++i) { v.push_back(i); } });
+    test_expect_no_alloc(v.clear());
+    test_expect_no_alloc({
+      test_expect_eq(v.size(), 0u);  // logging checks does not allocate
+    });
+    // Allocations of other threads are not accounted.
+    auto t = thread([]() { auto p = unique_ptr<int>(new int(1)); sink = p.get(); });
+    test_expect_no_alloc({ t.join(); });
+  }
+
+  // Failed no-allocation checks: count, bytes, and sizes in the record.
+  {
+    const auto was_ansi = test::ansi_colors();
+    const auto was_omit = test::omit_pass_log();
+    auto os = stringstream();
+    auto num_fails = 0u;
+    {
+      const auto restore = teststream_restore();
+      test::ansi_colors(false);
+      test::omit_pass_log(false);
+      test::stream(os);
+      test::reset();
+      test_expect_no_alloc({ auto p = unique_ptr<char[]>(new char[24]); auto q = unique_ptr<char[]>(new char[100]); sink = p.get(); sink = q.get(); });
+      test_expect_no_alloc({ for(int i = 0; i < 20; ++i) { auto p = unique_ptr<int>(new int(i)); sink = p.get(); } });
+      test_expect_no_alloc({
+        test_expect_no_alloc({ sink = nullptr; });
+        auto p = unique_ptr<char[]>(new char[7]);
+        sink = p.get();
+        test_expect_no_alloc({ auto q = unique_ptr<char[]>(new char[9]); sink = q.get(); });
+      });
+      test_expect_no_alloc(throw 1);
+      num_fails = test::num_fails();
+    }
+    test::reset();
+    test::ansi_colors(was_ansi);
+    test::omit_pass_log(was_omit);
+    const auto log = os.str();
+    test_expect_eq(num_fails, 5u);
+    test_expect(log.find("| 2 heap allocation(s), 124 bytes (sizes 24, 100)") != string::npos);
+    test_expect(log.find("| 20 heap allocation(s), " + to_string(20 * sizeof(int)) + " bytes (sizes 4, 4, 4, 4, 4, 4, 4, 4, ...)") != string::npos);
+    test_expect(log.find("| 1 heap allocation(s), 9 bytes (sizes 9)") != string::npos);
+    test_expect(log.find("(sizes 7, 9") != string::npos);  // (the stringstream may allocate when logging the inner fail)
+    test_expect(log.find("[pass] [@" __FILE__) != string::npos);
+    test_expect(log.find("Unexpected exception") != string::npos);
+    if(num_fails != 5u) { test_info("Log:\n", log); }
+  }
+}
@@ -0,0 +1,121 @@
+/**
+ * @test perf-counters
+ *
+ * Checks the `test_perf_counters` scopes: Availability and fallbacks of
+ * the counted events, page faults of touched memory, stopped counters,
+ * instructions per element (where hardware counters are accessible),
+ * the `[info]` record, and the per-iteration counters of benchmarks.
+ */
+#define WITH_MICROTEST_PERF_COUNTERS
+#define WITH_MICROTEST_BENCHMARK
+#include <testenv.hh>
+#include <sstream>
+#include <numeric>
+#include <algorithm>
+
+using namespace std;
+
+void test(const vector<string>& args)
+{
+  using namespace sw::utest;
+  (void)args;
+
+  // Event availability: Software events or their fallbacks are always there on Linux.
+  {
+    auto perf = test_perf_counters("availability");
+    perf.report();
+    const auto c = perf.counts();
+    #if defined(__linux__)
+    test_expect(c.has(perf_event::page_faults));
+    test_expect(c.has(perf_event::context_switches));
+    #endif
+    test_expect_eq(c.has(perf_event::cycles), perf.has(perf_event::cycles));
+    test_expect_eq(c.value(perf_event::instructions), perf.instructions());
+    if(!c.has(perf_event::instructions)) {
+      test_expect_eq(perf.instructions(), 0u);
+      test_expect_eq(c.per(perf_event::instructions, 10), 0.0);
+    }
+  }
+
+  // Page faults of touched fresh memory, values frozen after stop().
+  {
+    constexpr size_t size = 16u << 20;
+    auto perf = test_perf_counters("touch 16MB");
+    auto data = unique_ptr<char[]>(new char[size]);
+    for(size_t i = 0; i < size; i += 1024) { data[i] = char(i); }
+    test_do_not_optimize(data[size/2]);
+    perf.stop();
+    const auto page_faults = perf.page_faults();
+    perf.report();
+    if(perf.has(perf_event::page_faults)) {
+      test_expect_ge(page_faults, 16u);
+    }
+    for(size_t i = 0; i < size; i += 1024) { data[i] = char(i+1); }
+    test_expect_eq(perf.page_faults(), page_faults);
+  }
+
+  // Instructions per element, only checkable with hardware counter access.
+  {
+    auto v = vector<unsigned>(1u << 20);
+    iota(v.begin(), v.end(), 0u);
+    auto perf = test_perf_counters("accumulate 1M");
+    auto sum = accumulate(v.begin(), v.end(), 0ull);
+    test_do_not_optimize(sum);
+    perf.stop();
+    perf.report();
+    if(perf.has(perf_event::instructions)) {
+      test_expect_lt(perf.counts().per(perf_event::instructions, double(v.size())), 50.0);
+      test_expect_gt(perf.cycles(), 0u);
+    } else {
+      test_info("No hardware counter access, instructions per element not checked.");
+    }
+  }
+
+  // Counters per test section, accumulated over the runs.
+  {
+    using sections = ::sw::utest::detail::test_sections<>;
+    for(int run = 0; run < 2; ++run) {
+      test_section("perf section") {
+        auto data = unique_ptr<char[]>(new char[64u << 20]); // (beyond the malloc mmap threshold, fresh pages)
+        for(size_t i = 0; i < (64u << 20); i += 1024) { data[i] = char(i); }
+        test_do_not_optimize(data[512]);
+      }
+    }
+    const auto entries = sections::slowest(1000);
+    const auto it = find_if(entries.begin(), entries.end(), [](const sections::entry& e){ return e.path == "perf section"; });
+    test_expect(it != entries.end());
+    if(it != entries.end()) {
+      test_expect_eq(it->runs, 2u);
+      #if defined(__linux__)
+      const auto pf = find_if(it->counters.begin(), it->counters.end(), [](const pair<const char*, uint64_t>& c){ return string(c.first) == "page_faults"; });
+      test_expect(pf != it->counters.end());
+      if(pf != it->counters.end()) test_expect_ge(pf->second, 2u);
+      #endif
+    }
+  }
+
+  // Log record format.
+  {
+    const auto was_ansi = test::ansi_colors();
+    auto os = stringstream();
+    auto options = benchmark_options();
+    options.warmup_ms = 1;
+    options.measure_ms = 5;
+    options.samples = 5;
+    {
+      const auto restore = teststream_restore();
+      test::ansi_colors(false);
+      test::stream(os);
+      auto perf = test_perf_counters("format");
+      perf.report();
+      test_benchmark("noop", [](){ test_clobber_memory(); }, options);
+    }
+    test::ansi_colors(was_ansi);
+    const auto log = os.str();
+    test_expect(log.find("[info] [@" __FILE__) == 0);
+    test_expect(log.find("] perf 'format': cycles=") != string::npos);
+    test_expect(log.find(", context_switches=") != string::npos);
+    test_expect(log.find("\n          per iteration: ") != string::npos);
+    test_info("Log:\n", log);
+  }
+}
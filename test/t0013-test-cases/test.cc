@@ -0,0 +1,187 @@
+/**
+ * @test test-cases
+ *
+ * Checks the registration of `test_case()`s (without a `test()` function),
+ * and the parallel runner: Work distribution over several threads, per
+ * case accounting, and output grouped per case in registration order
+ * independent of the number of jobs. Checks the stable shard selection.
+ */
+#define WITH_MICROTEST_CASES
+#include <testenv.hh>
+#include <sstream>
+#include <thread>
+#include <mutex>
+#include <set>
+
+using namespace std;
+using cases = ::sw::utest::detail::test_cases<>;
+
+namespace {
+
+  std::mutex threads_lock;
+  std::set<std::thread::id> threads_used;
+
+  // Runner case body: Several records with pauses, so that the cases interleave.
+  template <int N>
+  void inner_case()
+  {
+    {
+      std::lock_guard<std::mutex> lck(threads_lock);
+      threads_used.insert(std::this_thread::get_id());
+    }
+    for(int i = 0; i < 3; ++i) {
+      test_expect_eq(N, N);
+      test_info("inner ", N, " record ", i);
+      std::this_thread::sleep_for(std::chrono::milliseconds((N * 7) % 5 + 1));
+    }
+    if(N == 5) test_warn("inner 5 warning");
+    if(N == 6) throw std::runtime_error("inner 6 error");
+  }
+
+  // Runs the inner cases with `jobs` workers, returns the log.
+  string run_inner(unsigned jobs)
+  {
+    auto entries = vector<cases::entry>();
+    entries.push_back(cases::entry{"inner 0", "inner.cc", 10, &inner_case<0>});
+    entries.push_back(cases::entry{"inner 1", "inner.cc", 11, &inner_case<1>});
+    entries.push_back(cases::entry{"inner 2", "inner.cc", 12, &inner_case<2>});
+    entries.push_back(cases::entry{"inner 3", "inner.cc", 13, &inner_case<3>});
+    entries.push_back(cases::entry{"inner 4", "inner.cc", 14, &inner_case<4>});
+    entries.push_back(cases::entry{"inner 5", "inner.cc", 15, &inner_case<5>});
+    entries.push_back(cases::entry{"inner 6", "inner.cc", 16, &inner_case<6>});
+    entries.push_back(cases::entry{"inner 7", "inner.cc", 17, &inner_case<7>});
+    const auto was_ansi = ::sw::utest::test::ansi_colors();
+    const auto was_omit = ::sw::utest::test::omit_pass_log();
+    auto os = stringstream();
+    {
+      const auto restore = teststream_restore();
+      ::sw::utest::test::ansi_colors(false);
+      ::sw::utest::test::omit_pass_log(false);
+      ::sw::utest::test::stream(os);
+      cases::run(entries, jobs);
+    }
+    ::sw::utest::test::ansi_colors(was_ansi);
+    ::sw::utest::test::omit_pass_log(was_omit);
+    return os.str();
+  }
+
+  // Log without the timing of the case result lines.
+  string without_times(const string& log)
+  {
+    auto s = string();
+    auto is = stringstream(log);
+    auto line = string();
+    while(getline(is, line)) {
+      const auto p = line.rfind(", ");
+      if((line.find("] case '") != string::npos) && (p != string::npos) && (line.find("ms)") != string::npos)) {
+        line = line.substr(0, p) + ")";
+      }
+      s += line + "\n";
+    }
+    return s;
+  }
+
+}
+
+test_case("registration")
+{
+  const auto& registry = cases::registry();
+  if(registry.size() < 6u) { test_info("Sharded run (--shard), registration not checked."); return; }
+  test_expect_eq(registry.size(), 6u);
+  test_expect_eq(string(registry[0].name), "registration");
+  test_expect_eq(string(registry[1].name), "parallel runner");
+  test_expect_eq(string(registry[2].name), "exception");
+  test_expect_eq(string(registry[3].name), "sharding");
+  test_expect_eq(string(registry[4].name), "same line 1");
+  test_expect_eq(string(registry[5].name), "same line 2");
+  test_expect(registry[0].line < registry[1].line);
+  test_expect_eq(registry[4].line, registry[5].line);
+  test_expect(string(registry[0].file).find("t0013-test-cases") != string::npos);
+}
+
+test_case("parallel runner")
+{
+  auto jobs = 0u;
+  test_expect(cases::parse_jobs("4", jobs));
+  test_expect_eq(jobs, 4u);
+  test_expect(cases::parse_jobs("0", jobs));
+  test_expect_eq(jobs, 0u);
+  test_expect(!cases::parse_jobs("-1", jobs));
+  test_expect(!cases::parse_jobs("x", jobs));
+
+  threads_used.clear();
+  const auto serial = run_inner(1);
+  test_expect_eq(threads_used.size(), 1u);
+  threads_used.clear();
+  const auto parallel = run_inner(4);
+  const auto n_threads = threads_used.size();
+  // The inner checks include a failure, which is not part of this test.
+  ::sw::utest::test::reset();
+  test_info("Threads used by 4 jobs: ", n_threads);
+  test_expect_gt(n_threads, 1u);
+  test_expect(without_times(serial) == without_times(parallel));
+  // Records grouped per case, in registration order.
+  auto last = string::size_type(0);
+  for(int n = 0; n < 8; ++n) {
+    const auto first = parallel.find("inner " + to_string(n) + " record 0");
+    const auto result = parallel.find("] case 'inner " + to_string(n) + "': ");
+    test_expect(first != string::npos && result != string::npos);
+    test_expect(first >= last);
+    test_expect(result > first);
+    test_expect(parallel.find("inner " + to_string(n) + " record 2") < result);
+    last = result;
+  }
+  test_expect(parallel.find("[note] [@inner.cc:10] case 'inner 0': passed (3 checks, 0 warnings, ") != string::npos);
+  test_expect(parallel.find("[note] [@inner.cc:15] case 'inner 5': passed (3 checks, 1 warnings, ") != string::npos);
+  test_expect(parallel.find("[fail] [@inner.cc:16] case 'inner 6': Unexpected exception: inner 6 error") != string::npos);
+  test_expect(parallel.find("[note] [@inner.cc:16] case 'inner 6': 1 of 4 checks failed (0 warnings, ") != string::npos);
+  if(without_times(serial) != without_times(parallel)) { test_info("Serial:\n", serial, "\nParallel:\n", parallel); }
+}
+
+test_case("exception")
+{
+  test_expect_except(throw std::runtime_error("expected"));
+}
+
+test_case("sharding")
+{
+  auto index = 0u, count = 0u;
+  test_expect(cases::parse_shard("2/4", index, count));
+  test_expect_eq(index, 2u);
+  test_expect_eq(count, 4u);
+  test_expect(!cases::parse_shard("0/4", index, count));
+  test_expect(!cases::parse_shard("5/4", index, count));
+  test_expect(!cases::parse_shard("3/2", index, count));
+  test_expect(!cases::parse_shard("x", index, count));
+  test_expect(!cases::parse_shard("", index, count));
+  test_expect(!cases::parse_shard("1/2/3", index, count));
+  test_expect(!cases::parse_shard("1/0", index, count));
+  test_expect(!cases::parse_shard("1", index, count));
+  test_expect(!cases::parse_shard("1/4x", index, count));
+  test_expect(!cases::parse_shard("-1/4", index, count));
+  // Stable, platform independent hash.
+  test_expect_eq(cases::name_hash(""), 0xcbf29ce484222325ull);
+  test_expect_eq(cases::name_hash("a"), 0xaf63dc4c8601ec8cull);
+  // Each case is in exactly one shard, and the shards are roughly balanced.
+  constexpr unsigned n_shards = 4, n_cases = 1000;
+  auto names = vector<string>();
+  for(unsigned i = 0; i < n_cases; ++i) { names.push_back("case " + to_string(i)); }
+  auto per_shard = vector<unsigned>(n_shards, 0u);
+  auto all_unique = true, all_in_single = true;
+  for(const auto& name: names) {
+    const auto e = cases::entry{name.c_str(), __FILE__, __LINE__, nullptr};
+    auto n_in = 0u;
+    for(unsigned s = 1; s <= n_shards; ++s) {
+      if(cases::in_shard(e, s, n_shards)) { ++n_in; ++per_shard[s-1]; }
+    }
+    all_unique = all_unique && (n_in == 1);
+    all_in_single = all_in_single && cases::in_shard(e, 1, 1);
+  }
+  test_expect(all_unique);
+  test_expect(all_in_single);
+  for(const auto n: per_shard) { test_expect_gt(n, n_cases / n_shards / 2); }
+  test_info("Cases per shard: ", per_shard[0], ", ", per_shard[1], ", ", per_shard[2], ", ", per_shard[3]);
+}
+
+// Unique case function names (`__COUNTER__`), also on one line.
+test_case("same line 1") { test_expect(true); } test_case("same line 2") { test_expect(true); }
@@ -0,0 +1,136 @@
+/**
+ * @test isolation
+ *
+ * Checks the fork-isolated execution of test cases: Counts and records of
+ * the child processes, crashes, unexpected exits, uncaught exceptions,
+ * and timeouts failing only their case, and the output grouped per case
+ * in definition order with parallel children.
+ */
+#define WITH_MICROTEST_CASES
+#include <testenv.hh>
+#include <sstream>
+#include <thread>
+#include <csignal>
+#include <cstdlib>
+
+using namespace std;
+using cases = ::sw::utest::detail::test_cases<>;
+
+namespace {
+
+  void case_pass()
+  {
+    test_expect_eq(1, 1);
+    test_info("pass case record");
+    test_warn("pass case warning");
+  }
+
+  void case_fail()
+  {
+    test_expect_eq(1, 1);
+    test_expect_eq(1, 2);
+  }
+
+  void case_segfault()
+  {
+    test_expect_eq(1, 1);
+    test_info("before crash");
+    std::raise(SIGSEGV);
+  }
+
+  void case_abort()
+  {
+    std::abort();
+  }
+
+  void case_exit()
+  {
+    test_expect_eq(1, 1);
+    std::exit(3);
+  }
+
+  void case_hang()
+  {
+    test_info("hanging");
+    std::this_thread::sleep_for(std::chrono::seconds(30));
+  }
+
+  void case_last()
+  {
+    test_expect_eq(2, 2);
+    test_info("last case record");
+  }
+
+  // Runs the inner cases isolated, returns the log and the counts.
+  string run_inner(unsigned jobs, uint64_t& checks, uint64_t& fails, uint64_t& warns)
+  {
+    auto entries = vector<cases::entry>();
+    entries.push_back(cases::entry{"pass", "inner.cc", 10, &case_pass});
+    entries.push_back(cases::entry{"fail", "inner.cc", 11, &case_fail});
+    entries.push_back(cases::entry{"segfault", "inner.cc", 12, &case_segfault});
+    entries.push_back(cases::entry{"abort", "inner.cc", 13, &case_abort});
+    entries.push_back(cases::entry{"exit", "inner.cc", 14, &case_exit});
+    entries.push_back(cases::entry{"hang", "inner.cc", 15, &case_hang});
+    entries.push_back(cases::entry{"last", "inner.cc", 16, &case_last});
+    const auto was_ansi = ::sw::utest::test::ansi_colors();
+    auto os = stringstream();
+    {
+      const auto restore = teststream_restore();
+      ::sw::utest::test::ansi_colors(false);
+      ::sw::utest::test::stream(os);
+      ::sw::utest::test::reset();
+      cases::run_isolated(entries, jobs, 0.5);
+      checks = ::sw::utest::test::num_checks();
+      fails = ::sw::utest::test::num_fails();
+      warns = ::sw::utest::test::num_warnings();
+      ::sw::utest::test::reset();
+    }
+    ::sw::utest::test::ansi_colors(was_ansi);
+    return os.str();
+  }
+
+}
+
+void test(const vector<string>& args)
+{
+  (void)args;
+  for(const auto jobs: {1u, 4u}) {
+    uint64_t checks=0, fails=0, warns=0;
+    const auto t0 = chrono::steady_clock::now();
+    const auto log = run_inner(jobs, checks, fails, warns);
+    const auto ms = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - t0).count();
+    test_info("jobs=", jobs, ": ", ms, "ms, ", checks, " checks, ", fails, " fails, ", warns, " warnings");
+    // pass: 1 check, fail: 2 checks/1 fail, segfault: 1+1 checks/1 fail (best-effort count from the crash hook),
+    // abort: 1 fail, exit: 1 fail (count lost), hang: 1 fail, last: 1 check.
+    test_expect_eq(fails, 5u);
+    test_expect_eq(warns, 1u);
+    test_expect_ge(checks, 8u);
+    test_expect(log.find("[note] [@inner.cc:10] case 'pass': passed (1 checks, 1 warnings, ") != string::npos);
+    test_expect(log.find("[fail] [@") != string::npos);
+    test_expect(log.find("[note] [@inner.cc:11] case 'fail': 1 of 2 checks failed") != string::npos);
+    test_expect(log.find("] before crash") != string::npos);
+    test_expect(log.find("[fail] [@inner.cc:12] case 'segfault': Terminated by signal " + to_string(SIGSEGV)) != string::npos);
+    test_expect(log.find("[fail] [@inner.cc:13] case 'abort': Terminated by signal " + to_string(SIGABRT)) != string::npos);
+    test_expect(log.find("[fail] [@inner.cc:14] case 'exit': Exited unexpectedly with code 3") != string::npos);
+    test_expect(log.find("[fail] [@inner.cc:15] case 'hang': Timeout after 0.5s") != string::npos);
+    test_expect(log.find("] hanging") != string::npos);
+    test_expect(log.find("[note] [@inner.cc:16] case 'last': passed (1 checks, 0 warnings, ") != string::npos);
+    // Grouped in definition order.
+    test_expect(log.find("pass case record") < log.find("case 'fail'"));
+    test_expect(log.find("before crash") < log.find("case 'segfault': Terminated"));
+    test_expect(log.find("case 'hang': Timeout") < log.find("last case record"));
+    if(fails != 5u) { test_info("Log:\n", log); }
+  }
+  // Timeout argument (`--timeout=S`).
+  auto timeout_s = -1.0;
+  test_expect(cases::parse_timeout("60", timeout_s));
+  test_expect_eq(timeout_s, 60.0);
+  test_expect(cases::parse_timeout("0.5", timeout_s));
+  test_expect_eq(timeout_s, 0.5);
+  test_expect(cases::parse_timeout("0", timeout_s));
+  test_expect_eq(timeout_s, 0.0);
+  for(const auto text: {"", "x", "-1", " 1", "1s", "nan", "inf", "1e99"}) {
+    test_expect(!cases::parse_timeout(text, timeout_s));
+  }
+  test_expect_eq(timeout_s, 0.0);
+}
@@ -0,0 +1,147 @@
+/**
+ * @test reporters
+ *
+ * Checks the structured reporters: JSON Lines records with escaped
+ * strings, site and check kind, JUnit XML suite structure with failures,
+ * test case results, and the TAP plan and comment lines.
+ */
+#define WITH_MICROTEST_CASES
+#include <testenv.hh>
+#include <sstream>
+
+using namespace std;
+using cases = ::sw::utest::detail::test_cases<>;
+
+namespace {
+
+  void case_pass()
+  { test_expect_eq(1, 1); }
+
+  void case_fail()
+  { test_expect_eq(1, 2); }
+
+  // Logs a set of records with the given reporter, returns the output.
+  string run_inner(::sw::utest::test::reporter_type type)
+  {
+    using namespace ::sw::utest;
+    auto entries = vector<cases::entry>();
+    entries.push_back(cases::entry{"pass <1>", "inner.cc", 10, &case_pass});
+    entries.push_back(cases::entry{"fail \"2\"", "inner.cc", 11, &case_fail});
+    const auto was_omit = test::omit_pass_log();
+    auto os = stringstream();
+    {
+      const auto restore = teststream_restore();
+      test::omit_pass_log(false);
+      test::stream(os);
+      test::reporter(type, "suite<x>");
+      test::reset();
+      const auto s = string("quote\" backslash\\ newline\n tab\t <tag> & -- #");
+      test_expect_eq(s.size(), 44u);
+      test_expect_ne(1, 1);
+      test_warn("warning: ", s);
+      test_info("info");
+      cases::run(entries, 1);
+      test::summary();
+      test::reset();
+    }
+    test::omit_pass_log(was_omit);
+    return os.str();
+  }
+
+  vector<string> lines_of(const string& log)
+  {
+    auto lines = vector<string>();
+    auto is = stringstream(log);
+    auto line = string();
+    while(getline(is, line)) { lines.push_back(line); }
+    return lines;
+  }
+
+  bool contains(const string& s, const string& what)
+  { return s.find(what) != string::npos; }
+
+}
+
+void test(const vector<string>& args)
+{
+  using namespace ::sw::utest;
+  (void)args;
+
+  // Reporter names.
+  {
+    auto type = test::report_text;
+    test_expect(test::parse_reporter("jsonl", type));
+    test_expect_eq(type, test::report_jsonl);
+    test_expect(test::parse_reporter("junit", type));
+    test_expect_eq(type, test::report_junit);
+    test_expect(test::parse_reporter("tap", type));
+    test_expect_eq(type, test::report_tap);
+    test_expect(test::parse_reporter("text", type));
+    test_expect_eq(type, test::report_text);
+    test_expect(!test::parse_reporter("xml", type));
+    test_expect(!test::parse_reporter(nullptr, type));
+    test_expect_eq(type, test::report_text);
+  }
+
+  // JSON Lines: one object per line, escaped strings.
+  {
+    const auto log = run_inner(test::report_jsonl);
+    const auto lines = lines_of(log);
+    test_expect_eq(lines.size(), 9u);
+    auto all_objects = true;
+    for(const auto& line: lines) { all_objects = all_objects && !line.empty() && line.front() == '{' && line.back() == '}'; }
+    test_expect(all_objects);
+    test_expect(contains(lines[0], "{\"result\":\"pass\",\"kind\":\"eq\",\"file\":\"" __FILE__ "\",\"line\":"));
+    test_expect(contains(lines[0], ",\"expr\":\"s.size()\",\"expr_rhs\":\"44u\",\"message\":\""));
+    test_expect(contains(lines[0], ",\"thread\":"));
+    test_expect(contains(lines[0], ",\"time_us\":"));
+    test_expect(contains(lines[1], "{\"result\":\"fail\",\"kind\":\"ne\","));
+    test_expect(contains(lines[2], "\"kind\":\"warn\""));
+    test_expect(contains(lines[2], "warning: quote\\\" backslash\\\\ newline\\n tab\\t <tag> & -- #"));
+    test_expect(contains(lines[3], "{\"result\":\"note\",\"kind\":\"note\","));
+    test_expect(contains(log, "{\"result\":\"pass\",\"kind\":\"case\",\"file\":\"inner.cc\",\"line\":10,\"name\":\"pass <1>\",\"checks\":1,\"fails\":0,\"warnings\":0,\"duration_ms\":"));
+    test_expect(contains(log, "{\"result\":\"fail\",\"kind\":\"case\",\"file\":\"inner.cc\",\"line\":11,\"name\":\"fail \\\"2\\\"\",\"checks\":1,\"fails\":1,"));
+    test_expect(contains(lines.back(), "{\"result\":\"fail\",\"kind\":\"summary\",\"checks\":4,\"fails\":2,\"warnings\":1,\"time_us\":"));
+    test_info("JSON Lines:\n", log);
+  }
+
+  // JUnit XML: suite header, test cases, failures, comments, and the closing tag.
+  {
+    const auto log = run_inner(test::report_junit);
+    const auto lines = lines_of(log);
+    test_expect_eq(lines.size(), 12u);
+    test_expect_eq(lines[0], "<?xml version=\"1.0\" encoding=\"UTF-8\"?>");
+    test_expect_eq(lines[1], "<testsuite name=\"suite&lt;x&gt;\">");
+    test_expect(contains(lines[2], "  <testcase classname=\"suite&lt;x&gt;\" name=\"" __FILE__ ":"));
+    test_expect(contains(lines[2], " s.size(), 44u\" time=\"0.000000\"/>"));
+    test_expect(contains(lines[3], "><failure type=\"ne\" message=\"" __FILE__ ":"));
+    test_expect(contains(lines[3], "\"/></testcase>"));
+    test_expect(contains(lines[4], "  <!-- [warn] "));
+    test_expect(contains(lines[4], "quote&quot; backslash\\ newline&#10; tab\t &lt;tag&gt; &amp; -&#45; # -->"));
+    test_expect(!contains(log, "--&"));
+    test_expect(contains(log, "  <testcase classname=\"suite&lt;x&gt;\" name=\"pass &lt;1&gt;\" time=\""));
+    test_expect(contains(log, "name=\"fail &quot;2&quot;\" time=\""));
+    test_expect(contains(log, "<failure type=\"case\" message=\"1 of 1 checks failed\"/></testcase>"));
+    test_expect_eq(lines[lines.size()-2], "  <system-out>[FAIL] 2 of 4 checks failed, 1 warnings.</system-out>");
+    test_expect_eq(lines.back(), "</testsuite>");
+    test_info("JUnit XML:\n", log);
+  }
+
+  // TAP: version header, test points, comments, and the plan at the end.
+  {
+    const auto log = run_inner(test::report_tap);
+    const auto lines = lines_of(log);
+    test_expect_eq(lines.size(), 11u);
+    test_expect_eq(lines[0], "TAP version 13");
+    test_expect(contains(lines[1], "ok - " __FILE__ ":"));
+    test_expect(contains(lines[2], "not ok - " __FILE__ ":"));
+    test_expect(contains(lines[3], "# [warn] "));
+    test_expect(contains(lines[3], "quote\" backslash\\\\ newline\\n tab\t <tag> & -- \\#"));
+    test_expect(contains(lines[4], "# [note] "));
+    test_expect(contains(log, "\nok - inner.cc:10 case 'pass <1>' (1 checks, "));
+    test_expect(contains(log, "\nnot ok - inner.cc:11 case 'fail \"2\"' (1 of 1 checks failed, "));
+    test_expect_eq(lines[lines.size()-2], "1..6");
+    test_expect_eq(lines.back(), "# [FAIL] 2 of 4 checks failed, 1 warnings.");
+    test_info("TAP:\n", log);
+  }
+}
@@ -0,0 +1,207 @@
+/**
+ * @test binary-log
+ *
+ * Checks the binary log reporter and its decoder: The decoded records are
+ * identical to the text records of the same checks, sites and literals are
+ * described once per thread and output, values are stored as items, thread
+ * indices and timestamps are not truncated, records of several threads and
+ * captured test cases decode, filters select records, invalid or truncated
+ * logs are rejected, and the log volume of pass records is a fraction of
+ * the text.
+ */
+#define WITH_MICROTEST_CASES
+#include <testenv.hh>
+#include <sstream>
+#include <thread>
+
+using namespace std;
+using binary_log = ::sw::utest::detail::binary_log<>;
+using cases = ::sw::utest::detail::test_cases<>;
+
+namespace {
+
+  // The same records for the text and binary reporter.
+  void log_records(int n)
+  {
+    const auto s = string("text\nwith newline");
+    for(int i = 0; i < n; ++i) { test_expect_eq(i, i); }
+    test_expect_ne(1, 2);
+    test_expect_eq(1, 2);
+    test_expect(n > 0);
+    test_expect_cond(n < 0);
+    test_warn("warning ", n);
+    test_info("info: ", s);
+    ::sw::utest::test::pass("F", 1, "explicit");
+    ::sw::utest::test::pass("F", 2, "explicit, other site at the same address");
+    ::sw::utest::test::comment("", 0, "no site");
+  }
+
+  void case_body()
+  {
+    for(int i = 0; i < 10; ++i) { test_expect_lt(i, 10); }
+  }
+
+  // Runs `fn` with the given reporter, returns the log.
+  template <typename Fn>
+  string run_inner(::sw::utest::test::reporter_type type, Fn fn)
+  {
+    using namespace ::sw::utest;
+    const auto was_ansi = test::ansi_colors();
+    const auto was_omit = test::omit_pass_log();
+    auto os = stringstream();
+    {
+      const auto restore = teststream_restore();
+      test::ansi_colors(false);
+      test::omit_pass_log(false);
+      test::stream(os);
+      test::reporter(type, "binary-log");
+      test::reset();
+      fn();
+      test::summary();
+      test::reset();
+    }
+    test::ansi_colors(was_ansi);
+    test::omit_pass_log(was_omit);
+    return os.str();
+  }
+
+  string decoded(const string& bin, const binary_log::filter& sel = binary_log::filter(), bool* ok = nullptr)
+  {
+    auto is = stringstream(bin);
+    auto os = stringstream();
+    const auto valid = binary_log::decode(is, os, sel);
+    if(ok) *ok = valid;
+    return os.str();
+  }
+
+  size_t count_of(const string& s, const string& what)
+  {
+    auto n = size_t(0);
+    for(auto p = s.find(what); p != string::npos; p = s.find(what, p+1)) ++n;
+    return n;
+  }
+
+}
+
+void test(const vector<string>& args)
+{
+  using namespace ::sw::utest;
+  (void)args;
+
+  // Round trip: decoded binary records equal the text records.
+  {
+    const auto text = run_inner(test::report_text, [](){ log_records(3); });
+    const auto bin = run_inner(test::report_binary, [](){ log_records(3); });
+    auto ok = false;
+    const auto dec = decoded(bin, binary_log::filter(), &ok);
+    test_expect(ok);
+    test_expect_eq(dec, text);
+    test_expect(text.find("[fail] [@" __FILE__) != string::npos);
+    test_expect(text.find("[FAIL] 2 of 9 checks failed, 1 warnings.") != string::npos);
+    if(dec != text) { test_info("Text:\n", text, "\nDecoded:\n", dec); }
+    // Sites and literals described once per output (the `test_expect_eq(i, i)` site is used 3 times).
+    auto is = stringstream(bin);
+    auto rec = binary_log::record();
+    auto n_sites = 0u, n_literals = 0u, n_records = 0u, n_eq_payload = 0u;
+    while(binary_log::read(is, rec)) {
+      if(rec.type == binary_log::type_site) ++n_sites;
+      else if(rec.type == binary_log::type_literal) ++n_literals;
+      else ++n_records;
+      // `i == i   (=1)`: expression, literal, rhs expression (or the same string), literal, value, literal.
+      const auto& p = rec.payload;
+      const auto is_literal = [&](size_t i) { return (i < p.size()) && (static_cast<unsigned char>(p[i]) & binary_log::item_short_literal); };
+      if((rec.type == 0) && (p.size() == 7u) && (p[0] == char(binary_log::item_expr)) && is_literal(1)
+        && ((p[2] == char(binary_log::item_expr)) || (p[2] == char(binary_log::item_expr_rhs)))
+        && is_literal(3) && (p[4] == char(binary_log::item_int)) && (p[5] == char(2)) && is_literal(6)) ++n_eq_payload;
+    }
+    test_expect_eq(n_sites, 10u);
+    test_expect_eq(n_literals, 10u);
+    test_expect_eq(n_records, 1u + 12u + 1u);  // version, checks and notes, summary
+    test_expect_eq(n_eq_payload, 1u);
+  }
+
+  // Thread indices and timestamps are not truncated.
+  {
+    ::sw::utest::detail::record_formatter<> out, payload;
+    const auto site = ::sw::utest::detail::check_site{"F", 1, ::sw::utest::detail::check_kind::pass, nullptr, nullptr};
+    const auto time_us = (uint64_t(1) << 40) + 5u;
+    {
+      binary_log::encoder enc(out.buf(), payload, site, 1u, nullptr, 70000u, time_us);
+      enc.add("value ");
+      enc.add(::sw::utest::detail::operand_ref::of(-(int64_t(1) << 40)));
+      enc.add(::sw::utest::detail::operand_ref::of(0.25f));
+      enc.finish(0);
+    }
+    auto bin = string();
+    {
+      ::sw::utest::detail::record_formatter<> magic;
+      binary_log::append_magic(magic.buf(), 1u, 0u);
+      bin.assign(magic.buf().data(), magic.buf().size());
+    }
+    bin.append(out.buf().data(), out.buf().size());
+    auto is = stringstream(bin);
+    auto rec = binary_log::record();
+    auto last_thread = uint64_t(0), last_time = uint64_t(0);
+    while(binary_log::read(is, rec)) { last_thread = rec.thread; last_time = rec.time_us; }
+    test_expect_eq(last_thread, 70000u);
+    test_expect_eq(last_time, time_us);
+    test_expect_eq(decoded(bin), "[pass] [@F:1] value -1099511627776" "0.25\n");
+  }
+
+  // Filters: results, file, line.
+  {
+    const auto bin = run_inner(test::report_binary, [](){ log_records(2); });
+    auto sel = binary_log::filter();
+    sel.results = 1u << 1;
+    const auto fails = decoded(bin, sel);
+    test_expect_eq(count_of(fails, "\n"), 2u);
+    test_expect_eq(count_of(fails, "[fail] [@" __FILE__ ":"), 2u);
+    sel.results = 0x3f;
+    sel.file = "F";
+    sel.line = 2;
+    test_expect_eq(decoded(bin, sel), "[pass] [@F:2] explicit, other site at the same address\n");
+    sel = binary_log::filter();
+    sel.results = 1u << 5;
+    test_expect_eq(decoded(bin, sel), "[FAIL] 2 of 8 checks failed, 1 warnings.\n");
+  }
+
+  // Invalid and truncated logs.
+  {
+    const auto bin = run_inner(test::report_binary, [](){ log_records(1); });
+    auto ok = true;
+    decoded(bin.substr(0, bin.size()-3), binary_log::filter(), &ok);
+    test_expect(!ok);
+    decoded("[pass] [@F:1] text log\n", binary_log::filter(), &ok);
+    test_expect(!ok);
+    decoded(bin, binary_log::filter(), &ok);
+    test_expect(ok);
+  }
+
+  // Threads and captured parallel test cases: each capture describes its sites.
+  {
+    const auto bin = run_inner(test::report_binary, []() {
+      auto threads = vector<thread>();
+      for(int t = 0; t < 4; ++t) { threads.emplace_back([](){ log_records(100); }); }
+      for(auto& th: threads) th.join();
+      auto entries = vector<cases::entry>();
+      for(int i = 0; i < 8; ++i) { entries.push_back(cases::entry{"case", "inner.cc", 10+i, &case_body}); }
+      cases::run(entries, 4);
+    });
+    auto ok = false;
+    const auto dec = decoded(bin, binary_log::filter(), &ok);
+    test_expect(ok);
+    test_expect_eq(count_of(dec, "[pass] [@" __FILE__), 4u * 102u + 8u * 10u);
+    test_expect_eq(count_of(dec, "] case 'case': passed (10 checks, 0 warnings, "), 8u);
+    test_expect(dec.find("[FAIL] 8 of 504 checks failed, 4 warnings.") != string::npos);
+    if(!ok) { test_info("Decoded:\n", dec); }
+  }
+
+  // Log volume of pass records.
+  {
+    const auto text = run_inner(test::report_text, [](){ log_records(10000); });
+    const auto bin = run_inner(test::report_binary, [](){ log_records(10000); });
+    test_info("10000 passes: text ", text.size(), " bytes, binary ", bin.size(), " bytes (", double(text.size()) / double(bin.size()), "x)");
+    test_expect_lt(bin.size() * 3, text.size());
+    test_expect(decoded(bin) == text);
+  }
+}
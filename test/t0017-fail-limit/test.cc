@@ -0,0 +1,145 @@
+/**
+ * @test fail-limit
+ *
+ * Checks the per-site fail log limit: Fails beyond the limit are counted
+ * but not logged, the summary lists the fail counts and the first and last
+ * failing messages per site, several threads share the site counts (also
+ * merged from running threads), `reset()` as well as limit 0 restore
+ * logging of all fails, and malformed limit arguments are rejected.
+ */
+#include <testenv.hh>
+#include <sstream>
+#include <thread>
+#include <atomic>
+
+using namespace std;
+
+namespace {
+
+  // Fails `n` times at one site, twice at another, passes once.
+  void fail_loop(int n)
+  {
+    auto v = vector<int>(size_t(n));
+    for(int i = 0; i < n; ++i) { v[size_t(i)] = i + 1; }
+    for(int i = 0; i < n; ++i) { test_expect_eq(v[size_t(i)], i); }
+    for(int i = 0; i < 2; ++i) { test_expect(i < 0); }
+    test_expect_eq(n, n);
+  }
+
+  // Runs `fn` with the given fail log limit, returns the log.
+  template <typename Fn>
+  string run_inner(unsigned limit, Fn fn)
+  {
+    using namespace ::sw::utest;
+    const auto was_ansi = test::ansi_colors();
+    const auto was_omit = test::omit_pass_log();
+    const auto was_limit = test::fail_log_limit();
+    auto os = stringstream();
+    {
+      const auto restore = teststream_restore();
+      test::ansi_colors(false);
+      test::omit_pass_log(true);
+      test::fail_log_limit(limit);
+      test::stream(os);
+      test::reset();
+      fn();
+      test::summary();
+      test::reset();
+    }
+    test::ansi_colors(was_ansi);
+    test::omit_pass_log(was_omit);
+    test::fail_log_limit(was_limit);
+    return os.str();
+  }
+
+  size_t count_of(const string& s, const string& what)
+  {
+    auto n = size_t(0);
+    for(auto p = s.find(what); p != string::npos; p = s.find(what, p+1)) ++n;
+    return n;
+  }
+
+  bool contains(const string& s, const string& what)
+  { return s.find(what) != string::npos; }
+
+}
+
+void test(const vector<string>& args)
+{
+  using namespace ::sw::utest;
+  (void)args;
+
+  // Limited: three fails per site logged, the rest summarized.
+  {
+    const auto log = run_inner(3, [](){ fail_loop(1000); });
+    test_expect_eq(count_of(log, "[fail] "), 3u + 2u);
+    test_expect(contains(log, "[info] Fails per check site (997 not logged, limit 3 per site):\n"));
+    test_expect(contains(log, " 1000 fails (997 not logged), first: v[size_t(i)] == i   (1 != 0), last: v[size_t(i)] == i   (1000 != 999)\n"));
+    test_expect(contains(log, " 2 fails, first: i < 0"));
+    test_expect(contains(log, "[FAIL] 1002 of 1003 checks failed, 0 warnings."));
+    test_expect_lt(log.find("Fails per check site"), log.find("[FAIL] "));
+    test_info("Limited log:\n", log);
+  }
+
+  // No table when all fails were logged.
+  {
+    const auto log = run_inner(3, [](){ fail_loop(2); });
+    test_expect_eq(count_of(log, "[fail] "), 4u);
+    test_expect(!contains(log, "Fails per check site"));
+  }
+
+  // Unlimited: every fail is logged.
+  {
+    const auto log = run_inner(0, [](){ fail_loop(100); });
+    test_expect_eq(count_of(log, "[fail] "), 102u);
+    test_expect(!contains(log, "Fails per check site"));
+  }
+
+  // Fails beyond the limit counted in the threads are merged for the summary,
+  // also of threads that are still running.
+  {
+    const auto log = run_inner(5, []() {
+      auto threads = vector<thread>();
+      for(int t = 0; t < 4; ++t) { threads.emplace_back([](){ fail_loop(100); }); }
+      for(auto& th: threads) th.join();
+      atomic<bool> done(false), stop(false);
+      auto running = thread([&](){ fail_loop(50); done = true; while(!stop) { this_thread::yield(); } });
+      while(!done) { this_thread::yield(); }
+      test::summary();
+      stop = true;
+      running.join();
+    });
+    test_expect(contains(log, " 450 fails (445 not logged), first: v[size_t(i)] == i   (1 != 0), last: v[size_t(i)] == i   (50 != 49)\n"));
+    test_expect(contains(log, " 10 fails (5 not logged), first: i < 0, last: i < 0\n"));
+  }
+
+  // Threads share the site counts, `reset()` restarts the counts.
+  {
+    const auto log = run_inner(5, []() {
+      auto threads = vector<thread>();
+      for(int t = 0; t < 4; ++t) { threads.emplace_back([](){ fail_loop(100); }); }
+      for(auto& th: threads) th.join();
+      test::reset();
+      fail_loop(10);
+    });
+    test_expect_eq(count_of(log, "[fail] "), 5u + 5u + 5u + 2u);
+    test_expect(contains(log, " 10 fails (5 not logged), first: "));
+    test_expect(!contains(log, " 400 fails"));
+  }
+
+  // Limit argument (`--fail-log-limit=N`).
+  {
+    using args = ::sw::utest::detail::test_case_args<>;
+    auto limit = 7u;
+    test_expect(args::parse_fail_log_limit("3", limit));
+    test_expect_eq(limit, 3u);
+    test_expect(args::parse_fail_log_limit("0", limit));
+    test_expect_eq(limit, 0u);
+    test_expect(args::parse_fail_log_limit("4294967295", limit));
+    test_expect_eq(limit, 4294967295u);
+    for(const auto text: {"", "abc", "-1", "+1", " 1", "1x", "4294967296", "99999999999999999999"}) {
+      test_expect(!args::parse_fail_log_limit(text, limit));
+    }
+    test_expect_eq(limit, 4294967295u);
+  }
+}
@@ -0,0 +1,180 @@
+/**
+ * @test sections
+ *
+ * Checks timed `test_section()` scopes: Wall and CPU time, checks and fails
+ * per section, nesting paths, accumulation of repeated runs, sections left
+ * by exceptions, sections as unbraced statements (`if`/`else`, `break`),
+ * and the slowest-sections report of the summary.
+ */
+#include <testenv.hh>
+#include <sstream>
+#include <thread>
+#include <chrono>
+
+using namespace std;
+using sections = ::sw::utest::detail::test_sections<>;
+
+namespace {
+
+  volatile unsigned sink = 0;
+
+  void spin_ms(int ms)
+  {
+    const auto end = chrono::steady_clock::now() + chrono::milliseconds(ms);
+    while(chrono::steady_clock::now() < end) { sink = sink + 1; }
+  }
+
+  void sectioned(int runs)
+  {
+    test_section("outer") {
+      for(int i = 0; i < runs; ++i) {
+        test_section("sleep") {
+          this_thread::sleep_for(chrono::milliseconds(20));
+          test_expect_eq(i, i);
+        }
+      }
+      test_section("spin") {
+        spin_ms(30);
+        test_expect_eq(runs, 0);
+        test_expect_ne(runs, 0);
+      }
+    }
+  }
+
+  // Runs `fn` with the given section report limit, returns the log.
+  template <typename Fn>
+  string run_inner(unsigned limit, Fn fn)
+  {
+    using namespace ::sw::utest;
+    const auto was_ansi = test::ansi_colors();
+    const auto was_omit = test::omit_pass_log();
+    const auto was_limit = test::section_report_limit();
+    auto os = stringstream();
+    {
+      const auto restore = teststream_restore();
+      test::ansi_colors(false);
+      test::omit_pass_log(true);
+      test::section_report_limit(limit);
+      test::stream(os);
+      test::reset();
+      fn();
+      test::summary();
+      test::reset();
+    }
+    test::ansi_colors(was_ansi);
+    test::omit_pass_log(was_omit);
+    test::section_report_limit(was_limit);
+    return os.str();
+  }
+
+  const sections::entry* find(const vector<sections::entry>& entries, const string& path)
+  {
+    for(const auto& e: entries) { if(e.path == path) return &e; }
+    return nullptr;
+  }
+
+  bool contains(const string& s, const string& what)
+  { return s.find(what) != string::npos; }
+
+}
+
+void test(const vector<string>& args)
+{
+  using namespace ::sw::utest;
+  (void)args;
+
+  // Timing, counts, and nesting paths.
+  {
+    auto entries = vector<sections::entry>();
+    run_inner(0, [&entries]() {
+      sectioned(3);
+      entries = sections::slowest(10);
+    });
+    test_expect_eq(entries.size(), 3u);
+    const auto outer = find(entries, "outer");
+    const auto sleep = find(entries, "outer/sleep");
+    const auto spin = find(entries, "outer/spin");
+    test_expect(outer && sleep && spin);
+    if(outer && sleep && spin) {
+      test_expect_eq(entries.front().path, "outer");
+      test_expect_eq(outer->runs, 1u);
+      test_expect_eq(sleep->runs, 3u);
+      test_expect_eq(spin->runs, 1u);
+      test_expect_ge(sleep->wall_ms, 60.0);
+      test_expect_ge(spin->wall_ms, 30.0);
+      test_expect_ge(outer->wall_ms, sleep->wall_ms + spin->wall_ms);
+      test_expect_lt(sleep->cpu_ms, sleep->wall_ms / 2);
+      test_expect_gt(spin->cpu_ms, 0.0);
+      test_expect_eq(sleep->checks, 3u);
+      test_expect_eq(sleep->fails, 0u);
+      test_expect_eq(spin->checks, 2u);
+      test_expect_eq(spin->fails, 1u);
+      test_expect_eq(outer->checks, 5u);
+      test_expect_eq(outer->fails, 1u);
+      test_expect_eq(string(sleep->file), string(__FILE__));
+      test_expect_gt(sleep->line, outer->line);
+    }
+  }
+
+  // Sections left by exceptions are recorded, threads have own nesting.
+  {
+    auto entries = vector<sections::entry>();
+    run_inner(0, [&entries]() {
+      try {
+        test_section("throws") { throw std::runtime_error("leaving"); }
+      } catch(const std::exception&) {
+        ;
+      }
+      test_section("main") {
+        auto th = thread([](){ test_section("worker") { test_expect(true); } });
+        th.join();
+      }
+      entries = sections::slowest(10);
+    });
+    test_expect(find(entries, "throws") != nullptr);
+    test_expect(find(entries, "main") != nullptr);
+    test_expect(find(entries, "worker") != nullptr);
+    test_expect(find(entries, "main/worker") == nullptr);
+    if(find(entries, "main")) { test_expect_eq(find(entries, "main")->checks, 0u); }
+  }
+
+  // Unbraced statements: The `else` binds to the user's `if`, `break` leaves the section.
+  {
+    auto entries = vector<sections::entry>();
+    auto branch = string();
+    auto steps = 0;
+    run_inner(0, [&]() {
+      const auto enter = (args.size() > 1000);
+      if(enter) test_section("if") { branch = "if"; } else { branch = "else"; }
+      if(!enter) test_section("then") { branch += "+then"; } else { branch += "+else"; }
+      test_section("loop") {
+        for(;;) { ++steps; break; }
+        ++steps;
+        break;
+        ++steps;
+      }
+      entries = sections::slowest(10);
+    });
+    test_expect_eq(branch, "else+then");
+    test_expect_eq(steps, 2);
+    test_expect(find(entries, "if") == nullptr);
+    test_expect(find(entries, "then") != nullptr);
+    test_expect(find(entries, "loop") != nullptr);
+  }
+
+  // Summary report: slowest first, limited, disabled with limit 0.
+  {
+    const auto log = run_inner(2, [](){ sectioned(1); });
+    test_expect(contains(log, "[info] Slowest test sections (of "));
+    test_expect(contains(log, "] outer: "));
+    test_expect(contains(log, "] outer/spin: "));
+    test_expect(!contains(log, "] outer/sleep: "));
+    test_expect(contains(log, "%), cpu "));
+    test_expect(contains(log, "ms, 1 runs, 2 checks, 1 fails\n"));
+    test_expect_lt(log.find("] outer: "), log.find("] outer/spin: "));
+    test_expect_lt(log.find("Slowest test sections"), log.find("[FAIL] "));
+    test_expect(!contains(run_inner(0, [](){ sectioned(1); }), "Slowest test sections"));
+    test_expect(!contains(run_inner(10, [](){ test_expect(true); }), "Slowest test sections"));
+    test_info("Section report:\n", log);
+  }
+}
@@ -0,0 +1,85 @@
+/**
+ * @test operand-format
+ *
+ * Checks the logged operands of the comparison checks, which are passed
+ * as type-erased references to the logging code: Builtin types, strings
+ * and character arrays, volatile operands, and user types with own
+ * `operator<<()`.
+ */
+#include <testenv.hh>
+#include <sstream>
+
+using namespace std;
+
+struct point
+{
+  int x, y;
+  bool operator==(const point& o) const noexcept { return (x == o.x) && (y == o.y); }
+  bool operator!=(const point& o) const noexcept { return !(*this == o); }
+};
+
+std::ostream& operator<<(std::ostream& os, const point& p)
+{ return os << "point(" << p.x << "," << p.y << ")"; }
+
+namespace {
+
+  // Runs `fn` with pass logging, returns the log.
+  template <typename Fn>
+  string run_inner(Fn fn)
+  {
+    using namespace ::sw::utest;
+    const auto was_ansi = test::ansi_colors();
+    const auto was_omit = test::omit_pass_log();
+    auto os = stringstream();
+    {
+      const auto restore = teststream_restore();
+      test::ansi_colors(false);
+      test::omit_pass_log(false);
+      test::stream(os);
+      test::reset();
+      fn();
+      test::reset();
+    }
+    test::ansi_colors(was_ansi);
+    test::omit_pass_log(was_omit);
+    return os.str();
+  }
+
+  bool contains(const string& s, const string& what)
+  { return s.find(what) != string::npos; }
+
+}
+
+void test(const vector<string>& args)
+{
+  using namespace ::sw::utest;
+  (void)args;
+
+  const auto log = run_inner([]() {
+    const int i = 42;
+    const double d = 0.5;
+    const char c = 'x';
+    const string s = "text";
+    const char arr[] = "chars";
+    volatile int v = 7;
+    const point p{1, 2}, q{3, 4};
+    test_expect_eq(i, 42);
+    test_expect_ne(d, 1.5);
+    test_expect_lt(c, 'y');
+    test_expect_eq(s, "text");
+    test_expect_eq(string(arr), arr);
+    test_expect_ge(v, 7);
+    test_expect_eq(p, q);
+    test_expect_ne(p, q);
+  });
+  test_expect(contains(log, "] i == 42   (=42)\n"));
+  test_expect(contains(log, "] d != 1.5   (0.5 != 1.5)\n"));
+  test_expect(contains(log, "] c < 'y'   (x < y)\n"));
+  test_expect(contains(log, "] s == \"text\"   (=text)\n"));
+  test_expect(contains(log, "] string(arr) == arr   (=chars)\n"));
+  test_expect(contains(log, "] v >= 7   (7 >= 7)\n"));
+  test_expect(contains(log, "[fail] [@" __FILE__ ":"));
+  test_expect(contains(log, "] p == q   (point(1,2) != point(3,4))\n"));
+  test_expect(contains(log, "] p != q   (point(1,2) != point(3,4))\n"));
+  test_info("Log:\n", log);
+}
@@ -0,0 +1,76 @@
+/**
+ * @test isolation-async-log
+ *
+ * Checks the fork-isolated execution of test cases with the asynchronous
+ * logging backend: The writer thread is joined before the first fork, so
+ * that no child inherits a held consumer lock and blocks in its flush.
+ */
+#define WITH_MICROTEST_CASES
+#define WITH_MICROTEST_ASYNC_LOG
+#include <testenv.hh>
+#include <sstream>
+#include <fstream>
+#include <dirent.h>
+
+using namespace std;
+using cases = ::sw::utest::detail::test_cases<>;
+
+namespace {
+
+  void case_log()
+  {
+    for(int i=0; i<10; ++i) test_expect_eq(i, i);
+    test_info("case record");
+  }
+
+  // Number of threads of the process (Linux), 0 if unknown.
+  unsigned num_threads()
+  {
+    auto n = 0u;
+    DIR* const dir = ::opendir("/proc/self/task");
+    if(!dir) return 0;
+    for(const struct ::dirent* e=::readdir(dir); e; e=::readdir(dir)) {
+      if(e->d_name[0] != '.') ++n;
+    }
+    ::closedir(dir);
+    return n;
+  }
+
+}
+
+void test(const vector<string>& args)
+{
+  (void)args;
+  constexpr auto num_cases = 64u;
+  test_expect(::sw::utest::test::async_log());
+  auto entries = vector<cases::entry>();
+  for(auto i=0u; i<num_cases; ++i) entries.push_back(cases::entry{"log", "inner.cc", int(i), &case_log});
+  uint64_t checks=0, fails=0;
+  unsigned threads_before=0, threads_after=0;
+  const auto was_ansi = ::sw::utest::test::ansi_colors();
+  auto os = stringstream();
+  {
+    const auto restore = teststream_restore();
+    ::sw::utest::test::ansi_colors(false);
+    ::sw::utest::test::stream(os);
+    // Keep the writer thread busy until the isolated run switches async logging off.
+    for(int i=0; i<1000; ++i) test_info("async record ", i);
+    threads_before = num_threads();
+    ::sw::utest::test::reset();
+    cases::run_isolated(entries, 4, 10.0);
+    threads_after = num_threads();
+    checks = ::sw::utest::test::num_checks();
+    fails = ::sw::utest::test::num_fails();
+    ::sw::utest::test::reset();
+  }
+  ::sw::utest::test::ansi_colors(was_ansi);
+  const auto log = os.str();
+  test_expect(!::sw::utest::test::async_log());
+  test_expect_eq(fails, 0u);
+  test_expect_eq(checks, uint64_t(num_cases * 10));
+  test_expect(log.find("Timeout") == string::npos);
+  test_expect(log.find("] async record 999") != string::npos);
+  test_expect(log.find("] async record 999") < log.find("case record"));
+  if(threads_before) test_expect_eq(threads_after + 1, threads_before);
+  if(fails) test_info("Log:\n", log);
+}
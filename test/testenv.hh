@@ -4,7 +4,23 @@
 #define WITH_MICROTEST_GENERATORS /* opt-in: sequence and container generation functions */
 // #define WITH_MICROTEST_ANSI_COLORS  /* opt-in: ANSI coloring for console/TTY out streams */
 // #define WITHOUT_MICROTEST_RANDOM    /* opt-out: No utest::random() functions */
+// #define WITH_MICROTEST_CASES        /* opt-in: test_case() registration, parallel and isolated runners */
+// #define WITH_MICROTEST_BENCHMARK    /* opt-in: test_benchmark() microbenchmarks */
+// #define WITH_MICROTEST_ALLOC_TRACKING /* opt-in: Counting heap allocations (replaces operator new/delete) */
+// #define WITH_MICROTEST_PERF_COUNTERS  /* opt-in: perf_event_open() based performance counters (Linux) */
+// #define WITH_MICROTEST_ASYNC_LOG    /* opt-in: Asynchronous logging via per-thread ring buffers */
 // #define WITH_MICROTEST_TMPDIR       /* opt-in: !experimental! Temporary directory creation and handling */
 // #define WITH_MICROTEST_TMPFILE      /* opt-in: !experimental1 Temporary file creation and handling */
 #include <test/microtest/include/microtest.hh>
+
+// Guard for tests redirecting the output: Switches to text records, and
+// restores the default output stream and the reporter falling out of scope.
+struct teststream_restore
+{
+  const ::sw::utest::test::reporter_type reporter = ::sw::utest::test::reporter();
+
+  teststream_restore() noexcept { ::sw::utest::test::reporter(::sw::utest::test::report_text); }
+
+  ~teststream_restore() noexcept { ::sw::utest::test::default_stream(); ::sw::utest::test::reporter(reporter); }
+};
 #endif
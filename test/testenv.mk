@@ -10,14 +10,49 @@
 #---------------------------------------------------------------------------------------------------
 MAKEFLAGS+= --no-print-directory
 MICROTEST_ROOT=./test/microtest/include
+MICROTEST_TOOLS=./test/microtest/tools
 
 # Test selection
+comma:=,
 wildcardr=$(foreach d,$(wildcard $1*),$(call wildcardr,$d/,$2) $(filter $(subst *,%,$2),$d))
 
 TEST_SELECTION:=$(sort $(wildcard test/*$(TEST)*/))
+
+# Sharding across machines (`make test SHARD=2/4`, 1-based): The test directories are
+# assigned to the shards by a stable hash (cksum) of their names. The shard summaries
+# (`summary.shard-<i>-of-<n>.log`) are combined with `make test-merge`.
+ifneq ($(SHARD),)
+ SHARD_INDEX:=$(word 1,$(subst /, ,$(SHARD)))
+ SHARD_COUNT:=$(word 2,$(subst /, ,$(SHARD)))
+ ifneq ($(words $(subst /, ,$(SHARD)))$(shell [ "$(SHARD_INDEX)" -ge 1 ] 2>/dev/null && [ "$(SHARD_INDEX)" -le "$(SHARD_COUNT)" ] 2>/dev/null && echo ok),2ok)
+  $(error SHARD must be <index>/<count> with 1 <= index <= count, e.g. SHARD=1/4)
+ endif
+ TEST_SELECTION:=$(shell for d in $(TEST_SELECTION); do h=$$(basename "$$d" | tr -d '\n' | cksum | cut -d' ' -f1); [ $$((h % $(SHARD_COUNT) + 1)) -eq $(SHARD_INDEX) ] && echo "$$d"; done)
+ TEST_SUMMARY=$(BUILDDIR)/test/summary.shard-$(SHARD_INDEX)-of-$(SHARD_COUNT).log
+else
+ TEST_SUMMARY=$(BUILDDIR)/test/summary.log
+endif
 TEST_BINARIES_SOURCES:=$(foreach F, $(filter test/%/ , $(TEST_SELECTION)), $Ftest.cc)
 TEST_BINARIES:=$(patsubst %.cc,$(BUILDDIR)/%$(BINARY_EXTENSION),$(TEST_BINARIES_SOURCES))
 TEST_BINARIES_RESULTS:=$(patsubst %.cc,$(BUILDDIR)/%.log,$(TEST_BINARIES_SOURCES))
+TOOLS_BINARIES=$(patsubst $(MICROTEST_TOOLS)/%.cc,$(BUILDDIR)/tools/%$(BINARY_EXTENSION),$(wildcard $(MICROTEST_TOOLS)/*.cc))
+
+# Benchmark baselines (`test/<name>/benchmark.baseline`) are read from the test
+# source directory, and rewritten with `make test UPDATE_BASELINES=1`.
+TEST_RUN_ENV=MICROTEST_BASELINE_DIR="$(CURDIR)/test/$*"
+ifneq ($(UPDATE_BASELINES),)
+ TEST_RUN_ENV+=MICROTEST_UPDATE_BASELINES=1
+endif
+
+# Structured test logs (`make test REPORTER=jsonl|junit|tap|binary`), written to
+# the `test.log` files instead of the text records. Binary logs are rendered with
+# `$(BUILDDIR)/tools/binlog-decode$(BINARY_EXTENSION) <test.log>`.
+ifneq ($(REPORTER),)
+ ifeq ($(filter text jsonl junit tap binary,$(REPORTER)),)
+  $(error REPORTER must be one of text, jsonl, junit, tap, binary)
+ endif
+ TEST_RUN_ENV+=MICROTEST_REPORTER=$(REPORTER)
+endif
 
 # g++ pedantic test run options.
 ifneq (,$(findstring g++,$(CXX)))
@@ -38,10 +73,36 @@ ifneq (,$(findstring clang++,$(CXX)))
  endif
 endif
 
+# g++ precompiled test environment header: `test/testenv.hh` (with `microtest.hh` and the
+# standard headers) is compiled once per compiler, flag set (directory named by the flags
+# checksum), and switch set, and found by the test compilations before `test/testenv.hh`.
+# The switches of a test are the `#define`s before its `#include <testenv.hh>`, collected
+# in `TEST_SWITCHES_<test>` and defined for the header compilation (`-D<switch>=`, same as
+# `#define <switch>`). The headers are rebuilt in place when the SCM commit changes. A failed
+# header compilation fails the test run, and `-Winvalid-pch` reports `.gch` files that cannot
+# be used (`make test WITHOUT_PCH=1` switches the precompiled header off).
+ifneq (,$(findstring g++,$(CXX)))
+ ifeq ($(WITHOUT_PCH)$(WITH_COVERAGE),)
+  TEST_PCH_FLAGS=$(FLAGSCXX) -I. -I./test $(filter-out -l% -Wl$(comma)%,$(FLAGSLD) $(LDSTATIC) $(LIBS)) $(TESTOPTS) $(OPTS)
+  TEST_PCH_DIR:=$(BUILDDIR)/pch/$(firstword $(shell echo '$(CXX) $(subst ','',$(TEST_PCH_FLAGS))' | cksum))
+  TEST_PCH_SCM=$(TEST_PCH_DIR)/scm-commit
+ endif
+endif
+empty:=
+space:=$(empty) $(empty)
+test_scan=$(shell sed -n -e '/^\#include <testenv.hh>/{s/.*/testenv.hh/p;q;}' -e 's/^\#define \([A-Za-z0-9_]*MICROTEST[A-Za-z0-9_]*\)[[:space:]]*$$/\1/p' test/$1/test.cc 2>/dev/null)
+test_pch=$(if $(TEST_PCH_DIR),$(if $(filter testenv.hh,$(TEST_SCAN_$1)),$(TEST_PCH_DIR)/$(or $(subst $(space),+,$(TEST_SWITCHES_$1)),default)/testenv.hh.gch))
+define test_switch_vars
+ TEST_SCAN_$1:=$$(call test_scan,$1)
+ TEST_SWITCHES_$1:=$$(sort $$(filter-out testenv.hh,$$(TEST_SCAN_$1)))
+endef
+$(foreach t,$(patsubst test/%/test.cc,%,$(TEST_BINARIES_SOURCES)),$(eval $(call test_switch_vars,$t)))
+TEST_PCH=$(sort $(foreach t,$(patsubst test/%/test.cc,%,$(TEST_BINARIES_SOURCES)),$(call test_pch,$t)))
+
 #---------------------------------------------------------------------------------------------------
 # Tests
 #---------------------------------------------------------------------------------------------------
-.PHONY: test test-clean test-results
+.PHONY: test test-clean test-results test-merge tools
 .PRECIOUS: %.log %.elf %.exe
 
 # test-clean only removes the test build and result directory,
@@ -53,12 +114,12 @@ test-clean:
 # that are available on linux and windows (with GIT) are the tools of choice).
 test: $(TEST_BINARIES_SOURCES)
 	@mkdir -p $(BUILDDIR)/test
-	@rm -f $(BUILDDIR)/test/*.log
- ifneq ($(TEST),)
+	@rm -f $(filter-out $(BUILDDIR)/test/summary.shard-%,$(wildcard $(BUILDDIR)/test/*.log)) $(TEST_SUMMARY)
+ ifneq ($(TEST)$(UPDATE_BASELINES),)
 	@rm -f $(TEST_BINARIES_RESULTS)
  endif
-	@$(MAKE) -j -k test-results | tee $(BUILDDIR)/test/summary.log 2>&1
-	@if grep -e '^\[fail\]' -- $(BUILDDIR)/test/summary.log >/dev/null 2>&1; then echo "[FAIL] Total verdict: At least one test failed."; /bin/false; else echo "[PASS] Total verdict: All tests passed."; fi
+	@$(MAKE) -j -k test-results | tee $(TEST_SUMMARY) 2>&1
+	@if grep -e '^\[fail\]' -- $(TEST_SUMMARY) >/dev/null 2>&1; then echo "[FAIL] Total verdict: At least one test failed."; /bin/false; else echo "[PASS] Total verdict: All tests passed."; fi
  ifneq ($(TEST)$(PRINT_RESULTS),)
   ifneq ($(TEST_BINARIES_RESULTS),)
 	-@echo "[----] Test detail listing:"
@@ -67,30 +128,131 @@ test: $(TEST_BINARIES_SOURCES)
   endif
  endif
 
+# Combined verdict of the shard summaries of all machines, collected in
+# `$(BUILDDIR)/test/` or given with `SHARD_RESULTS="<files>"`. Missing shards fail.
+SHARD_RESULTS=$(wildcard $(BUILDDIR)/test/summary.shard-*-of-*.log)
+test-merge:
+	@mkdir -p $(BUILDDIR)/test
+	@if [ -z "$(strip $(SHARD_RESULTS))" ]; then echo "[fail] No shard summaries found." > $(BUILDDIR)/test/summary.log; else \
+	  cat $(SHARD_RESULTS) > $(BUILDDIR)/test/summary.log.tmp; \
+	  for f in $(SHARD_RESULTS); do basename "$$f" | sed -n 's/^summary\.shard-\([0-9]*\)-of-\([0-9]*\)\.log$$/\1 \2/p'; done | sort -n | uniq > $(BUILDDIR)/test/shards.tmp; \
+	  n=$$(cut -d' ' -f2 $(BUILDDIR)/test/shards.tmp | sort -u); \
+	  if [ $$(echo "$$n" | wc -l) -ne 1 ]; then echo "[fail] Shard summaries of different shard counts: $$(echo $$n)" >> $(BUILDDIR)/test/summary.log.tmp; else \
+	    i=1; while [ $$i -le $$n ]; do grep -q "^$$i $$n$$" $(BUILDDIR)/test/shards.tmp || echo "[fail] Missing summary of shard $$i/$$n" >> $(BUILDDIR)/test/summary.log.tmp; i=$$((i+1)); done; \
+	  fi; \
+	  mv -f $(BUILDDIR)/test/summary.log.tmp $(BUILDDIR)/test/summary.log; rm -f $(BUILDDIR)/test/shards.tmp; \
+	fi
+	@cat $(BUILDDIR)/test/summary.log
+	@if grep -e '^\[fail\]' -- $(BUILDDIR)/test/summary.log >/dev/null 2>&1; then echo "[FAIL] Total verdict: At least one test failed."; /bin/false; else echo "[PASS] Total verdict: All tests passed."; fi
+
 # Actual test compilations and runs, done in parallel if
 # `make -j` is specified.
-test-results: $(TEST_BINARIES) $(TEST_BINARIES_RESULTS)
+test-results: $(TEST_BINARIES) $(TEST_BINARIES_RESULTS) $(TOOLS_BINARIES)
+
+# Tools of the test harness (`test/microtest/tools/*.cc`, e.g. the binary log decoder).
+tools: $(TOOLS_BINARIES)
+
+$(BUILDDIR)/tools/%$(BINARY_EXTENSION): $(MICROTEST_TOOLS)/%.cc $(MICROTEST_ROOT)/microtest.hh
+	@echo "[c++ ] $@"
+	@mkdir -p $(dir $@)
+	@$(CXX) -o $@ $< $(FLAGSCXX) -I$(MICROTEST_ROOT) $(FLAGSLD) $(LDSTATIC) $(LIBS) $(OPTS) || echo "[fail] $@"
+
+# Precompiled test environment headers (g++), one per switch set (`default` or `<switch>+...`).
+ifneq ($(TEST_PCH_DIR),)
+.PHONY: test-pch-scm
+test-pch-scm:
+	@mkdir -p $(TEST_PCH_DIR)
+	@[ "$$(cat $(TEST_PCH_SCM) 2>/dev/null)" = "$(SCM_COMMIT)" ] || echo "$(SCM_COMMIT)" > $(TEST_PCH_SCM)
+
+$(TEST_PCH_SCM): test-pch-scm ;
+
+.PRECIOUS: $(TEST_PCH_DIR)/%/testenv.hh.gch
+
+$(TEST_PCH_DIR)/%/testenv.hh.gch: test/testenv.hh $(MICROTEST_ROOT)/microtest.hh $(HEADER_DEPS) $(TEST_PCH_SCM)
+	@echo "[pch ] $@"
+	@mkdir -p $(dir $@)
+	@$(CXX) -x c++-header -o $@ $< $(TEST_PCH_FLAGS) $(foreach s,$(filter-out default,$(subst +, ,$*)),-D$s=) -DSCM_COMMIT='"""$(SCM_COMMIT)"""' || { echo "[fail] $@"; rm -f $@; exit 1; }
+endif
 
 # Test binaries (compile)
-$(BUILDDIR)/test/%/test$(BINARY_EXTENSION): test/%/test.cc test/testenv.hh $(MICROTEST_ROOT)/microtest.hh $(HEADER_DEPS)
+.SECONDEXPANSION:
+$(BUILDDIR)/test/%/test$(BINARY_EXTENSION): test/%/test.cc test/testenv.hh $(MICROTEST_ROOT)/microtest.hh $(HEADER_DEPS) $$(call test_pch,$$*)
 	@echo "[c++ ] $@"
 	@mkdir -p $(dir $@)
 	@cp -rf $(dir $<)/* $(dir $@)/
-	@$(CXX) -o $@ $< $(FLAGSCXX) -I. -I./test $(FLAGSLD) $(LDSTATIC) $(LIBS) $(TESTOPTS) $(OPTS) -DSCM_COMMIT='"""$(SCM_COMMIT)"""' || echo "[fail] $@"
+	@$(CXX) -o $@ $< $(FLAGSCXX) $(if $(call test_pch,$*),-I$(dir $(call test_pch,$*)) -Winvalid-pch) -I. -I./test $(FLAGSLD) $(LDSTATIC) $(LIBS) $(TESTOPTS) $(OPTS) -DSCM_COMMIT='"""$(SCM_COMMIT)"""' || echo "[fail] $@"
 	@rm -f $(dir $@)/test.cc || /bin/true
 	@[ -f test.gcno ] && mv test.gcno $(dir $@) || /bin/true
 
-# Test runs
-$(BUILDDIR)/test/%/test.log: $(BUILDDIR)/test/%/test$(BINARY_EXTENSION)
+# Test runs (re-run also when the benchmark baseline changed)
+$(BUILDDIR)/test/%/test.log: $(BUILDDIR)/test/%/test$(BINARY_EXTENSION) $$(wildcard test/$$*/benchmark.baseline)
 	@mkdir -p $(dir $@)
 	@rm -f $@
  ifneq ($(OS),Windows_NT)
-	@cd $(dir $<) && ./$(notdir $<) $(ARGS) </dev/null >$(notdir $@) 2>&1 && echo "[pass] $@" || echo "[fail] $@"
+	@cd $(dir $<) && $(TEST_RUN_ENV) ./$(notdir $<) $(ARGS) </dev/null >$(notdir $@) 2>&1 && echo "[pass] $@" || echo "[fail] $@"
 	@[ -f test.gcda ] && mv test.gcda $(dir $@) || /bin/true
  else
-	@cd $(dir $<) && echo "" | "./$(notdir $<)" $(ARGS) >$(notdir $@) && echo "[pass] $@" || echo "[fail] $@"
+	@cd $(dir $<) && echo "" | $(TEST_RUN_ENV) "./$(notdir $<)" $(ARGS) >$(notdir $@) && echo "[pass] $@" || echo "[fail] $@"
  endif
 
+#---------------------------------------------------------------------------------------------------
+# Compile time benchmark of microtest.hh (POSIX)
+#---------------------------------------------------------------------------------------------------
+# `make bench-compile`: Synthetic test translation units with `BENCH_COMPILE_CHECKS` checks of
+# mixed operand types are compiled (sequentially) for each standard and switch set, each switch
+# alone and all together (`default`: none). Measured are the compile wall time (minimum of
+# `BENCH_COMPILE_RUNS`), the peak compiler memory, the object size, and the weak symbols of the
+# object (emitted template instantiations and inline functions). The rows are written to
+# `$(BUILDDIR)/bench-compile/results.txt`, and with the changes relative to `default` (same
+# standard and number of checks) to `comparison.txt`.
+.PHONY: bench-compile
+BENCH_COMPILE_DIR=$(BUILDDIR)/bench-compile
+BENCH_COMPILE_TOOL=$(BUILDDIR)/tools/bench-compile$(BINARY_EXTENSION)
+BENCH_COMPILE_CHECKS=10 1000 10000
+BENCH_COMPILE_STDS=c++11 c++17 c++20
+BENCH_COMPILE_RUNS=3
+BENCH_COMPILE_SWITCHES=WITH_MICROTEST_GENERATORS WITH_MICROTEST_CASES WITHOUT_MICROTEST_RANDOM WITH_MICROTEST_TMPFILE WITH_MICROTEST_ANSI_COLORS
+
+bench-compile: $(BENCH_COMPILE_TOOL)
+	@rm -rf $(BENCH_COMPILE_DIR)
+	@mkdir -p $(BENCH_COMPILE_DIR)
+	@$(BENCH_COMPILE_TOOL) --header > $(BENCH_COMPILE_DIR)/results.txt
+	@for std in $(BENCH_COMPILE_STDS); do \
+	  for sw in default $(BENCH_COMPILE_SWITCHES) all; do \
+	    case "$$sw" in default) defs="";; all) defs="$(addprefix -D,$(BENCH_COMPILE_SWITCHES))";; *) defs="-D$$sw";; esac; \
+	    for n in $(BENCH_COMPILE_CHECKS); do \
+	      $(BENCH_COMPILE_TOOL) --checks=$$n --dir=$(BENCH_COMPILE_DIR) --label="$$std $$sw" --runs=$(BENCH_COMPILE_RUNS) -- \
+	        $(CXX) $(filter-out -std=%,$(FLAGSCXX)) -std=$$std -I$(MICROTEST_ROOT) $$defs $(OPTS) >> $(BENCH_COMPILE_DIR)/results.txt; \
+	    done; \
+	  done; \
+	done
+	@awk '/^#/ { printf "%s %9s %9s %11s %12s\n", $$0, "wall", "peak", "object", "weak-symbols"; next } \
+	  { k=$$1" "$$3; if($$2=="default") { w[k]=$$4; m[k]=$$5; o[k]=$$6; s[k]=$$7 }; \
+	    printf "%s %+8.1f%% %+8.1f%% %+10.1f%% %+12d\n", $$0, (w[k]>0)?100*($$4/w[k]-1):0, (m[k]>0)?100*($$5/m[k]-1):0, (o[k]>0)?100*($$6/o[k]-1):0, $$7-s[k] }' \
+	  $(BENCH_COMPILE_DIR)/results.txt > $(BENCH_COMPILE_DIR)/comparison.txt
+	@cat $(BENCH_COMPILE_DIR)/comparison.txt
+
+#---------------------------------------------------------------------------------------------------
+# Runtime benchmark of the harness
+#---------------------------------------------------------------------------------------------------
+# `make bench-harness`: Checks per second of `test_expect`, `test_expect_silent`, `test_expect_eq`
+# (int, string, double), and `test_note`, with pass logging and ANSI colors on/off, output to a
+# `std::ostream` or a file descriptor, and with 1 to `BENCH_HARNESS_MAX_THREADS` threads. The rows
+# (stable whitespace separated columns, see `tools/bench-harness.cc`) are written to
+# `$(BUILDDIR)/bench-harness/results.txt`. Built with the test flags, e.g. `OPTS=-O2`.
+.PHONY: bench-harness
+BENCH_HARNESS_DIR=$(BUILDDIR)/bench-harness
+BENCH_HARNESS_TOOL=$(BUILDDIR)/tools/bench-harness$(BINARY_EXTENSION)
+BENCH_HARNESS_CHECKS=100000
+BENCH_HARNESS_MAX_THREADS=4
+BENCH_HARNESS_RUNS=3
+
+bench-harness: $(BENCH_HARNESS_TOOL)
+	@mkdir -p $(BENCH_HARNESS_DIR)
+	@$(BENCH_HARNESS_TOOL) --checks=$(BENCH_HARNESS_CHECKS) --max-threads=$(BENCH_HARNESS_MAX_THREADS) --runs=$(BENCH_HARNESS_RUNS) > $(BENCH_HARNESS_DIR)/results.txt \
+	  || echo "[fail] $(BENCH_HARNESS_TOOL)"
+	@cat $(BENCH_HARNESS_DIR)/results.txt
+
 #---------------------------------------------------------------------------------------------------
 # Coverage (only available with gcov/lcov using linux g++)
 #---------------------------------------------------------------------------------------------------
@@ -145,5 +307,9 @@ show-vars:
 	@echo "TEST_BINARIES_SOURCES='$(TEST_BINARIES_SOURCES)'"
 	@echo "TEST_BINARIES='$(TEST_BINARIES)'"
 	@echo "TEST_BINARIES_RESULTS='$(TEST_BINARIES_RESULTS)'"
+	@echo "TEST_SUMMARY='$(TEST_SUMMARY)'"
+	@echo "TEST_RUN_ENV='$(TEST_RUN_ENV)'"
+	@echo "TOOLS_BINARIES='$(TOOLS_BINARIES)'"
+	@echo "TEST_PCH='$(TEST_PCH)'"
 
 #--